@@ -0,0 +1,294 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#include <algorithm>
+#include <limits>
+#include "aggregations.hpp"
+
+namespace yuca {
+    namespace {
+        /** Values are buffered this many times the compression before they're merged into the centroids */
+        const double BUFFER_FACTOR = 5;
+
+        /**
+         * The start of the histogram bucket of the value, buckets of negative values round down too.
+         * The lowest bucket starts at the lowest long if its real start is below it
+         */
+        long bucketLower(long value, long interval) noexcept {
+            long offset = value % interval;
+            if (offset < 0) {
+                offset += interval;
+            }
+            if (value < std::numeric_limits<long>::min() + offset) {
+                return std::numeric_limits<long>::min();
+            }
+            return value - offset;
+        }
+
+        /** The histogram bucket number of the value, value / interval rounded down */
+        long bucketNumber(long value, long interval) noexcept {
+            long quotient = value / interval;
+            if (value % interval < 0) {
+                quotient--;
+            }
+            return quotient;
+        }
+
+        /**
+         * A 128 bit two's complement sum of longs, so summing can't overflow.
+         * Kept as a long carrying the high word and an unsigned long with the low one.
+         */
+        struct WideSum {
+            long high = 0;
+            unsigned long low = 0;
+
+            void add(long value) noexcept {
+                unsigned long previous_low = low;
+                low += static_cast<unsigned long>(value);
+                if (low < previous_low) {
+                    high++;
+                }
+                if (value < 0) {
+                    high--;
+                }
+            }
+
+            /** The sum, or the closest long to it if it doesn't fit in one */
+            long saturated() const noexcept {
+                const unsigned long sign_bit = static_cast<unsigned long>(std::numeric_limits<long>::max()) + 1;
+                if (high == 0 && low < sign_bit) {
+                    return static_cast<long>(low);
+                }
+                if (high == -1 && low >= sign_bit) {
+                    return std::numeric_limits<long>::min() + static_cast<long>(low - sign_bit);
+                }
+                return high < 0 ? std::numeric_limits<long>::min() : std::numeric_limits<long>::max();
+            }
+
+            double toDouble() const noexcept {
+                return static_cast<double>(high) * 18446744073709551616.0 + static_cast<double>(low);
+            }
+        };
+    }
+
+    void TDigest::add(double value) {
+        if (total_weight == 0 || value < min) {
+            min = value;
+        }
+        if (total_weight == 0 || value > max) {
+            max = value;
+        }
+        buffer.push_back({value, 1});
+        total_weight++;
+        if (buffer.size() >= static_cast<std::size_t>(BUFFER_FACTOR * compression)) {
+            flush();
+        }
+    }
+
+    std::size_t TDigest::getCount() const noexcept {
+        return static_cast<std::size_t>(total_weight);
+    }
+
+    double TDigest::quantile(double q) const {
+        if (!buffer.empty()) {
+            TDigest merged(*this);
+            merged.flush();
+            return merged.quantile(q);
+        }
+        if (centroids.empty()) {
+            return 0;
+        }
+        if (q <= 0) {
+            return min;
+        }
+        if (q >= 1) {
+            return max;
+        }
+        // interpolates between the centers of neighbouring centroids, and out to min and max at the ends
+        double index = q * total_weight;
+        Centroid const &first = centroids.front();
+        if (index < first.weight / 2) {
+            return min + (first.mean - min) * index / (first.weight / 2);
+        }
+        double weight_before = 0;
+        for (std::size_t i = 0; i + 1 < centroids.size(); i++) {
+            double left_center = weight_before + centroids[i].weight / 2;
+            double right_center = weight_before + centroids[i].weight + centroids[i + 1].weight / 2;
+            if (index <= right_center) {
+                double t = (index - left_center) / (right_center - left_center);
+                return centroids[i].mean + t * (centroids[i + 1].mean - centroids[i].mean);
+            }
+            weight_before += centroids[i].weight;
+        }
+        Centroid const &last = centroids.back();
+        double last_center = total_weight - last.weight / 2;
+        return last.mean + (max - last.mean) * std::min(1.0, (index - last_center) / (last.weight / 2));
+    }
+
+    void TDigest::flush() {
+        if (buffer.empty()) {
+            return;
+        }
+        buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+        std::sort(buffer.begin(), buffer.end(), [](Centroid const &a, Centroid const &b) {
+            return a.mean < b.mean;
+        });
+        centroids.clear();
+        Centroid current = buffer[0];
+        double weight_before = 0;
+        for (std::size_t i = 1; i < buffer.size(); i++) {
+            // a centroid may hold about 4 * n * q * (1 - q) / compression values, fewer towards the tails
+            double merged_weight = current.weight + buffer[i].weight;
+            double q_left = weight_before / total_weight;
+            double q_right = (weight_before + merged_weight) / total_weight;
+            double limit = 4 * total_weight * std::min(q_left * (1 - q_left), q_right * (1 - q_right)) / compression;
+            if (merged_weight <= limit) {
+                current.mean += (buffer[i].mean - current.mean) * buffer[i].weight / merged_weight;
+                current.weight = merged_weight;
+            } else {
+                weight_before += current.weight;
+                centroids.push_back(current);
+                current = buffer[i];
+            }
+        }
+        centroids.push_back(current);
+        buffer.clear();
+    }
+
+    bool TDigest::operator==(const TDigest &other) const {
+        return compression == other.compression && total_weight == other.total_weight && min == other.min &&
+               max == other.max && centroids == other.centroids && buffer == other.buffer;
+    }
+
+    double NumericAggregation::percentile(double percent) const {
+        return digest.quantile(percent / 100);
+    }
+
+    bool NumericAggregation::operator==(const NumericAggregation &other) const {
+        return property == other.property && count == other.count && min == other.min && max == other.max &&
+               sum == other.sum && average == other.average &&
+               histogram.getStdVector() == other.histogram.getStdVector() && digest == other.digest;
+    }
+
+    namespace aggregations {
+        NumericAggregation aggregate(ColumnStore const &columns,
+                                     std::string const &property,
+                                     DocBitmap const &matches,
+                                     long histogram_interval) {
+            NumericAggregation aggregation;
+            aggregation.property = property;
+            aggregation.count = 0;
+            aggregation.min = 0;
+            aggregation.max = 0;
+            aggregation.sum = 0;
+            aggregation.average = 0;
+            PropertyId property_id = columns.findProperty(property);
+            if (property_id == ColumnStore::NO_PROPERTY) {
+                return aggregation;
+            }
+            PropertyColumn<long> const *long_column = columns.longColumn(property_id);
+            PropertyColumn<int> const *int_column = columns.intColumn(property_id);
+
+            // gather the values of the matches that have one
+            std::vector<DocOrdinal> ordinals;
+            std::vector<long> values;
+            if (long_column->getValueCount() > 0) {
+                DocBitmap with_long = matches;
+                with_long.andWith(long_column->getPresence());
+                with_long.toOrdinals(ordinals);
+                std::vector<long> const &long_values = long_column->getValues();
+                for (DocOrdinal ordinal : ordinals) {
+                    values.push_back(long_values[ordinal]);
+                }
+            }
+            if (int_column->getValueCount() > 0) {
+                DocBitmap with_int = matches;
+                with_int.andWith(int_column->getPresence());
+                with_int.andNot(long_column->getPresence());
+                ordinals.clear();
+                with_int.toOrdinals(ordinals);
+                std::vector<int> const &int_values = int_column->getValues();
+                for (DocOrdinal ordinal : ordinals) {
+                    values.push_back(int_values[ordinal]);
+                }
+            }
+            if (values.empty()) {
+                return aggregation;
+            }
+
+            long min = values[0];
+            long max = values[0];
+            WideSum sum;
+            for (long value : values) {
+                min = std::min(min, value);
+                max = std::max(max, value);
+                sum.add(value);
+            }
+            aggregation.count = values.size();
+            aggregation.min = min;
+            aggregation.max = max;
+            aggregation.sum = sum.saturated();
+            aggregation.average = sum.toDouble() / static_cast<double>(values.size());
+            if (histogram_interval > 0) {
+                long first_bucket = bucketNumber(min, histogram_interval);
+                // the difference of two bucket numbers always fits in an unsigned long
+                unsigned long span = static_cast<unsigned long>(bucketNumber(max, histogram_interval)) -
+                                     static_cast<unsigned long>(first_bucket);
+                if (span < 4 * values.size()) {
+                    std::vector<HistogramBucket> buckets(span + 1, HistogramBucket{0, 0});
+                    for (long value : values) {
+                        HistogramBucket &bucket = buckets[static_cast<unsigned long>(
+                                bucketNumber(value, histogram_interval)) - static_cast<unsigned long>(first_bucket)];
+                        bucket.lower = bucketLower(value, histogram_interval);
+                        bucket.document_count++;
+                    }
+                    for (auto const &bucket : buckets) {
+                        if (bucket.document_count > 0) {
+                            aggregation.histogram.add(bucket);
+                        }
+                    }
+                } else {
+                    // too sparse for a bucket per interval, the sorted values give the buckets in order instead
+                    std::vector<long> sorted(values);
+                    std::sort(sorted.begin(), sorted.end());
+                    for (long value : sorted) {
+                        long lower = bucketLower(value, histogram_interval);
+                        if (aggregation.histogram.isEmpty() ||
+                            aggregation.histogram.getStdVector().back().lower != lower) {
+                            aggregation.histogram.add({lower, 0});
+                        }
+                        aggregation.histogram.getStdVector().back().document_count++;
+                    }
+                }
+            }
+            for (long value : values) {
+                aggregation.digest.add(static_cast<double>(value));
+            }
+            aggregation.digest.flush();
+            return aggregation;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+//
+// Aggregations of the numeric properties of the documents that match a query.
+//
+// The matches' bitmap is ANDed word by word with the presence bitmaps of the property's long and int columns,
+// the values of the ordinals left are gathered into one contiguous array, and min, max, sum, the histogram
+// and the t-digest are computed in tight loops over it.
+//
+
+#ifndef YUCA_AGGREGATIONS_HPP
+#define YUCA_AGGREGATIONS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "columns.hpp"
+#include "postings.hpp"
+#include "utils.hpp"
+
+namespace yuca {
+    /**
+     * A sketch of a distribution that answers quantiles in bounded memory, a merging t-digest (Dunning).
+     * Values are clustered in centroids that are smaller towards the tails, so extreme quantiles stay accurate.
+     */
+    class TDigest {
+    public:
+        /** @param a_compression about how many centroids are kept, more is more accurate */
+        explicit TDigest(double a_compression = 100) :
+        compression(a_compression),
+        total_weight(0),
+        min(0),
+        max(0) {
+        }
+
+        void add(double value);
+
+        /** Number of values added */
+        std::size_t getCount() const noexcept;
+
+        /**
+         * Merges the buffered values into the centroids. quantile() doesn't change the digest, it works on a
+         * merged copy while values are buffered, so call this once they've all been added
+         */
+        void flush();
+
+        /** The value below which the given fraction, in [0, 1], of the values fall. 0 if there are none */
+        double quantile(double q) const;
+
+        /** Same values, merged the same way */
+        bool operator==(const TDigest &other) const;
+
+    private:
+        struct Centroid {
+            double mean;
+            double weight;
+
+            bool operator==(const Centroid &other) const {
+                return mean == other.mean && weight == other.weight;
+            }
+        };
+
+        double compression;
+
+        std::vector<Centroid> centroids;
+
+        // added since the last flush()
+        std::vector<Centroid> buffer;
+
+        double total_weight;
+
+        double min;
+
+        double max;
+    };
+
+    /** A bucket of a histogram, the documents whose value is in [lower, lower + interval) */
+    struct HistogramBucket {
+        long lower;
+        std::size_t document_count;
+
+        bool operator==(const HistogramBucket &other) const {
+            return lower == other.lower && document_count == other.document_count;
+        }
+    };
+
+    /** The long, or else int, values of a property over the matches of a query, see Indexer::aggregate() */
+    struct NumericAggregation {
+        std::string property;
+        std::size_t count; // matches with a value, the others are left out
+        long min;
+        long max;
+        long sum; // saturates at the bounds of a long
+        double average;
+        yuca::utils::List<HistogramBucket> histogram; // non empty buckets in increasing order
+        TDigest digest;
+
+        /** The value below which the given percent, in [0, 100], of the values fall, estimated by the digest */
+        double percentile(double percent) const;
+
+        bool operator==(const NumericAggregation &other) const;
+    };
+
+    namespace aggregations {
+        /**
+         * Aggregates the property's values of the matches, longs taking precedence over ints.
+         * @param histogram_interval width of the histogram's buckets, no histogram if it's <= 0
+         */
+        NumericAggregation aggregate(ColumnStore const &columns,
+                                     std::string const &property,
+                                     DocBitmap const &matches,
+                                     long histogram_interval);
+    }
+}
+
+#endif //YUCA_AGGREGATIONS_HPP
@@ -0,0 +1,151 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cache.hpp"
+
+namespace yuca {
+    ResultCache::ResultCache(ResultCache const &other) : capacity(0), hits(0), misses(0) {
+        *this = other;
+    }
+
+    ResultCache::ResultCache(ResultCache &&other) : capacity(0), hits(0), misses(0) {
+        *this = std::move(other);
+    }
+
+    ResultCache &ResultCache::operator=(ResultCache const &other) {
+        if (this == &other) {
+            return *this;
+        }
+        std::lock(mutex, other.mutex);
+        std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
+        std::lock_guard<std::mutex> other_lock(other.mutex, std::adopt_lock);
+        capacity = other.capacity;
+        entries = other.entries;
+        // the other cache's index points into its own list
+        index.clear();
+        for (auto entry_it = entries.begin(); entry_it != entries.end(); ++entry_it) {
+            index.emplace(entry_it->first, entry_it);
+        }
+        hits = other.hits;
+        misses = other.misses;
+        return *this;
+    }
+
+    ResultCache &ResultCache::operator=(ResultCache &&other) {
+        if (this == &other) {
+            return *this;
+        }
+        std::lock(mutex, other.mutex);
+        std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
+        std::lock_guard<std::mutex> other_lock(other.mutex, std::adopt_lock);
+        capacity = other.capacity;
+        // moved list nodes stay where they are, the index still points at them
+        entries = std::move(other.entries);
+        index = std::move(other.index);
+        other.entries.clear();
+        other.index.clear();
+        hits = other.hits;
+        misses = other.misses;
+        return *this;
+    }
+
+    void ResultCache::setCapacity(std::size_t a_capacity) {
+        std::lock_guard<std::mutex> lock(mutex);
+        capacity = a_capacity;
+        evict();
+    }
+
+    std::size_t ResultCache::getCapacity() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex);
+        return capacity;
+    }
+
+    bool ResultCache::isEnabled() const noexcept {
+        return getCapacity() > 0;
+    }
+
+    std::size_t ResultCache::size() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index.size();
+    }
+
+    bool ResultCache::get(std::string const &key, std::function<bool(Entry const &)> const &is_valid,
+                          Entry &entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto index_it = index.find(key);
+        if (index_it == index.end()) {
+            misses++;
+            return false;
+        }
+        if (!is_valid(index_it->second->second)) {
+            entries.erase(index_it->second);
+            index.erase(index_it);
+            misses++;
+            return false;
+        }
+        entries.splice(entries.begin(), entries, index_it->second);
+        hits++;
+        entry = entries.front().second;
+        return true;
+    }
+
+    void ResultCache::put(std::string const &key, Entry entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (capacity == 0) {
+            return;
+        }
+        auto index_it = index.find(key);
+        if (index_it != index.end()) {
+            index_it->second->second = std::move(entry);
+            entries.splice(entries.begin(), entries, index_it->second);
+            return;
+        }
+        entries.emplace_front(key, std::move(entry));
+        index[key] = entries.begin();
+        evict();
+    }
+
+    void ResultCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        index.clear();
+    }
+
+    unsigned long ResultCache::getHits() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hits;
+    }
+
+    unsigned long ResultCache::getMisses() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex);
+        return misses;
+    }
+
+    void ResultCache::evict() {
+        while (index.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Search result cache.
+//
+// Entries remember the generation of every group (ReverseIndex) their query looked at.
+// ReverseIndex generations change on every mutation, so an entry is only served while
+// none of the groups it depends on changed, indexing under other groups doesn't evict it.
+//
+// Searches are const but they read and fill the cache, so it guards itself with a mutex and hands out
+// copies of its entries, concurrent searches can share it.
+//
+
+#ifndef YUCA_CACHE_HPP
+#define YUCA_CACHE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "postings.hpp"
+
+namespace yuca {
+    /** LRU cache of ranked search results, by normalized query. Safe to use from many threads */
+    class ResultCache {
+    public:
+        /** The generation a group had when the results were cached, 0 if it had no ReverseIndex */
+        struct Dependency {
+            std::string group;
+            long group_id;
+            std::uint64_t generation;
+        };
+
+        struct Entry {
+            std::vector<Dependency> dependencies;
+            // queries with -excluded only clauses match against every document, not just their groups
+            bool depends_on_all_documents;
+            std::uint64_t documents_generation;
+            // ranked results
+            std::vector<DocOrdinal> ordinals;
+            std::vector<double> scores;
+        };
+
+        explicit ResultCache(std::size_t a_capacity = 0) : capacity(a_capacity), hits(0), misses(0) {
+        }
+
+        /** Copies and moves take the other cache's entries, each cache keeps its own mutex */
+        ResultCache(ResultCache const &other);
+
+        ResultCache(ResultCache &&other);
+
+        ResultCache &operator=(ResultCache const &other);
+
+        ResultCache &operator=(ResultCache &&other);
+
+        /** 0 disables the cache. Shrinking evicts the least recently used entries */
+        void setCapacity(std::size_t a_capacity);
+
+        std::size_t getCapacity() const noexcept;
+
+        bool isEnabled() const noexcept;
+
+        std::size_t size() const noexcept;
+
+        /**
+         * Copies the entry under the key if there's one and is_valid() says it's still good, false otherwise.
+         * Invalid entries are dropped. is_valid() is called with the cache locked.
+         */
+        bool get(std::string const &key, std::function<bool(Entry const &)> const &is_valid, Entry &entry);
+
+        void put(std::string const &key, Entry entry);
+
+        void clear();
+
+        unsigned long getHits() const noexcept;
+
+        unsigned long getMisses() const noexcept;
+
+    private:
+        typedef std::list<std::pair<std::string, Entry>> EntryList;
+
+        /** Call with the mutex held */
+        void evict();
+
+        mutable std::mutex mutex;
+
+        std::size_t capacity;
+
+        // most recently used first
+        EntryList entries;
+
+        std::unordered_map<std::string, EntryList::iterator> index;
+
+        unsigned long hits;
+
+        unsigned long misses;
+    };
+}
+
+#endif //YUCA_CACHE_HPP
@@ -0,0 +1,176 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "columns.hpp"
+
+namespace yuca {
+    const PropertyId ColumnStore::NO_PROPERTY;
+
+    namespace {
+        template <class T>
+        PropertyColumn<T> const *columnAt(std::vector<PropertyColumn<T>> const &columns, PropertyId property) noexcept {
+            return property < columns.size() ? &columns[property] : nullptr;
+        }
+    }
+
+    PropertyId ColumnStore::findProperty(std::string const &name) const noexcept {
+        std::uint32_t name_id = PropertyNames::find(name);
+        if (name_id == PropertyNames::NO_NAME) {
+            return NO_PROPERTY;
+        }
+        auto id_it = property_ids.find(name_id);
+        return id_it == property_ids.end() ? NO_PROPERTY : id_it->second;
+    }
+
+    std::string const &ColumnStore::getPropertyName(PropertyId property) const {
+        return PropertyNames::getName(name_ids.at(property));
+    }
+
+    std::size_t ColumnStore::getPropertyCount() const noexcept {
+        return name_ids.size();
+    }
+
+    PropertyColumn<bool> const *ColumnStore::boolColumn(PropertyId property) const noexcept {
+        return columnAt(bool_columns, property);
+    }
+
+    PropertyColumn<char> const *ColumnStore::byteColumn(PropertyId property) const noexcept {
+        return columnAt(byte_columns, property);
+    }
+
+    PropertyColumn<int> const *ColumnStore::intColumn(PropertyId property) const noexcept {
+        return columnAt(int_columns, property);
+    }
+
+    PropertyColumn<long> const *ColumnStore::longColumn(PropertyId property) const noexcept {
+        return columnAt(long_columns, property);
+    }
+
+    PropertyColumn<std::string> const *ColumnStore::stringColumn(PropertyId property) const noexcept {
+        return columnAt(string_columns, property);
+    }
+
+    DocBitmap const *ColumnStore::trueBitmap(PropertyId property) const noexcept {
+        return property < true_bitmaps.size() ? &true_bitmaps[property] : nullptr;
+    }
+
+    DocBitmap const *ColumnStore::byteValueBitmap(PropertyId property, char value) const noexcept {
+        if (property >= byte_value_bitmaps.size()) {
+            return nullptr;
+        }
+        auto bitmap_it = byte_value_bitmaps[property].find(value);
+        return bitmap_it == byte_value_bitmaps[property].end() ? nullptr : &bitmap_it->second;
+    }
+
+    void ColumnStore::putDocument(DocOrdinal ordinal, Document const &doc) {
+        removeDocument(ordinal);
+        if (ordinal >= ordinal_properties.size()) {
+            ordinal_properties.resize(static_cast<std::size_t>(ordinal) + 1);
+        }
+        std::vector<PropertyId> &properties = ordinal_properties[ordinal];
+        // the entries are sorted by name id, a name with values of several types comes in a row
+        std::uint32_t previous_name_id = PropertyNames::NO_NAME;
+        PropertyId property = NO_PROPERTY;
+        for (auto const &entry : doc.properties) {
+            if (entry.name_id != previous_name_id) {
+                previous_name_id = entry.name_id;
+                property = addProperty(entry.name_id);
+                properties.push_back(property);
+            }
+            switch (entry.type) {
+                case BOOL:
+                    bool_columns[property].set(ordinal, entry.value != 0);
+                    if (entry.value != 0) {
+                        true_bitmaps[property].set(ordinal);
+                    }
+                    break;
+                case BYTE:
+                    byte_columns[property].set(ordinal, static_cast<char>(entry.value));
+                    byte_value_bitmaps[property][static_cast<char>(entry.value)].set(ordinal);
+                    break;
+                case INT:
+                    int_columns[property].set(ordinal, static_cast<int>(entry.value));
+                    break;
+                case LONG:
+                    long_columns[property].set(ordinal, entry.value);
+                    break;
+                case STRING:
+                    string_columns[property].set(ordinal, doc.string_arena.substr(static_cast<std::size_t>(entry.value),
+                                                                                  entry.string_length));
+                    break;
+            }
+        }
+    }
+
+    void ColumnStore::removeDocument(DocOrdinal ordinal) {
+        if (ordinal >= ordinal_properties.size()) {
+            return;
+        }
+        for (PropertyId property : ordinal_properties[ordinal]) {
+            true_bitmaps[property].unset(ordinal);
+            if (byte_columns[property].hasValue(ordinal)) {
+                byte_value_bitmaps[property][byte_columns[property].get(ordinal)].unset(ordinal);
+            }
+            bool_columns[property].reset(ordinal);
+            byte_columns[property].reset(ordinal);
+            int_columns[property].reset(ordinal);
+            long_columns[property].reset(ordinal);
+            string_columns[property].reset(ordinal);
+        }
+        std::vector<PropertyId>().swap(ordinal_properties[ordinal]);
+    }
+
+    void ColumnStore::clear() {
+        property_ids.clear();
+        name_ids.clear();
+        bool_columns.clear();
+        byte_columns.clear();
+        int_columns.clear();
+        long_columns.clear();
+        string_columns.clear();
+        true_bitmaps.clear();
+        byte_value_bitmaps.clear();
+        ordinal_properties.clear();
+    }
+
+    PropertyId ColumnStore::addProperty(std::uint32_t name_id) {
+        auto id_it = property_ids.find(name_id);
+        if (id_it != property_ids.end()) {
+            return id_it->second;
+        }
+        auto property = static_cast<PropertyId>(name_ids.size());
+        property_ids.emplace(name_id, property);
+        name_ids.push_back(name_id);
+        // the same null values Document returns for missing properties
+        bool_columns.emplace_back(false);
+        byte_columns.emplace_back(0);
+        int_columns.emplace_back(-1);
+        long_columns.emplace_back(-1l);
+        string_columns.emplace_back("");
+        true_bitmaps.emplace_back();
+        byte_value_bitmaps.emplace_back();
+        return property;
+    }
+}
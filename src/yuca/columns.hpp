@@ -0,0 +1,192 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+//
+// Columnar copy of the properties of the indexed documents.
+//
+// Each property name the store's documents have had gets a small dense id, found from the id Documents intern
+// the name to, see PropertyNames, so a document's entries are copied in without hashing their names.
+// Every (name, type) pair gets a column, a vector
+// of values indexed by document ordinal and a bitmap of the ordinals that have a value, so reading one
+// property across many documents is a linear scan over contiguous memory instead of a string keyed tree
+// lookup per document.
+//
+// Bool and byte properties also keep bitmaps of the ordinals holding each of their values, so that filtering
+// on them is a word by word AND.
+//
+
+#ifndef YUCA_COLUMNS_HPP
+#define YUCA_COLUMNS_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "document.hpp"
+#include "postings.hpp"
+
+namespace yuca {
+    typedef std::uint32_t PropertyId;
+
+    /** The values of one property of one type, by document ordinal */
+    template <class T>
+    class PropertyColumn {
+    public:
+        /** @param a_null_value what documents without a value read as, the same default Document returns */
+        explicit PropertyColumn(T const &a_null_value) : null_value(a_null_value), value_count(0) {
+        }
+
+        bool hasValue(DocOrdinal ordinal) const noexcept {
+            return present.test(ordinal);
+        }
+
+        /** The document's value, the null value if it has none */
+        typename std::vector<T>::const_reference get(DocOrdinal ordinal) const noexcept {
+            return ordinal < values.size() ? values[ordinal] : null_value;
+        }
+
+        void set(DocOrdinal ordinal, T const &value) {
+            if (ordinal >= values.size()) {
+                values.resize(static_cast<std::size_t>(ordinal) + 1, null_value);
+            }
+            values[ordinal] = value;
+            if (!present.test(ordinal)) {
+                present.set(ordinal);
+                value_count++;
+            }
+        }
+
+        void reset(DocOrdinal ordinal) {
+            if (!present.test(ordinal)) {
+                return;
+            }
+            values[ordinal] = null_value;
+            present.unset(ordinal);
+            value_count--;
+        }
+
+        /** Number of documents with a value */
+        std::size_t getValueCount() const noexcept {
+            return value_count;
+        }
+
+        /** Values by ordinal, documents without one hold the null value. It can be shorter than the ordinal space */
+        std::vector<T> const &getValues() const noexcept {
+            return values;
+        }
+
+        /** The null bitmap, set for the ordinals that have a value */
+        DocBitmap const &getPresence() const noexcept {
+            return present;
+        }
+
+        T const &getNullValue() const noexcept {
+            return null_value;
+        }
+
+        void clear() {
+            std::vector<T>().swap(values);
+            present.clear();
+            value_count = 0;
+        }
+
+    private:
+        std::vector<T> values;
+
+        DocBitmap present;
+
+        T null_value;
+
+        std::size_t value_count;
+    };
+
+    /** The properties of the indexed documents, one PropertyColumn per interned property name and type */
+    class ColumnStore {
+    public:
+        static const PropertyId NO_PROPERTY = 0xffffffff;
+
+        /** Id of an interned property name, NO_PROPERTY if no document indexed has had it */
+        PropertyId findProperty(std::string const &name) const noexcept;
+
+        std::string const &getPropertyName(PropertyId property) const;
+
+        /** Number of property names the documents put have had */
+        std::size_t getPropertyCount() const noexcept;
+
+        /** Column of the property's values of the given type, nullptr for NO_PROPERTY */
+        PropertyColumn<bool> const *boolColumn(PropertyId property) const noexcept;
+
+        PropertyColumn<char> const *byteColumn(PropertyId property) const noexcept;
+
+        PropertyColumn<int> const *intColumn(PropertyId property) const noexcept;
+
+        PropertyColumn<long> const *longColumn(PropertyId property) const noexcept;
+
+        PropertyColumn<std::string> const *stringColumn(PropertyId property) const noexcept;
+
+        /**
+         * Ordinals whose bool property is true, nullptr for NO_PROPERTY.
+         * The ones whose property is false are the bool column's presence minus these.
+         */
+        DocBitmap const *trueBitmap(PropertyId property) const noexcept;
+
+        /** Ordinals whose byte property holds the value, nullptr if no document has had the value */
+        DocBitmap const *byteValueBitmap(PropertyId property, char value) const noexcept;
+
+        /** Copies the document's properties into the columns, replacing the values the ordinal had */
+        void putDocument(DocOrdinal ordinal, Document const &doc);
+
+        void removeDocument(DocOrdinal ordinal);
+
+        void clear();
+
+    private:
+        /** The property id of the name, adding its columns the first time */
+        PropertyId addProperty(std::uint32_t name_id);
+
+        // property ids by PropertyNames id, only of the names the store's documents have had
+        std::unordered_map<std::uint32_t, PropertyId> property_ids;
+
+        // PropertyNames ids by property id
+        std::vector<std::uint32_t> name_ids;
+
+        // by property id, every property has a column of each type, most of them stay empty
+        std::vector<PropertyColumn<bool>> bool_columns;
+        std::vector<PropertyColumn<char>> byte_columns;
+        std::vector<PropertyColumn<int>> int_columns;
+        std::vector<PropertyColumn<long>> long_columns;
+        std::vector<PropertyColumn<std::string>> string_columns;
+
+        // by property id
+        std::vector<DocBitmap> true_bitmaps;
+        std::vector<std::map<char, DocBitmap>> byte_value_bitmaps;
+
+        // by ordinal, the properties the document has values of, so removing it doesn't visit every column
+        std::vector<std::vector<PropertyId>> ordinal_properties;
+    };
+}
+
+#endif //YUCA_COLUMNS_HPP
@@ -0,0 +1,163 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <queue>
+#include "completion.hpp"
+
+namespace yuca {
+    const std::uint32_t CompletionTrie::NO_NODE;
+
+    void CompletionTrie::setWeight(yuca::utils::StringView keyword, std::size_t weight) {
+        // nodes from the root to the keyword's node
+        std::vector<std::uint32_t> path;
+        path.reserve(keyword.size() + 1);
+        path.push_back(0);
+        for (char c : keyword) {
+            std::uint32_t child = findChild(path.back(), c);
+            if (child == NO_NODE) {
+                if (weight == 0) {
+                    return;
+                }
+                child = newNode();
+                auto &children = nodes[path.back()].children;
+                children.insert(std::lower_bound(children.begin(), children.end(), std::make_pair(c, std::uint32_t(0))),
+                                std::make_pair(c, child));
+            }
+            path.push_back(child);
+        }
+        nodes[path.back()].weight = weight;
+
+        // fix the max weights on the way up, dropping the nodes that no longer lead to any keyword
+        for (std::size_t i = path.size(); i-- > 0;) {
+            Node &node = nodes[path[i]];
+            if (i > 0 && node.weight == 0 && node.children.empty()) {
+                auto &siblings = nodes[path[i - 1]].children;
+                char c = keyword[i - 1];
+                siblings.erase(std::lower_bound(siblings.begin(), siblings.end(), std::make_pair(c, std::uint32_t(0))));
+                node.max_weight = 0;
+                freeNodes.push_back(path[i]);
+                continue;
+            }
+            std::size_t max_weight = node.weight;
+            for (auto const &child : node.children) {
+                max_weight = std::max(max_weight, nodes[child.second].max_weight);
+            }
+            node.max_weight = max_weight;
+        }
+    }
+
+    std::size_t CompletionTrie::getWeight(yuca::utils::StringView keyword) const noexcept {
+        std::uint32_t node_index = findNode(keyword);
+        return node_index == NO_NODE ? 0 : nodes[node_index].weight;
+    }
+
+    namespace {
+        /** A keyword found, or a subtree still to be looked at */
+        struct Candidate {
+            std::size_t weight;
+            std::string text;
+            std::uint32_t node;
+            bool is_keyword;
+        };
+
+        /** std::priority_queue pops the largest, heaviest first, then in string order, keywords before subtrees */
+        struct CandidateOrder {
+            bool operator()(Candidate const &a, Candidate const &b) const {
+                if (a.weight != b.weight) {
+                    return a.weight < b.weight;
+                }
+                int order = a.text.compare(b.text);
+                if (order != 0) {
+                    return order > 0;
+                }
+                return !a.is_keyword && b.is_keyword;
+            }
+        };
+    }
+
+    std::vector<Completion> CompletionTrie::complete(yuca::utils::StringView prefix,
+                                                     std::size_t max_completions) const {
+        std::vector<Completion> completions;
+        std::uint32_t prefix_node = findNode(prefix);
+        if (prefix_node == NO_NODE || max_completions == 0 || nodes[prefix_node].max_weight == 0) {
+            return completions;
+        }
+        // a subtree's keywords are never lighter than its max weight says nor sort before its own text,
+        // so when a keyword comes out of the queue nothing left can go ahead of it
+        std::priority_queue<Candidate, std::vector<Candidate>, CandidateOrder> queue;
+        queue.push(Candidate{nodes[prefix_node].max_weight, prefix.toString(), prefix_node, false});
+        while (!queue.empty() && completions.size() < max_completions) {
+            Candidate candidate = queue.top();
+            queue.pop();
+            if (candidate.is_keyword) {
+                completions.push_back(Completion{std::move(candidate.text), candidate.weight});
+                continue;
+            }
+            Node const &node = nodes[candidate.node];
+            if (node.weight > 0) {
+                queue.push(Candidate{node.weight, candidate.text, candidate.node, true});
+            }
+            for (auto const &child : node.children) {
+                queue.push(Candidate{nodes[child.second].max_weight, candidate.text + child.first, child.second,
+                                     false});
+            }
+        }
+        return completions;
+    }
+
+    void CompletionTrie::clear() {
+        nodes.assign(1, Node());
+        freeNodes.clear();
+    }
+
+    std::uint32_t CompletionTrie::findChild(std::uint32_t node_index, char c) const noexcept {
+        auto const &children = nodes[node_index].children;
+        auto child_it = std::lower_bound(children.begin(), children.end(), std::make_pair(c, std::uint32_t(0)));
+        return child_it != children.end() && child_it->first == c ? child_it->second : NO_NODE;
+    }
+
+    std::uint32_t CompletionTrie::findNode(yuca::utils::StringView keyword) const noexcept {
+        std::uint32_t node_index = 0;
+        for (char c : keyword) {
+            node_index = findChild(node_index, c);
+            if (node_index == NO_NODE) {
+                break;
+            }
+        }
+        return node_index;
+    }
+
+    std::uint32_t CompletionTrie::newNode() {
+        if (!freeNodes.empty()) {
+            std::uint32_t node_index = freeNodes.back();
+            freeNodes.pop_back();
+            nodes[node_index] = Node();
+            return node_index;
+        }
+        nodes.emplace_back();
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+}
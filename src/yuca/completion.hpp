@@ -0,0 +1,111 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Type-ahead completions and spelling suggestions.
+//
+// Each group keeps its keys in a trie where every node knows the largest weight (the number of
+// documents of a key) found under it. The best completions of a prefix are then found best first,
+// only following the subtrees that can still beat what's been found, without looking at any postings.
+// Suggestions come from the keys within a few edits of a keyword, see ReverseIndex::findFuzzyKeys().
+//
+
+#ifndef YUCA_COMPLETION_HPP
+#define YUCA_COMPLETION_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "utils.hpp"
+
+namespace yuca {
+    struct Completion {
+        std::string keyword;
+        std::size_t document_count;
+
+        bool operator==(const Completion &other) const {
+            return keyword == other.keyword && document_count == other.document_count;
+        }
+    };
+
+    /** A correction of a query keyword, see Indexer::suggest() */
+    struct Suggestion {
+        std::string group;
+        std::string keyword; // as it is in the query
+        std::string suggestion;
+        std::uint32_t edits;
+        std::size_t document_count;
+
+        bool operator==(const Suggestion &other) const {
+            return group == other.group && keyword == other.keyword && suggestion == other.suggestion &&
+                   edits == other.edits && document_count == other.document_count;
+        }
+    };
+
+    /** Keywords and their weights, in a trie that remembers the largest weight of every subtree */
+    class CompletionTrie {
+    public:
+        CompletionTrie() : nodes(1) {
+        }
+
+        /** Sets the keyword's weight, a weight of 0 removes it. Costs O(keyword length * alphabet) */
+        void setWeight(yuca::utils::StringView keyword, std::size_t weight);
+
+        std::size_t getWeight(yuca::utils::StringView keyword) const noexcept;
+
+        /**
+         * Up to max_completions keywords that start with the prefix, heaviest first, ties in string order.
+         * Costs O(prefix length + max_completions * alphabet * log(max_completions * alphabet)).
+         */
+        std::vector<Completion> complete(yuca::utils::StringView prefix, std::size_t max_completions) const;
+
+        void clear();
+
+    private:
+        struct Node {
+            // sorted by character
+            std::vector<std::pair<char, std::uint32_t>> children;
+            // weight of the keyword that ends here, 0 if none does
+            std::size_t weight = 0;
+            // largest weight in the subtree, this node included
+            std::size_t max_weight = 0;
+        };
+
+        static const std::uint32_t NO_NODE = 0xffffffff;
+
+        std::uint32_t findChild(std::uint32_t node_index, char c) const noexcept;
+
+        std::uint32_t findNode(yuca::utils::StringView keyword) const noexcept;
+
+        std::uint32_t newNode();
+
+        // nodes[0] is the root
+        std::vector<Node> nodes;
+
+        // nodes of removed keywords, reused before the vector grows
+        std::vector<std::uint32_t> freeNodes;
+    };
+}
+
+#endif //YUCA_COMPLETION_HPP
@@ -26,10 +26,109 @@
 // Created by gubatron on 11/9/17.
 //
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include "document.hpp"
 
 namespace yuca {
+    const std::uint32_t PropertyNames::NO_NAME;
+
+    namespace {
+        /** Slots of the first table of property names */
+        const std::size_t INITIAL_PROPERTY_NAMES_CAPACITY = 64;
+    }
+
+    PropertyNames::Table::Table(std::size_t a_capacity) :
+    capacity(a_capacity),
+    slots(new std::atomic<Name const *>[a_capacity]),
+    by_id(new std::atomic<Name const *>[a_capacity / 2]) {
+        for (std::size_t i = 0; i < capacity; i++) {
+            slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < capacity / 2; i++) {
+            by_id[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    PropertyNames::PropertyNames() {
+        tables.emplace_back(new Table(INITIAL_PROPERTY_NAMES_CAPACITY));
+        table.store(tables.back().get(), std::memory_order_release);
+    }
+
+    std::uint32_t PropertyNames::intern(std::string const &name) {
+        PropertyNames &property_names = instance();
+        std::size_t hash = std::hash<std::string>()(name);
+        Name const *found = lookup(*property_names.table.load(std::memory_order_acquire), name, hash);
+        if (found != nullptr) {
+            return found->id;
+        }
+        std::lock_guard<std::mutex> lock(property_names.mutex);
+        Table *current = property_names.table.load(std::memory_order_relaxed);
+        // another thread could have added it since
+        found = lookup(*current, name, hash);
+        if (found != nullptr) {
+            return found->id;
+        }
+        auto name_id = static_cast<std::uint32_t>(property_names.names.size());
+        property_names.names.push_back(Name{name, hash, name_id});
+        if (property_names.names.size() <= current->capacity / 2) {
+            insert(*current, &property_names.names.back());
+            return name_id;
+        }
+        // readers stay on the old table until the new one has every name
+        std::unique_ptr<Table> grown(new Table(current->capacity * 2));
+        for (auto const &property_name : property_names.names) {
+            insert(*grown, &property_name);
+        }
+        property_names.tables.push_back(std::move(grown));
+        property_names.table.store(property_names.tables.back().get(), std::memory_order_release);
+        return name_id;
+    }
+
+    std::uint32_t PropertyNames::find(std::string const &name) {
+        Name const *found = lookup(*instance().table.load(std::memory_order_acquire), name,
+                                   std::hash<std::string>()(name));
+        return found == nullptr ? NO_NAME : found->id;
+    }
+
+    std::string const &PropertyNames::getName(std::uint32_t name_id) {
+        Table const *current = instance().table.load(std::memory_order_acquire);
+        Name const *name = name_id < current->capacity / 2 ? current->by_id[name_id].load(std::memory_order_acquire) :
+                           nullptr;
+        if (name == nullptr) {
+            throw std::out_of_range("PropertyNames::getName: no name has id " + std::to_string(name_id));
+        }
+        return name->text;
+    }
+
+    PropertyNames &PropertyNames::instance() {
+        // never destroyed, Documents can outlive static destruction order
+        static PropertyNames *property_names = new PropertyNames();
+        return *property_names;
+    }
+
+    PropertyNames::Name const *PropertyNames::lookup(Table const &table, std::string const &name,
+                                                     std::size_t hash) noexcept {
+        std::size_t mask = table.capacity - 1;
+        for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            Name const *entry = table.slots[slot].load(std::memory_order_acquire);
+            if (entry == nullptr || (entry->hash == hash && entry->text == name)) {
+                return entry;
+            }
+        }
+    }
+
+    void PropertyNames::insert(Table &table, Name const *name) noexcept {
+        table.by_id[name->id].store(name, std::memory_order_release);
+        std::size_t mask = table.capacity - 1;
+        std::size_t slot = name->hash & mask;
+        while (table.slots[slot].load(std::memory_order_relaxed) != nullptr) {
+            slot = (slot + 1) & mask;
+        }
+        table.slots[slot].store(name, std::memory_order_release);
+    }
+
     const Document Document::NULL_DOCUMENT(-1);
 
     std::set<std::string> Document::getGroups() const {
@@ -75,6 +174,18 @@ namespace yuca {
         group_2_keyset_map.put(group, key_set);
     }
 
+    void Document::addKeySequence(std::string const &group, yuca::utils::List<std::string> const &keywords) {
+        auto &sequence = group_2_key_sequence_map.getStdMap()[group];
+        for (auto const &keyword : keywords.getStdVector()) {
+            addKey(std::make_shared<StringKey>(keyword, group));
+            sequence.add(keyword);
+        }
+    }
+
+    yuca::utils::List<std::string> Document::getKeySequence(std::string const &group) const {
+        return group_2_key_sequence_map.get(group);
+    }
+
     void Document::removeKey(std::string const &group, SPStringKey key) {
         if (!hasKeys(group)) {
             return;
@@ -100,82 +211,154 @@ namespace yuca {
         }
         group_2_keyset_map.get(group).clear();
         group_2_keyset_map.remove(group);
+        group_2_key_sequence_map.remove(group);
     }
 
     void Document::boolProperty(std::string const &key, bool value) {
-        bool_properties.put(key, value);
+        putProperty(key, BOOL, value ? 1 : 0);
     }
 
     bool Document::boolProperty(std::string const &key) const {
-        return bool_properties.get(key);
+        PropertyEntry const *entry = findProperty(key, BOOL);
+        return entry != nullptr && entry->value != 0;
     }
 
     void Document::removeBoolProperty(std::string const &key) {
-        bool_properties.remove(key);
+        removeProperty(key, BOOL);
     }
 
     void Document::byteProperty(std::string const &key, char value) {
-        byte_properties.put(key, value);
+        putProperty(key, BYTE, value);
     }
 
     char Document::byteProperty(std::string const &key) const {
-        return byte_properties.get(key);
+        PropertyEntry const *entry = findProperty(key, BYTE);
+        return entry == nullptr ? static_cast<char>(0) : static_cast<char>(entry->value);
     }
 
     void Document::removeByteProperty(std::string const &key) {
-        byte_properties.remove(key);
+        removeProperty(key, BYTE);
     }
 
     void Document::intProperty(std::string const &key, int value) {
-        int_properties.put(key, value);
+        putProperty(key, INT, value);
     }
 
     int Document::intProperty(std::string const &key) const {
-        return int_properties.get(key);
+        PropertyEntry const *entry = findProperty(key, INT);
+        return entry == nullptr ? -1 : static_cast<int>(entry->value);
     }
 
     void Document::removeIntProperty(std::string const &key) {
-        int_properties.remove(key);
+        removeProperty(key, INT);
     }
 
     void Document::longProperty(std::string const &key, long value) {
-        long_properties.put(key, value);
+        putProperty(key, LONG, value);
     }
 
     long Document::longProperty(std::string const &key) const {
-        return long_properties.get(key);
+        PropertyEntry const *entry = findProperty(key, LONG);
+        return entry == nullptr ? -1l : entry->value;
     }
 
     void Document::removeLongProperty(std::string const &key) {
-        long_properties.remove(key);
+        removeProperty(key, LONG);
     }
 
     void Document::stringProperty(std::string const &key, std::string const &value) {
-        string_properties.put(key, value);
+        removeProperty(key, STRING);
+        auto offset = static_cast<long>(string_arena.size());
+        string_arena.append(value);
+        putProperty(key, STRING, offset).string_length = static_cast<std::uint32_t>(value.size());
     }
 
     std::string Document::stringProperty(std::string const &key) const {
-        return string_properties.get(key);
+        PropertyEntry const *entry = findProperty(key, STRING);
+        if (entry == nullptr) {
+            return "";
+        }
+        return string_arena.substr(static_cast<std::size_t>(entry->value), entry->string_length);
     }
 
     void Document::removeStringProperty(std::string const &key) {
-        string_properties.remove(key);
+        removeProperty(key, STRING);
     }
 
     yuca::utils::List<std::string> Document::propertyKeys(PropertyType type) const {
-        switch (type) {
-            case BOOL:
-                return bool_properties.keyList();
-            case BYTE:
-                return byte_properties.keyList();
-            case INT:
-                return int_properties.keyList();
-            case LONG:
-                return long_properties.keyList();
-            case STRING:
-                return string_properties.keyList();
-        }
-        return utils::List<std::string>();
+        std::vector<std::string> keys;
+        for (auto const &entry : properties) {
+            if (entry.type == type) {
+                keys.push_back(PropertyNames::getName(entry.name_id));
+            }
+        }
+        // in name order, ids are in the order names were first seen
+        std::sort(keys.begin(), keys.end());
+        yuca::utils::List<std::string> keys_out;
+        keys_out.getStdVector().swap(keys);
+        return keys_out;
+    }
+
+    std::size_t Document::lowerBound(std::uint32_t name_id, PropertyType type) const noexcept {
+        auto entry_it = std::lower_bound(properties.begin(), properties.end(), std::make_pair(name_id, type),
+                                         [](PropertyEntry const &entry,
+                                            std::pair<std::uint32_t, PropertyType> const &target) {
+                                             return entry.name_id != target.first ? entry.name_id < target.first :
+                                                    entry.type < target.second;
+                                         });
+        return static_cast<std::size_t>(entry_it - properties.begin());
+    }
+
+    Document::PropertyEntry const *Document::findProperty(std::string const &key, PropertyType type) const {
+        std::uint32_t name_id = PropertyNames::find(key);
+        if (name_id == PropertyNames::NO_NAME) {
+            return nullptr;
+        }
+        std::size_t index = lowerBound(name_id, type);
+        if (index == properties.size() || properties[index].name_id != name_id || properties[index].type != type) {
+            return nullptr;
+        }
+        return &properties[index];
+    }
+
+    Document::PropertyEntry &Document::putProperty(std::string const &key, PropertyType type, long value) {
+        std::uint32_t name_id = PropertyNames::intern(key);
+        std::size_t index = lowerBound(name_id, type);
+        if (index < properties.size() && properties[index].name_id == name_id && properties[index].type == type) {
+            properties[index].value = value;
+            return properties[index];
+        }
+        PropertyEntry entry = {name_id, type, 0, value};
+        properties.insert(index, entry);
+        return properties[index];
+    }
+
+    void Document::removeProperty(std::string const &key, PropertyType type) {
+        PropertyEntry const *entry = findProperty(key, type);
+        if (entry == nullptr) {
+            return;
+        }
+        if (type == STRING) {
+            string_garbage += entry->string_length;
+        }
+        properties.removeAt(static_cast<std::size_t>(entry - properties.begin()));
+        if (string_garbage > 64 && string_garbage * 2 > string_arena.size()) {
+            compactStrings();
+        }
+    }
+
+    void Document::compactStrings() {
+        std::string compacted;
+        compacted.reserve(string_arena.size() - string_garbage);
+        for (auto &entry : properties) {
+            if (entry.type == STRING) {
+                auto offset = static_cast<long>(compacted.size());
+                compacted.append(string_arena, static_cast<std::size_t>(entry.value), entry.string_length);
+                entry.value = offset;
+            }
+        }
+        string_arena.swap(compacted);
+        string_garbage = 0;
     }
 
     bool Document::operator<(const Document &other) const {
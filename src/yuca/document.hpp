@@ -29,10 +29,15 @@
 #ifndef YUCA_DOCUMENT_HPP
 #define YUCA_DOCUMENT_HPP
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 #include <chrono>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 #include "key.hpp"
 #include "types.hpp"
 #include "utils.hpp"
@@ -46,16 +51,75 @@ namespace yuca {
         STRING
     };
 
+    /**
+     * Process wide table of property names. Each distinct name is stored once and gets a small id
+     * that never changes, Documents keep the ids instead of their own copies of the names.
+     *
+     * Names are only ever added. Lookups don't lock, they read a published hash table whose slots are
+     * filled in with atomic stores; adding a name takes a lock, and when the table gets half full it's
+     * copied into one twice its size that is then published in its place.
+     */
+    class PropertyNames {
+    public:
+        static const std::uint32_t NO_NAME = 0xffffffff;
+
+        static std::uint32_t intern(std::string const &name);
+
+        /** The name's id, NO_NAME if it was never interned */
+        static std::uint32_t find(std::string const &name);
+
+        static std::string const &getName(std::uint32_t name_id);
+
+    private:
+        struct Name {
+            std::string text;
+            std::size_t hash;
+            std::uint32_t id;
+        };
+
+        /** Open addressing over the names, and the names by id */
+        struct Table {
+            explicit Table(std::size_t a_capacity);
+
+            // a power of 2, at most half of the slots are used
+            std::size_t capacity;
+
+            std::unique_ptr<std::atomic<Name const *>[]> slots;
+
+            // capacity / 2 of them
+            std::unique_ptr<std::atomic<Name const *>[]> by_id;
+        };
+
+        PropertyNames();
+
+        static PropertyNames &instance();
+
+        /** The name's entry, nullptr if it isn't in the table */
+        static Name const *lookup(Table const &table, std::string const &name, std::size_t hash) noexcept;
+
+        /** Adds the name to a table with room for it, the id first so a name that's found always has it */
+        static void insert(Table &table, Name const *name) noexcept;
+
+        // the table lookups read
+        std::atomic<Table *> table;
+
+        // held while a name is added
+        std::mutex mutex;
+
+        // by id, a deque so the names don't move as it grows
+        std::deque<Name> names;
+
+        // every table published, readers may still be going through the older ones
+        std::vector<std::unique_ptr<Table>> tables;
+    };
+
     class Document {
     public:
         explicit Document(long doc_id) :
         id(doc_id),
         group_2_keyset_map(SPStringKeySet()),
-        bool_properties(false),
-        byte_properties(0),
-        int_properties(-1),
-        long_properties(-1l),
-        string_properties("")
+        group_2_key_sequence_map(yuca::utils::List<std::string>()),
+        string_garbage(0)
         {
         }
 
@@ -69,6 +133,16 @@ namespace yuca {
         /** Associate this document to an indexing key under the given group */
         void addKey(SPStringKey key);
 
+        /**
+         * Adds a key for each keyword under the given group and remembers their order, appended to the
+         * group's key sequence, so phrase and NEAR queries can match them when the Indexer keeps positions
+         * for the group, see Indexer::keepPositions().
+         */
+        void addKeySequence(std::string const &group, yuca::utils::List<std::string> const &keywords);
+
+        /** Returns a copy of the keywords added with addKeySequence() under the group, in order */
+        yuca::utils::List<std::string> getKeySequence(std::string const &group) const;
+
         /** Does this document have at least one key under this group? */
         bool hasKeys(std::string const &group) const;
 
@@ -173,18 +247,48 @@ namespace yuca {
         static const Document NULL_DOCUMENT;
 
     private:
+        // copies the property entries into its columns as they are, ids included
+        friend class ColumnStore;
+
         long id;
 
         // maps groups to set<Key>
         yuca::utils::Map<std::string, SPStringKeySet> group_2_keyset_map;
 
+        // maps groups to the keywords added with addKeySequence(), in order
+        yuca::utils::Map<std::string, yuca::utils::List<std::string>> group_2_key_sequence_map;
+
+        /** A property's value, STRINGs are a range of string_arena */
+        struct PropertyEntry {
+            std::uint32_t name_id; // see PropertyNames
+            PropertyType type;
+            std::uint32_t string_length; // STRING only
+            long value; // the value, or the offset in string_arena of a STRING
+        };
+
+        /** Index of the entry for the name and type, or where it would be inserted */
+        std::size_t lowerBound(std::uint32_t name_id, PropertyType type) const noexcept;
+
+        /** The entry for the property, nullptr if the document doesn't have it */
+        PropertyEntry const *findProperty(std::string const &key, PropertyType type) const;
+
+        PropertyEntry &putProperty(std::string const &key, PropertyType type, long value);
+
+        void removeProperty(std::string const &key, PropertyType type);
+
+        /** Rewrites the arena with only the values that are still in use */
+        void compactStrings();
+
         // docs can have unique properties that are not necessarily indexed keys
-        // but which are meant to be retrieved once they appear in search results
-        yuca::utils::Map<std::string, bool> bool_properties;
-        yuca::utils::Map<std::string, char> byte_properties;
-        yuca::utils::Map<std::string, int> int_properties;
-        yuca::utils::Map<std::string, long> long_properties;
-        yuca::utils::Map<std::string, std::string> string_properties;
+        // but which are meant to be retrieved once they appear in search results.
+        // Sorted by (name_id, type), most documents have few properties, so they stay inline
+        yuca::utils::SmallVector<PropertyEntry, 4> properties;
+
+        // the values of the STRING properties, one after the other
+        std::string string_arena;
+
+        // bytes of string_arena no property uses anymore
+        std::size_t string_garbage;
     };
 }
 
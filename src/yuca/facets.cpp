@@ -0,0 +1,112 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#include <algorithm>
+#include "facets.hpp"
+
+namespace yuca {
+    namespace facets {
+        void keepTop(std::vector<FacetCount> &counts, std::size_t max_keys) {
+            auto before = [](FacetCount const &a, FacetCount const &b) {
+                return a.document_count != b.document_count ? a.document_count > b.document_count :
+                       a.keyword < b.keyword;
+            };
+            if (max_keys > 0 && max_keys < counts.size()) {
+                std::partial_sort(counts.begin(), counts.begin() + static_cast<long>(max_keys), counts.end(), before);
+                counts.resize(max_keys);
+            } else {
+                std::sort(counts.begin(), counts.end(), before);
+            }
+        }
+    }
+
+    std::string const &FacetIndex::getGroup() const noexcept {
+        return group;
+    }
+
+    void FacetIndex::putDocument(DocOrdinal ordinal, Document const &doc) {
+        removeDocument(ordinal);
+        SPStringKeySet keys = doc.getGroupSPKeys(group);
+        if (keys.isEmpty()) {
+            return;
+        }
+        if (ordinal >= ordinal_terms.size()) {
+            ordinal_terms.resize(static_cast<std::size_t>(ordinal) + 1);
+        }
+        std::vector<std::uint32_t> &document_terms = ordinal_terms[ordinal];
+        document_terms.reserve(keys.size());
+        for (auto const &key : keys.getStdSet()) {
+            document_terms.push_back(intern(key->getString()));
+        }
+    }
+
+    void FacetIndex::removeDocument(DocOrdinal ordinal) {
+        if (ordinal < ordinal_terms.size()) {
+            std::vector<std::uint32_t>().swap(ordinal_terms[ordinal]);
+        }
+    }
+
+    std::size_t FacetIndex::getTermCount() const noexcept {
+        return terms.size();
+    }
+
+    std::vector<FacetCount> FacetIndex::count(std::vector<DocOrdinal> const &ordinals, std::size_t max_keys) const {
+        std::vector<std::uint32_t> document_counts(terms.size(), 0);
+        for (DocOrdinal ordinal : ordinals) {
+            if (ordinal >= ordinal_terms.size()) {
+                continue;
+            }
+            for (std::uint32_t term_id : ordinal_terms[ordinal]) {
+                document_counts[term_id]++;
+            }
+        }
+        std::vector<FacetCount> counts;
+        for (std::uint32_t term_id = 0; term_id < document_counts.size(); term_id++) {
+            if (document_counts[term_id] > 0) {
+                counts.push_back({terms[term_id], document_counts[term_id]});
+            }
+        }
+        facets::keepTop(counts, max_keys);
+        return counts;
+    }
+
+    void FacetIndex::clear() {
+        term_ids.clear();
+        terms.clear();
+        ordinal_terms.clear();
+    }
+
+    std::uint32_t FacetIndex::intern(std::string const &keyword) {
+        auto term_id_it = term_ids.find(keyword);
+        if (term_id_it != term_ids.end()) {
+            return term_id_it->second;
+        }
+        auto term_id = static_cast<std::uint32_t>(terms.size());
+        term_ids.emplace(keyword, term_id);
+        terms.push_back(keyword);
+        return term_id;
+    }
+}
@@ -0,0 +1,111 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+//
+// Facet counts, the keys a group's documents have among the matches of a search and how many matches have each.
+//
+// Groups with few keys are counted from their posting lists, a bitmap test per posting, see
+// ReverseIndex::countKeys(). Groups with many keys can keep a FacetIndex, the term ids of the keys of every
+// document, so that only the keys of the matches are looked at instead of every posting of the group.
+//
+
+#ifndef YUCA_FACETS_HPP
+#define YUCA_FACETS_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "document.hpp"
+#include "postings.hpp"
+#include "utils.hpp"
+
+namespace yuca {
+    /** A key of a facet group and the number of matches that have it */
+    struct FacetCount {
+        std::string keyword;
+        std::size_t document_count;
+
+        bool operator==(const FacetCount &other) const {
+            return keyword == other.keyword && document_count == other.document_count;
+        }
+    };
+
+    /** The keys of a group the most matches have, see Indexer::search(..., facet_groups, ...) */
+    struct Facet {
+        std::string group;
+        yuca::utils::List<FacetCount> counts; // most documents first, ties in string order
+
+        bool operator==(const Facet &other) const {
+            return group == other.group && counts.getStdVector() == other.counts.getStdVector();
+        }
+    };
+
+    namespace facets {
+        /** Sorts the counts, most documents first, ties in string order, and keeps the first max_keys if it's > 0 */
+        void keepTop(std::vector<FacetCount> &counts, std::size_t max_keys);
+    }
+
+    /** The keys of every document under one group, by document ordinal, as small dense term ids */
+    class FacetIndex {
+    public:
+        explicit FacetIndex(std::string const &a_group) : group(a_group) {
+        }
+
+        std::string const &getGroup() const noexcept;
+
+        /** Indexes the document's keys under the group, replacing the ones it had */
+        void putDocument(DocOrdinal ordinal, Document const &doc);
+
+        void removeDocument(DocOrdinal ordinal);
+
+        /** Number of distinct keys documents have had, term ids aren't reused */
+        std::size_t getTermCount() const noexcept;
+
+        /**
+         * The max_keys keys the most of the given documents have, all of them if it's 0, most documents first,
+         * ties in string order. Costs O(ordinals * keys per document + term count).
+         */
+        std::vector<FacetCount> count(std::vector<DocOrdinal> const &ordinals, std::size_t max_keys) const;
+
+        void clear();
+
+    private:
+        std::uint32_t intern(std::string const &keyword);
+
+        std::string group;
+
+        std::unordered_map<std::string, std::uint32_t> term_ids;
+
+        // by term id
+        std::vector<std::string> terms;
+
+        // by ordinal, the term ids of the document's keys
+        std::vector<std::vector<std::uint32_t>> ordinal_terms;
+    };
+}
+
+#endif //YUCA_FACETS_HPP
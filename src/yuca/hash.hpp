@@ -0,0 +1,159 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Stable 64-bit hashing for keys, based on wyhash (final version 4, public domain)
+// https://github.com/wangyi-fudan/wyhash
+//
+// Unlike std::hash, the values produced here are the same on every build and platform,
+// so key ids can be persisted.
+//
+
+#ifndef YUCA_HASH_HPP
+#define YUCA_HASH_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "utils.hpp"
+
+namespace yuca {
+    namespace utils {
+        const std::uint64_t DEFAULT_HASH_SEED = 0x9e3779b97f4a7c15ull;
+
+        namespace detail {
+            const std::uint64_t WY_SECRET[4] = {0x2d358dccaa6c78a5ull,
+                                                0x8bb84b93962eacc9ull,
+                                                0x4b33a62ed433d4a3ull,
+                                                0x4d5a2da51de1aa47ull};
+
+            /** 64x64 -> 128 bit multiply, A gets the low half and B the high half */
+            inline void wymum(std::uint64_t *A, std::uint64_t *B) noexcept {
+#if defined(__SIZEOF_INT128__)
+                __extension__ typedef unsigned __int128 uint128;
+                uint128 r = *A;
+                r *= *B;
+                *A = static_cast<std::uint64_t>(r);
+                *B = static_cast<std::uint64_t>(r >> 64);
+#else
+                std::uint64_t ha = *A >> 32, hb = *B >> 32, la = static_cast<std::uint32_t>(*A),
+                lb = static_cast<std::uint32_t>(*B);
+                std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+                std::uint64_t c = t < rl;
+                std::uint64_t lo = t + (rm1 << 32);
+                c += lo < t;
+                std::uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+                *A = lo;
+                *B = hi;
+#endif
+            }
+
+            inline std::uint64_t wymix(std::uint64_t A, std::uint64_t B) noexcept {
+                wymum(&A, &B);
+                return A ^ B;
+            }
+
+            // reads are little endian so that hashes don't depend on the host byte order
+            inline std::uint64_t wyr8(const std::uint8_t *p) noexcept {
+                std::uint64_t v;
+                std::memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                v = __builtin_bswap64(v);
+#endif
+                return v;
+            }
+
+            inline std::uint64_t wyr4(const std::uint8_t *p) noexcept {
+                std::uint32_t v;
+                std::memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                v = __builtin_bswap32(v);
+#endif
+                return v;
+            }
+
+            inline std::uint64_t wyr3(const std::uint8_t *p, std::size_t k) noexcept {
+                return (static_cast<std::uint64_t>(p[0]) << 16) | (static_cast<std::uint64_t>(p[k >> 1]) << 8) |
+                       p[k - 1];
+            }
+
+            inline std::uint64_t wyhash(const char *data, std::size_t len, std::uint64_t seed) noexcept {
+                const auto *p = reinterpret_cast<const std::uint8_t *>(data);
+                seed ^= wymix(seed ^ WY_SECRET[0], WY_SECRET[1]);
+                std::uint64_t a, b;
+                if (len <= 16) {
+                    if (len >= 4) {
+                        a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+                        b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - ((len >> 3) << 2));
+                    } else if (len > 0) {
+                        a = wyr3(p, len);
+                        b = 0;
+                    } else {
+                        a = b = 0;
+                    }
+                } else {
+                    std::size_t i = len;
+                    if (i > 48) {
+                        std::uint64_t see1 = seed, see2 = seed;
+                        do {
+                            seed = wymix(wyr8(p) ^ WY_SECRET[1], wyr8(p + 8) ^ seed);
+                            see1 = wymix(wyr8(p + 16) ^ WY_SECRET[2], wyr8(p + 24) ^ see1);
+                            see2 = wymix(wyr8(p + 32) ^ WY_SECRET[3], wyr8(p + 40) ^ see2);
+                            p += 48;
+                            i -= 48;
+                        } while (i > 48);
+                        seed ^= see1 ^ see2;
+                    }
+                    while (i > 16) {
+                        seed = wymix(wyr8(p) ^ WY_SECRET[1], wyr8(p + 8) ^ seed);
+                        i -= 16;
+                        p += 16;
+                    }
+                    a = wyr8(p + i - 16);
+                    b = wyr8(p + i - 8);
+                }
+                a ^= WY_SECRET[1];
+                b ^= seed;
+                wymum(&a, &b);
+                return wymix(a ^ WY_SECRET[0] ^ len, b ^ WY_SECRET[1]);
+            }
+        }
+
+        /** wyhash of the given bytes. Stable across builds, platforms and runs for the same seed */
+        inline std::uint64_t hash64(StringView str, std::uint64_t seed = DEFAULT_HASH_SEED) noexcept {
+            return detail::wyhash(str.data(), str.size(), seed);
+        }
+
+        /**
+         * Hashes a (group, term) pair without concatenating them, the group hash is used as the seed
+         * for the term hash. ("ab", "c") and ("a", "bc") won't collide the way a concatenation would.
+         */
+        inline std::uint64_t hashKey(StringView group, StringView term,
+                                     std::uint64_t seed = DEFAULT_HASH_SEED) noexcept {
+            return hash64(term, hash64(group, seed));
+        }
+    }
+}
+
+#endif //YUCA_HASH_HPP
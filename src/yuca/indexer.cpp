@@ -26,43 +26,105 @@
 // Created by gubatron.
 //
 
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <queue>
 #include "indexer.hpp"
 
 namespace yuca {
+    namespace {
+        // shared by all ReverseIndex objects so that their generations never repeat
+        std::atomic<std::uint64_t> generation_clock(0);
 
-    void ReverseIndex::putDocument(SPKey key, SPDocument doc) {
-        if (!hasDocuments(key)) {
-            keyCachePut(key);
+        /** The property a group's ranges look at, ":year" -> "year" */
+        std::string groupProperty(yuca::utils::StringView group) {
+            return (group.startsWith(":") ? group.subView(1, group.size()) : group).toString();
+        }
+
+        // facets of groups with up to this many keys are counted from their postings, even with a FacetIndex
+        const long MAX_POSTINGS_FACET_KEYS = 256;
+    }
+
+    const SPDocumentSet ReverseIndex::NO_DOCUMENTS;
+
+    const std::size_t Indexer::DEFAULT_MAX_TERM_EXPANSIONS;
+
+    void ReverseIndex::touch() {
+        generation = ++generation_clock;
+    }
+
+    std::uint64_t ReverseIndex::getGeneration() const {
+        return generation;
+    }
+
+    void ReverseIndex::putDocument(SPKey key, SPDocument doc, DocOrdinal ordinal) {
+        TermEntry *entry = findEntry(key);
+        if (entry == nullptr) {
+            TermEntry new_entry = {key, PostingList(), TermPositions()};
+            new_entry.postings.add(ordinal);
+            termDictionary.getStdMap()[key->getId()].push_back(std::move(new_entry));
+            auto string_key = dynamic_cast<StringKey const *>(key.get());
+            if (string_key != nullptr) {
+                orderedTerms.insert(std::make_pair(yuca::utils::StringView(string_key->getString()), key->getId()));
+            }
             SPDocumentSet newDocSet;
             newDocSet.add(doc);
             spkey_to_spdocset_map.put(key, newDocSet);
+            entry = &termDictionary.getStdMap()[key->getId()].back();
         } else {
-            SPDocumentSet oldDocSet = getDocuments(key);
-            oldDocSet.add(doc);
-            auto cached_key = keyCacheGet(key);
-            spkey_to_spdocset_map.put(cached_key, oldDocSet);
+            entry->postings.add(ordinal);
+            spkey_to_spdocset_map.getStdMap()[entry->key].add(doc);
         }
+        updateCompletion(*entry);
+        documentOrdinals.add(ordinal);
+        touch();
     }
 
-    void ReverseIndex::removeDocument(SPKey key, SPDocument doc) {
-        if (!hasDocuments(key)) {
+    void ReverseIndex::putPositions(SPKey key, DocOrdinal ordinal, std::vector<KeyPosition> const &positions) {
+        TermEntry *entry = findEntry(key);
+        if (entry != nullptr) {
+            entry->positions.put(ordinal, positions);
+        }
+    }
+
+    TermPositions const &ReverseIndex::findPositions(long key_id, yuca::utils::StringView string_key) const {
+        TermEntry const *entry = findEntry(key_id, string_key);
+        return entry == nullptr ? TermPositions::EMPTY : entry->positions;
+    }
+
+    bool ReverseIndex::keepsPositions() const {
+        return positional;
+    }
+
+    void ReverseIndex::setKeepsPositions(bool keeps_positions) {
+        positional = keeps_positions;
+    }
+
+    void ReverseIndex::removeDocumentOrdinal(DocOrdinal ordinal) {
+        documentOrdinals.remove(ordinal);
+        touch();
+    }
+
+    void ReverseIndex::removeDocument(SPKey key, SPDocument doc, DocOrdinal ordinal) {
+        TermEntry *entry = findEntry(key);
+        if (entry == nullptr) {
             std::cout << "ReverseIndex::removeDocument aborted. ReverseIndex has no documents under key "
                       << key->getId() << std::endl;
             return;
         }
-        SPDocumentSet docs = getDocuments(key);
-        SPKey cached_key = keyCacheGet(key);
-        if (docs.isEmpty()) {
+        touch();
+        SPKey cached_key = entry->key;
+        auto docs_it = spkey_to_spdocset_map.getStdMap().find(cached_key);
+        if (docs_it != spkey_to_spdocset_map.getStdMap().end()) {
+            docs_it->second.remove(doc);
+        }
+        entry->postings.remove(ordinal);
+        entry->positions.remove(ordinal);
+        updateCompletion(*entry);
+        if (docs_it == spkey_to_spdocset_map.getStdMap().end() || docs_it->second.isEmpty()) {
             spkey_to_spdocset_map.remove(cached_key);
             keyCacheRemove(cached_key);
-        } else if (docs.contains(doc)) {
-            docs.remove(doc);
-            if (!docs.isEmpty()) {
-                spkey_to_spdocset_map.put(cached_key, docs);
-            } else {
-                spkey_to_spdocset_map.remove(cached_key);
-                keyCacheRemove(cached_key);
-            }
         }
     }
 
@@ -76,31 +138,65 @@ namespace yuca {
 
     void ReverseIndex::clear() {
         spkey_to_spdocset_map.clear();
-        keyPtrCache.clear();
+        termDictionary.clear();
+        orderedTerms.clear();
+        documentOrdinals.clear();
+        completions.clear();
+        touch();
     }
 
-    SPKey ReverseIndex::keyCacheGet(SPKey key) const {
-        return keyPtrCache.get(key->getId());
-    }
-
-    void ReverseIndex::keyCachePut(SPKey key) {
-        keyPtrCache.put(key->getId(), key);
+    ReverseIndex::TermEntry *ReverseIndex::findEntry(SPKey const &key) {
+        return const_cast<TermEntry *>(static_cast<ReverseIndex const *>(this)->findEntry(key));
     }
 
-    void ReverseIndex::keyCacheRemove(SPKey key) {
-        keyPtrCache.remove(key->getId());
+    ReverseIndex::TermEntry const *ReverseIndex::findEntry(SPKey const &key) const {
+        auto bucket_it = termDictionary.getStdMap().find(key->getId());
+        if (bucket_it == termDictionary.getStdMap().end()) {
+            return nullptr;
+        }
+        for (auto const &entry : bucket_it->second) {
+            if (entry.key == key || *entry.key == *key) {
+                return &entry;
+            }
+        }
+        return nullptr;
     }
 
-    yuca::utils::List<std::string> SearchRequest::getGroups() {
-        return group_keywords_map.keyList();
+    ReverseIndex::TermEntry const *ReverseIndex::findEntry(long key_id, yuca::utils::StringView string_key) const {
+        auto bucket_it = termDictionary.getStdMap().find(key_id);
+        if (bucket_it == termDictionary.getStdMap().end()) {
+            return nullptr;
+        }
+        for (auto const &entry : bucket_it->second) {
+            auto cached_string_key = dynamic_cast<StringKey const *>(entry.key.get());
+            if (cached_string_key != nullptr && cached_string_key->hasString(string_key)) {
+                return &entry;
+            }
+        }
+        return nullptr;
     }
 
-    yuca::utils::List<std::string> SearchRequest::getKeywords(std::string &group) {
-        return group_keywords_map.get(group);
+    SPKey ReverseIndex::keyCacheGet(SPKey key) const {
+        TermEntry const *entry = findEntry(key);
+        return entry == nullptr ? nullptr : entry->key;
     }
 
-    bool SearchRequest::operator==(const SearchRequest &other) const {
-        return this->query == other.query && this->id == other.id && this->total_keywords == other.total_keywords;
+    void ReverseIndex::keyCacheRemove(SPKey key) {
+        auto bucket_it = termDictionary.getStdMap().find(key->getId());
+        if (bucket_it == termDictionary.getStdMap().end()) {
+            return;
+        }
+        auto string_key = dynamic_cast<StringKey const *>(key.get());
+        if (string_key != nullptr) {
+            orderedTerms.erase(yuca::utils::StringView(string_key->getString()));
+        }
+        auto &bucket = bucket_it->second;
+        bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [&key](TermEntry const &entry) {
+            return entry.key == key;
+        }), bucket.end());
+        if (bucket.empty()) {
+            termDictionary.getStdMap().erase(bucket_it);
+        }
     }
 
     bool SearchResult::operator==(const SearchResult &other) const {
@@ -114,10 +210,206 @@ namespace yuca {
         return spkey_to_spdocset_map.get(keyCacheGet(key));
     }
 
+    SPDocumentSet const &ReverseIndex::findDocuments(long key_id, yuca::utils::StringView string_key) const {
+        TermEntry const *entry = findEntry(key_id, string_key);
+        if (entry == nullptr) {
+            return NO_DOCUMENTS;
+        }
+        auto docs_it = spkey_to_spdocset_map.getStdMap().find(entry->key);
+        if (docs_it == spkey_to_spdocset_map.getStdMap().end()) {
+            return NO_DOCUMENTS;
+        }
+        return docs_it->second;
+    }
+
+    PostingList const &ReverseIndex::findPostings(long key_id, yuca::utils::StringView string_key) const {
+        TermEntry const *entry = findEntry(key_id, string_key);
+        return entry == nullptr ? PostingList::EMPTY : entry->postings;
+    }
+
+    std::vector<OrdinalRange> ReverseIndex::findPrefixPostings(yuca::utils::StringView prefix,
+                                                               std::size_t max_terms) const {
+        std::vector<OrdinalRange> result;
+        for (auto it = orderedTerms.lower_bound(prefix);
+             it != orderedTerms.end() && result.size() < max_terms && it->first.startsWith(prefix); ++it) {
+            result.push_back(findPostings(it->second, it->first).range());
+        }
+        return result;
+    }
+
+    std::vector<OrdinalRange> ReverseIndex::findRangePostings(yuca::utils::StringView lower,
+                                                              bool include_lower,
+                                                              yuca::utils::StringView upper,
+                                                              bool include_upper) const {
+        std::vector<OrdinalRange> result;
+        auto it = lower.isEmpty() ? orderedTerms.begin() :
+                  include_lower ? orderedTerms.lower_bound(lower) : orderedTerms.upper_bound(lower);
+        for (; it != orderedTerms.end(); ++it) {
+            if (!upper.isEmpty()) {
+                int comparison = it->first.compare(upper);
+                if (comparison > 0 || (comparison == 0 && !include_upper)) {
+                    break;
+                }
+            }
+            result.push_back(findPostings(it->second, it->first).range());
+        }
+        return result;
+    }
+
+    std::vector<OrdinalRange> ReverseIndex::findWildcardPostings(yuca::utils::StringView pattern,
+                                                                 std::size_t max_terms) const {
+        std::size_t literal_length = 0;
+        while (literal_length < pattern.size() && pattern[literal_length] != '*' && pattern[literal_length] != '?') {
+            literal_length++;
+        }
+        yuca::utils::StringView literal_prefix = pattern.subView(0, literal_length);
+        std::vector<OrdinalRange> result;
+        for (auto it = orderedTerms.lower_bound(literal_prefix);
+             it != orderedTerms.end() && result.size() < max_terms && it->first.startsWith(literal_prefix); ++it) {
+            if (yuca::utils::wildcardMatch(pattern, it->first)) {
+                result.push_back(findPostings(it->second, it->first).range());
+            }
+        }
+        return result;
+    }
+
+    std::vector<ReverseIndex::FuzzyKey> ReverseIndex::findFuzzyKeys(yuca::utils::StringView term,
+                                                                    std::uint32_t max_edits) const {
+        const std::size_t term_length = term.size();
+        // rows[i] = Levenshtein DP row of the term against the first i characters of prefix
+        std::vector<std::vector<std::uint32_t>> rows(1, std::vector<std::uint32_t>(term_length + 1));
+        for (std::size_t j = 0; j <= term_length; j++) {
+            rows[0][j] = static_cast<std::uint32_t>(j);
+        }
+        std::string prefix;
+        std::vector<FuzzyKey> matches;
+
+        auto it = orderedTerms.begin();
+        while (it != orderedTerms.end()) {
+            yuca::utils::StringView candidate = it->first;
+            // reuse the rows of the prefix this key shares with the previous one
+            std::size_t common = 0;
+            while (common < prefix.size() && common < candidate.size() && prefix[common] == candidate[common]) {
+                common++;
+            }
+            prefix.resize(common);
+            rows.resize(common + 1);
+
+            bool dead_prefix = false;
+            for (std::size_t i = common; i < candidate.size(); i++) {
+                std::vector<std::uint32_t> const &previous = rows[i];
+                std::vector<std::uint32_t> row(term_length + 1);
+                row[0] = previous[0] + 1;
+                std::uint32_t row_min = row[0];
+                for (std::size_t j = 1; j <= term_length; j++) {
+                    std::uint32_t substitution = previous[j - 1] + (term[j - 1] == candidate[i] ? 0 : 1);
+                    row[j] = std::min(std::min(previous[j] + 1, row[j - 1] + 1), substitution);
+                    row_min = std::min(row_min, row[j]);
+                }
+                prefix.push_back(candidate[i]);
+                rows.push_back(std::move(row));
+                if (row_min > max_edits) {
+                    dead_prefix = true;
+                    break;
+                }
+            }
+
+            if (dead_prefix) {
+                // no key that starts with this prefix can get within max_edits, jump past all of them
+                std::string next_prefix(prefix);
+                while (!next_prefix.empty() && static_cast<unsigned char>(next_prefix.back()) == 0xff) {
+                    next_prefix.pop_back();
+                }
+                if (next_prefix.empty()) {
+                    break;
+                }
+                next_prefix.back() = static_cast<char>(static_cast<unsigned char>(next_prefix.back()) + 1);
+                it = orderedTerms.lower_bound(yuca::utils::StringView(next_prefix));
+                continue;
+            }
+            std::uint32_t distance = rows.back()[term_length];
+            if (distance <= max_edits) {
+                matches.push_back(FuzzyKey{candidate, it->second, distance,
+                                           findPostings(it->second, candidate).size()});
+            }
+            ++it;
+        }
+        return matches;
+    }
+
+    std::vector<OrdinalRange> ReverseIndex::findFuzzyPostings(yuca::utils::StringView term,
+                                                              std::uint32_t max_edits,
+                                                              std::size_t max_terms) const {
+        std::vector<FuzzyKey> matches = findFuzzyKeys(term, max_edits);
+        if (matches.size() > max_terms) {
+            std::stable_sort(matches.begin(), matches.end(), [](FuzzyKey const &a, FuzzyKey const &b) {
+                return a.edits < b.edits;
+            });
+            matches.resize(max_terms);
+        }
+        std::vector<OrdinalRange> result;
+        result.reserve(matches.size());
+        for (auto const &match : matches) {
+            result.push_back(findPostings(match.key_id, match.keyword).range());
+        }
+        return result;
+    }
+
+    std::vector<Completion> ReverseIndex::complete(yuca::utils::StringView prefix,
+                                                   std::size_t max_completions) const {
+        return completions.complete(prefix, max_completions);
+    }
+
+    std::vector<FacetCount> ReverseIndex::countKeys(DocBitmap const &ordinals, std::size_t max_keys) const {
+        std::vector<FacetCount> counts;
+        // the max_keys largest counts so far, a key with fewer documents than the smallest of them can't make it
+        std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t>> top_counts;
+        for (auto const &term : orderedTerms) {
+            TermEntry const *entry = findEntry(term.second, term.first);
+            if (entry == nullptr ||
+                (max_keys > 0 && top_counts.size() == max_keys && entry->postings.size() <= top_counts.top())) {
+                continue;
+            }
+            std::size_t document_count = 0;
+            for (DocOrdinal ordinal : entry->postings.range()) {
+                if (ordinals.test(ordinal)) {
+                    document_count++;
+                }
+            }
+            if (document_count == 0) {
+                continue;
+            }
+            counts.push_back({term.first.toString(), document_count});
+            if (max_keys > 0) {
+                top_counts.push(document_count);
+                if (top_counts.size() > max_keys) {
+                    top_counts.pop();
+                }
+            }
+        }
+        facets::keepTop(counts, max_keys);
+        return counts;
+    }
+
+    void ReverseIndex::updateCompletion(TermEntry const &entry) {
+        auto string_key = dynamic_cast<StringKey const *>(entry.key.get());
+        if (string_key != nullptr) {
+            completions.setWeight(string_key->getString(), entry.postings.size());
+        }
+    }
+
+    std::string const &ReverseIndex::getGroup() const {
+        return group;
+    }
+
     long ReverseIndex::getKeyCount() const {
         return static_cast<long>(spkey_to_spdocset_map.size());
     }
 
+    std::size_t ReverseIndex::getDocumentCount() const {
+        return documentOrdinals.size();
+    }
+
     std::ostream &operator<<(std::ostream &output_stream, ReverseIndex &rindex) {
         int truncated_address = (static_cast<int>((long) &rindex)) % 10000;
         output_stream << "ReverseIndex(@" << truncated_address << "):" << std::endl;
@@ -159,13 +451,16 @@ namespace yuca {
         return output_stream;
     }
 
-    void Indexer::indexDocument(Document doc) {
-        SPDocument spDoc = std::make_shared<Document>(doc);
-        indexDocument(spDoc);
+    void Indexer::indexDocument(Document const &doc) {
+        indexDocument(std::make_shared<Document>(doc));
+    }
+
+    void Indexer::indexDocument(Document &&doc) {
+        indexDocument(std::make_shared<Document>(std::move(doc)));
     }
 
     Document Indexer::getDocument(long doc_id) const noexcept {
-        SPDocument spDocument = docPtrCache.get(doc_id);
+        SPDocument spDocument = findDocument(doc_id);
         if (spDocument == nullptr) {
             return Document::NULL_DOCUMENT;
         }
@@ -176,21 +471,20 @@ namespace yuca {
         return getDocument(static_cast<long>(std::hash<std::string>{}(doc_id)));
     }
 
-    bool Indexer::removeDocument(long const doc_id) {
-        Document document = getDocument(doc_id);
-        if (document == Document::NULL_DOCUMENT) {
-            return false;
+    SPDocument Indexer::findDocument(long doc_id) const noexcept {
+        auto doc_it = docPtrCache.getStdMap().find(doc_id);
+        if (doc_it == docPtrCache.getStdMap().end()) {
+            return nullptr;
         }
-        removeDocument(document);
-        return true;
+        return doc_it->second;
     }
 
-    bool Indexer::removeDocument(std::string const &doc_id) {
-        return removeDocument(static_cast<long>(std::hash<std::string>{}(doc_id)));
+    SPDocument Indexer::findDocument(std::string const &doc_id) const noexcept {
+        return findDocument(static_cast<long>(std::hash<std::string>{}(doc_id)));
     }
 
-    bool Indexer::removeDocument(Document doc) {
-        SPDocument spDoc = docPtrCache.get(doc.getId());
+    bool Indexer::removeDocument(long const doc_id) {
+        SPDocument spDoc = findDocument(doc_id);
         if (spDoc == nullptr) {
             return false;
         }
@@ -198,8 +492,48 @@ namespace yuca {
         return true;
     }
 
+    bool Indexer::removeDocument(std::string const &doc_id) {
+        return removeDocument(static_cast<long>(std::hash<std::string>{}(doc_id)));
+    }
+
+    bool Indexer::removeDocument(Document const &doc) {
+        return removeDocument(doc.getId());
+    }
+
     void Indexer::indexDocument(SPDocument spDoc) {
+        // the new version may have dropped some of the old one's keys, the old one is taken out first.
+        // Its ordinal is the last one freed, so the new version gets it back
+        SPDocument indexed = findDocument(spDoc->getId());
+        if (indexed != nullptr) {
+            removeDocument(indexed);
+        }
         docPtrCache.put(spDoc->getId(), spDoc);
+        DocOrdinal ordinal = assignOrdinal(spDoc);
+        documentsGeneration++;
+        columns.putDocument(ordinal, *spDoc);
+        for (auto &numeric_index : numericIndices) {
+            long value;
+            if (findNumericValue(numeric_index.first, ordinal, value)) {
+                numeric_index.second.putDocument(ordinal, value);
+            } else {
+                numeric_index.second.removeDocument(ordinal);
+            }
+        }
+
+        for (auto &facet_index : facetIndices) {
+            facet_index.second.putDocument(ordinal, *spDoc);
+        }
+
+        if (!trigramIndices.empty()) {
+            yuca::utils::List<std::string> string_properties = spDoc->propertyKeys(STRING);
+            for (auto &trigram_index : trigramIndices) {
+                if (string_properties.contains(trigram_index.first)) {
+                    trigram_index.second.putDocument(ordinal, spDoc->stringProperty(trigram_index.first));
+                } else {
+                    trigram_index.second.removeDocument(ordinal);
+                }
+            }
+        }
 
         std::set<std::string> groups = spDoc->getGroups();
         for (auto const &group : groups) {
@@ -219,22 +553,43 @@ namespace yuca {
     }
 
     void Indexer::removeDocument(SPDocument doc) {
+        auto ordinal_it = docOrdinals.getStdMap().find(doc->getId());
+        if (ordinal_it == docOrdinals.getStdMap().end()) {
+            return;
+        }
+        DocOrdinal ordinal = ordinal_it->second;
         std::set<std::string> groups = doc->getGroups();
         for (auto const &group : groups) {
             std::shared_ptr<ReverseIndex> reverse_index = getReverseIndex(group);
 
             SPStringKeySet key_set = doc->getGroupSPKeys(group);
             for (auto const &key : key_set.getStdSetCopy()) {
-                reverse_index->removeDocument(key, doc);
+                reverse_index->removeDocument(key, doc, ordinal);
             }
+            reverse_index->removeDocumentOrdinal(ordinal);
             if (reverse_index->getKeyCount() == 0) {
                 reverse_index->clear();
-                reverseIndices.remove(group);
+                removeReverseIndex(group);
             } else {
                 reverseIndices.put(group, reverse_index);
             }
         }
+        for (auto &trigram_index : trigramIndices) {
+            trigram_index.second.removeDocument(ordinal);
+        }
+        columns.removeDocument(ordinal);
+        for (auto &numeric_index : numericIndices) {
+            numeric_index.second.removeDocument(ordinal);
+        }
+        for (auto &facet_index : facetIndices) {
+            facet_index.second.removeDocument(ordinal);
+        }
         docPtrCache.remove(doc->getId());
+        docOrdinals.getStdMap().erase(ordinal_it);
+        ordinalDocuments[ordinal] = nullptr;
+        liveDocuments.unset(ordinal);
+        freeOrdinals.push_back(ordinal);
+        documentsGeneration++;
     }
 
     void Indexer::clear() {
@@ -243,80 +598,492 @@ namespace yuca {
             spReverseIndex->clear();
         }
         reverseIndices.clear();
+        groupIdReverseIndices.clear();
         docPtrCache.clear();
+        ordinalDocuments.clear();
+        docOrdinals.clear();
+        freeOrdinals.clear();
+        liveDocuments.clear();
+        columns.clear();
+        for (auto &numeric_index : numericIndices) {
+            numeric_index.second.clear();
+        }
+        for (auto &trigram_index : trigramIndices) {
+            trigram_index.second.clear();
+        }
+        for (auto &facet_index : facetIndices) {
+            facet_index.second.clear();
+        }
+        documentsGeneration++;
+        resultCache.clear();
+    }
+
+    namespace {
+        /** The postings of a clause's terms, by how they take part in it */
+        struct ClauseLists {
+            std::vector<OrdinalRange> required;
+            std::vector<OrdinalRange> optional;
+            std::vector<OrdinalRange> excluded;
+        };
+
+        ClauseLists splitClause(SearchRequest const &search_request,
+                                SearchRequest::QueryNode const &clause,
+                                std::vector<OrdinalRange> const &term_postings) {
+            ClauseLists lists;
+            for (std::uint32_t term_index : clause.children) {
+                switch (search_request.getTerm(term_index).occur) {
+                    case SearchRequest::MUST:
+                        lists.required.push_back(term_postings[term_index]);
+                        break;
+                    case SearchRequest::MUST_NOT:
+                        lists.excluded.push_back(term_postings[term_index]);
+                        break;
+                    default:
+                        lists.optional.push_back(term_postings[term_index]);
+                }
+            }
+            return lists;
+        }
+
+        /** Keeps the candidates found in at least min_should_match of the lists */
+        void keepMinShouldMatch(std::vector<DocOrdinal> &candidates,
+                                std::vector<OrdinalRange> const &lists,
+                                std::uint32_t min_should_match) {
+            if (min_should_match == 0) {
+                return;
+            }
+            std::vector<PostingCursor> cursors;
+            for (auto const &list : lists) {
+                cursors.emplace_back(list);
+            }
+            std::size_t kept = 0;
+            for (DocOrdinal candidate : candidates) {
+                std::uint32_t matches = 0;
+                for (auto &cursor : cursors) {
+                    if (cursor.advance(candidate) && cursor.current() == candidate) {
+                        matches++;
+                    }
+                }
+                if (matches >= min_should_match) {
+                    candidates[kept++] = candidate;
+                }
+            }
+            candidates.resize(kept);
+        }
+    }
+
+    namespace {
+        /**
+         * Queries that only differ in whitespace share their cache entry. The key is the query template and
+         * the values bound to its parameters, each prefixed by its length, not the bound query: a bound "comm*"
+         * is searched literally while "comm*" written in a query is a prefix.
+         */
+        std::string resultCacheKey(PreparedQuery const &prepared_query,
+                                   yuca::utils::List<std::string> const &parameters,
+                                   SearchOptions const &options) {
+            std::string const &query_template = prepared_query.getSearchRequest().query;
+            std::string key;
+            key.reserve(query_template.size() + options.main_doc_property.size() + options.sort_by.size() +
+                        options.collapse_by.size() + 48);
+            bool pending_space = false;
+            for (char c : query_template) {
+                if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                    pending_space = !key.empty();
+                    continue;
+                }
+                if (pending_space) {
+                    key.push_back(' ');
+                    pending_space = false;
+                }
+                key.push_back(c);
+            }
+            // missing parameters are searched as a literal "?", extra values are ignored
+            std::size_t bound = std::min<std::size_t>(prepared_query.getParameterCount(), parameters.size());
+            for (std::size_t p = 0; p < bound; p++) {
+                std::string const &value = parameters.getStdVector()[p];
+                key.push_back('\n');
+                key.append(std::to_string(value.size()));
+                key.push_back(':');
+                key.append(value);
+            }
+            key.push_back('\n');
+            key.append(options.main_doc_property);
+            key.push_back('\n');
+            key.append(std::to_string(options.max_results));
+            key.push_back('\n');
+            key.append(options.sort_by);
+            // collapsing by nothing or keeping nothing per value doesn't collapse
+            if (!options.collapse_by.empty() && options.max_per_group > 0) {
+                key.push_back('\n');
+                key.append(options.collapse_by);
+                key.push_back('\n');
+                key.append(std::to_string(options.max_per_group));
+            }
+            return key;
+        }
+
+        /** A match's value of the property the results are sorted by */
+        struct SortKey {
+            enum Kind {
+                NUMBER,
+                STRING,
+                NO_VALUE
+            };
+
+            DocOrdinal ordinal;
+            Kind kind;
+            long number;
+            std::string const *text;
+        };
     }
 
     yuca::utils::List<SearchResult> Indexer::search(const std::string &query,
                                                     const std::string &opt_main_doc_property_for_query_comparison,
                                                     unsigned long opt_max_search_results) const {
-        SearchRequest search_request(query, implicit_group);
+        return search(prepare(query), yuca::utils::List<std::string>(), opt_main_doc_property_for_query_comparison,
+                      opt_max_search_results);
+    }
 
-        // 1. Get SETs of Documents (by group) whose StringKey's match at least one of the
-        // query keywords + corresponding groups as they come from the query string.
-        yuca::utils::Map<std::string, SPDocumentSet> groupSPDocumentSetMap = findDocuments(search_request);
+    PreparedQuery Indexer::prepare(const std::string &query_template) const {
+        return PreparedQuery(query_template, implicit_group);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(PreparedQuery const &prepared_query,
+                                                    yuca::utils::List<std::string> const &parameters,
+                                                    const std::string &opt_main_doc_property_for_query_comparison,
+                                                    unsigned long opt_max_search_results) const {
+        return search(prepared_query, parameters, opt_main_doc_property_for_query_comparison, opt_max_search_results,
+                      "");
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(const std::string &query,
+                                                    const std::string &opt_main_doc_property_for_query_comparison,
+                                                    unsigned long opt_max_search_results,
+                                                    const std::string &opt_sort_by) const {
+        return search(prepare(query), yuca::utils::List<std::string>(), opt_main_doc_property_for_query_comparison,
+                      opt_max_search_results, opt_sort_by);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(PreparedQuery const &prepared_query,
+                                                    yuca::utils::List<std::string> const &parameters,
+                                                    const std::string &opt_main_doc_property_for_query_comparison,
+                                                    unsigned long opt_max_search_results,
+                                                    const std::string &opt_sort_by) const {
+        SearchOptions options;
+        options.main_doc_property = opt_main_doc_property_for_query_comparison;
+        options.max_results = opt_max_search_results;
+        options.sort_by = opt_sort_by;
+        return search(prepared_query, parameters, options);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(const std::string &query,
+                                                    const std::string &opt_main_doc_property_for_query_comparison,
+                                                    unsigned long opt_max_search_results,
+                                                    yuca::utils::List<std::string> const &facet_groups,
+                                                    std::size_t max_facet_keys,
+                                                    yuca::utils::List<Facet> &facets) const {
+        SearchOptions options;
+        options.main_doc_property = opt_main_doc_property_for_query_comparison;
+        options.max_results = opt_max_search_results;
+        options.facet_groups = facet_groups;
+        options.max_facet_keys = max_facet_keys;
+        return search(query, options, facets);
+    }
 
-        // 1. Count document appearances per group
-        yuca::utils::Set<std::string> groups = groupSPDocumentSetMap.keySet();
-        yuca::utils::Map<SPDocument, unsigned int> spDocs_appearances(0);
-        for (auto const &group : groups.getStdSet()) {
-            SPDocumentSet spDocumentSet = groupSPDocumentSetMap.get(group);
-            // let's count doc appearances per group as a way to intersect those that match in all asked groups
-            for (auto const &spDocument : spDocumentSet.getStdSet()) {
-                spDocs_appearances.put(spDocument, 1 + spDocs_appearances.get(spDocument));
+    yuca::utils::List<SearchResult> Indexer::search(const std::string &query,
+                                                    const std::string &opt_main_doc_property_for_query_comparison,
+                                                    unsigned long opt_max_search_results,
+                                                    const std::string &opt_sort_by,
+                                                    const std::string &collapse_by,
+                                                    std::size_t max_per_group) const {
+        SearchOptions options;
+        options.main_doc_property = opt_main_doc_property_for_query_comparison;
+        options.max_results = opt_max_search_results;
+        options.sort_by = opt_sort_by;
+        options.collapse_by = collapse_by;
+        options.max_per_group = max_per_group;
+        return search(query, options);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(const std::string &query, SearchOptions const &options) const {
+        return search(prepare(query), yuca::utils::List<std::string>(), options);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(const std::string &query,
+                                                    SearchOptions const &options,
+                                                    yuca::utils::List<Facet> &facets) const {
+        return search(prepare(query), yuca::utils::List<std::string>(), options, facets);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(PreparedQuery const &prepared_query,
+                                                    yuca::utils::List<std::string> const &parameters,
+                                                    SearchOptions const &options) const {
+        yuca::utils::List<Facet> no_facets;
+        return search(prepared_query, parameters, options, no_facets);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(PreparedQuery const &prepared_query,
+                                                    yuca::utils::List<std::string> const &parameters,
+                                                    SearchOptions const &options,
+                                                    yuca::utils::List<Facet> &facets) const {
+        std::shared_ptr<SearchRequest> const &search_request_sp = prepared_query.getSearchRequestPtr();
+        SearchRequest const &search_request = *search_request_sp;
+        const bool counts_facets = !options.facet_groups.isEmpty();
+        const bool collapses = !options.collapse_by.empty() && options.max_per_group > 0;
+        facets.clear();
+
+        // 1. Evaluate the query tree over the posting lists of its keywords
+        yuca::utils::List<SearchResult> results;
+        if (!search_request.hasQuery() && !counts_facets) {
+            return results;
+        }
+        // the facets need every match, not the results the cache keeps
+        const bool cached = resultCache.isEnabled() && !counts_facets;
+        std::string cache_key;
+        if (cached) {
+            cache_key = resultCacheKey(prepared_query, parameters, options);
+            ResultCache::Entry entry;
+            if (resultCache.get(cache_key, [this](ResultCache::Entry const &current) {
+                return isCurrent(current);
+            }, entry)) {
+                results.getStdVector().reserve(entry.ordinals.size());
+                for (std::size_t i = 0; i < entry.ordinals.size(); i++) {
+                    SearchResult sr(search_request_sp, ordinalDocuments[entry.ordinals[i]]);
+                    sr.score = entry.scores[i];
+                    results.add(sr);
+                }
+                return results;
             }
         }
+        QueryPostings query_postings = resolvePostings(prepared_query, parameters);
+        const bool may_match = search_request.hasQuery() && estimateMatches(search_request, query_postings) > 0;
+        SortBy sort_by = SortBy::parse(options.sort_by);
+        const bool by_score = sort_by.property.empty();
 
-        // filter out those documents that didn't meet the minimum number of appearances, that didn't appear
-        // in ALL given group groups.
-        unsigned long num_group_groups = search_request.getGroups().size();
-        auto allSpDocsFound = spDocs_appearances.keySet().getStdSet();
-        SPDocumentSet intersectedSPDocumentSet;
-
-        if (num_group_groups > 1) {
-            for (auto const &spDoc : allSpDocsFound) {
-                if (spDocs_appearances.get(spDoc) == num_group_groups) {
-                    intersectedSPDocumentSet.add(spDoc);
+        // sorted by a numeric index the first matches can be found without evaluating the whole query,
+        // collapsed ones take a longer prefix until it holds the first values, each with all its results
+        std::vector<DocOrdinal> matches;
+        bool found_first = false;
+        if (may_match && !by_score && !counts_facets && options.max_results > 0) {
+            if (!collapses) {
+                found_first = findFirstSorted(search_request, query_postings, sort_by, options.max_results, matches);
+            } else {
+                for (unsigned long prefix = options.max_results * options.max_per_group;
+                     !found_first && findFirstSorted(search_request, query_postings, sort_by, prefix, matches);
+                     prefix *= 2) {
+                    yuca::utils::List<SearchResult> hits = rankMatches(prepared_query, parameters, matches,
+                                                                       query_postings, options.main_doc_property,
+                                                                       0, false);
+                    results = collapseHits(hits.getStdVector(), matches, options, false, found_first);
                 }
             }
-        } else {
-            intersectedSPDocumentSet = spDocs_appearances.keySet();
         }
+        if (!found_first) {
+            matches.clear();
+            if (may_match) {
+                matches = evaluateMatches(search_request, query_postings);
+            }
+            if (counts_facets) {
+                DocBitmap match_bitmap(ordinalDocuments.size());
+                match_bitmap.orWith(OrdinalRange(matches));
+                for (auto const &group : options.facet_groups.getStdVector()) {
+                    facets.add(countFacet(group, matches, match_bitmap, options.max_facet_keys));
+                }
+            }
+            if (!by_score) {
+                // collapsing needs every match in order, the best of a value can come after many others
+                sortMatches(matches, sort_by, collapses ? 0 : options.max_results);
+            }
+            if (collapses) {
+                // every match is scored, or sorted, but only the best of each value are kept
+                yuca::utils::List<SearchResult> hits = rankMatches(prepared_query, parameters, matches,
+                                                                   query_postings, options.main_doc_property, 0,
+                                                                   false);
+                bool complete;
+                results = collapseHits(hits.getStdVector(), matches, options, by_score, complete);
+            } else {
+                results = rankMatches(prepared_query, parameters, matches, query_postings,
+                                      options.main_doc_property, options.max_results, by_score);
+            }
+        } else if (!collapses) {
+            results = rankMatches(prepared_query, parameters, matches, query_postings, options.main_doc_property,
+                                  options.max_results, false);
+        }
+        if (cached) {
+            resultCache.put(cache_key, makeCacheEntry(prepared_query, results));
+        }
+        return results;
+    }
 
-        // Up to this point we have intersected (narrowed down) documents because they have matched
-        // all the groups or groups specified in the search, now we need to see
-        // why. How many of the given keywords in the search are matched by these guys.
+    yuca::utils::List<SearchResult> Indexer::collapseHits(std::vector<SearchResult> const &hits,
+                                                          std::vector<DocOrdinal> const &matches,
+                                                          SearchOptions const &options,
+                                                          bool by_score,
+                                                          bool &complete) const {
+        // results in sort_by order are already best first, scored ones are best first by score, then ordinal
+        auto better = [&hits, by_score](std::size_t a, std::size_t b) {
+            if (by_score && hits[a].score != hits[b].score) {
+                return hits[a].score > hits[b].score;
+            }
+            return a < b;
+        };
+
+        // a bounded heap per value, its worst result on top. Documents without a value are alone in theirs
+        std::unordered_map<std::string, std::size_t> group_indices;
+        std::vector<std::vector<std::size_t>> groups;
+        std::vector<bool> keyed_groups;
+        std::string collapse_key;
+        for (std::size_t i = 0; i < hits.size(); i++) {
+            std::size_t group_index = groups.size();
+            bool keyed = findCollapseKey(options.collapse_by, matches[i], collapse_key);
+            if (keyed) {
+                group_index = group_indices.insert(std::make_pair(collapse_key, groups.size())).first->second;
+            }
+            if (group_index == groups.size()) {
+                groups.emplace_back();
+                keyed_groups.push_back(keyed);
+            }
+            std::vector<std::size_t> &group = groups[group_index];
+            if (group.size() < options.max_per_group) {
+                group.push_back(i);
+                std::push_heap(group.begin(), group.end(), better);
+            } else if (better(i, group.front())) {
+                std::pop_heap(group.begin(), group.end(), better);
+                group.back() = i;
+                std::push_heap(group.begin(), group.end(), better);
+            }
+        }
+        for (auto &group : groups) {
+            std::sort_heap(group.begin(), group.end(), better);
+        }
 
-        // 3. create search results and score them
-        std::shared_ptr<SearchRequest> search_request_sp = std::make_shared<SearchRequest>(search_request);
+        // the values with the best results, best first
+        std::vector<std::size_t> group_order(groups.size());
+        for (std::size_t g = 0; g < groups.size(); g++) {
+            group_order[g] = g;
+        }
+        auto better_group = [&groups, &better](std::size_t a, std::size_t b) {
+            return better(groups[a].front(), groups[b].front());
+        };
+        if (options.max_results > 0 && options.max_results < group_order.size()) {
+            std::partial_sort(group_order.begin(), group_order.begin() + static_cast<long>(options.max_results),
+                              group_order.end(), better_group);
+            group_order.resize(options.max_results);
+        } else {
+            std::sort(group_order.begin(), group_order.end(), better_group);
+        }
+        complete = options.max_results > 0 && group_order.size() == options.max_results;
         yuca::utils::List<SearchResult> results;
-        std::set<std::string> search_groups = search_request.group_keywords_map.keySet().getStdSetCopy();
+        for (std::size_t group_index : group_order) {
+            if (keyed_groups[group_index] && groups[group_index].size() < options.max_per_group) {
+                complete = false;
+            }
+            for (std::size_t i : groups[group_index]) {
+                results.add(hits[i]);
+            }
+        }
+        return results;
+    }
+
+    bool Indexer::findCollapseKey(std::string const &collapse_by, DocOrdinal ordinal,
+                                  std::string &collapse_key) const {
+        if (collapse_by[0] == ':') {
+            SPStringKeySet keys = ordinalDocuments[ordinal]->getGroupSPKeys(collapse_by);
+            if (keys.isEmpty()) {
+                return false;
+            }
+            collapse_key = (*keys.getStdSet().begin())->getString();
+            for (auto const &key : keys.getStdSet()) {
+                collapse_key = std::min(collapse_key, key->getString());
+            }
+            return true;
+        }
+        PropertyId property = columns.findProperty(collapse_by);
+        if (property == ColumnStore::NO_PROPERTY) {
+            return false;
+        }
+        if (columns.stringColumn(property)->hasValue(ordinal)) {
+            collapse_key = columns.stringColumn(property)->get(ordinal);
+        } else if (columns.longColumn(property)->hasValue(ordinal)) {
+            collapse_key = std::to_string(columns.longColumn(property)->get(ordinal));
+        } else if (columns.intColumn(property)->hasValue(ordinal)) {
+            collapse_key = std::to_string(columns.intColumn(property)->get(ordinal));
+        } else if (columns.byteColumn(property)->hasValue(ordinal)) {
+            collapse_key = std::to_string(columns.byteColumn(property)->get(ordinal));
+        } else if (columns.boolColumn(property)->hasValue(ordinal)) {
+            collapse_key = columns.boolColumn(property)->get(ordinal) ? "true" : "false";
+        } else {
+            return false;
+        }
+        return true;
+    }
 
-        for (auto const &doc_sp : intersectedSPDocumentSet.getStdSet()) {
-            SearchResult sr(search_request_sp, doc_sp);
+    yuca::utils::List<NumericAggregation> Indexer::aggregate(const std::string &query,
+                                                             yuca::utils::List<std::string> const &properties,
+                                                             long histogram_interval) const {
+        PreparedQuery prepared_query = prepare(query);
+        SearchRequest const &search_request = prepared_query.getSearchRequest();
+        QueryPostings query_postings = resolvePostings(prepared_query, yuca::utils::List<std::string>());
+        std::vector<DocOrdinal> matches;
+        if (search_request.hasQuery() && estimateMatches(search_request, query_postings) > 0) {
+            matches = evaluateMatches(search_request, query_postings);
+        }
+        DocBitmap match_bitmap(ordinalDocuments.size());
+        match_bitmap.orWith(OrdinalRange(matches));
+        yuca::utils::List<NumericAggregation> results;
+        for (auto const &property : properties.getStdVector()) {
+            results.add(aggregations::aggregate(columns, property, match_bitmap, histogram_interval));
+        }
+        return results;
+    }
 
-            for (auto const &group : search_groups) {
-                std::shared_ptr<ReverseIndex> group_r_index = getReverseIndex(group);
-                StringKeySet documentGroupKeys = doc_sp->getGroupKeys(group);
-                yuca::utils::List<std::string> search_keywords = search_request.group_keywords_map.get(group);
+    yuca::utils::List<SearchResult> Indexer::rankMatches(PreparedQuery const &prepared_query,
+                                                         yuca::utils::List<std::string> const &parameters,
+                                                         std::vector<DocOrdinal> const &matches,
+                                                         QueryPostings const &query_postings,
+                                                         const std::string &opt_main_doc_property_for_query_comparison,
+                                                         unsigned long opt_max_search_results,
+                                                         bool order_by_score) const {
+        SearchRequest const &search_request = prepared_query.getSearchRequest();
+        std::vector<OrdinalRange> const &term_postings = query_postings.terms;
+        yuca::utils::List<SearchResult> results;
 
-                for (auto const &keyword : search_keywords.getStdVector()) {
-                    StringKey searchStringKey(keyword, group);
-                    if (documentGroupKeys.contains(searchStringKey)) {
-                        sr.score++;
-                    }
+        // 2. create search results and score them by how many of the keywords that can match they match
+        results.getStdVector().reserve(matches.size());
+        for (DocOrdinal ordinal : matches) {
+            SearchResult sr(prepared_query.getSearchRequestPtr(), ordinalDocuments[ordinal]);
+            for (std::uint32_t t = 0; t < search_request.getTermCount(); t++) {
+                if (search_request.getTerm(t).occur != SearchRequest::MUST_NOT && term_postings[t].contains(ordinal)) {
+                    sr.score++;
                 }
             }
-
-            if (sr.score > 0) {
-                results.add(sr);
-            }
+            results.add(sr);
         }
 
-        // 4. if we were given a valid document property name to perform a Levenshtein distance
+        // 3. if we were given a valid document property name to perform a Levenshtein distance
         // calculation we'll try to rank results by scoring higher those that get the lowest
         if (opt_main_doc_property_for_query_comparison.length() > 0) {
+            std::string query = prepared_query.bind(parameters);
+            // 1 / LD is 0 past 1 edit, so only the results that can be within 1 edit are worth the distance
+            auto trigram_index_it = trigramIndices.find(opt_main_doc_property_for_query_comparison);
+            std::vector<DocOrdinal> close_matches;
+            if (trigram_index_it != trigramIndices.end()) {
+                close_matches = matches;
+                trigram_index_it->second.keepPossiblyWithin(query, 1, close_matches);
+            }
+            PropertyColumn<std::string> const *column =
+                columns.stringColumn(columns.findProperty(opt_main_doc_property_for_query_comparison));
+            std::size_t result_index = 0;
             for (auto &sr : results.getStdVector()) {
-                std::string target_string = sr.document_sp->stringProperty(opt_main_doc_property_for_query_comparison);
+                DocOrdinal ordinal = matches[result_index++];
+                if (column == nullptr) {
+                    break;
+                }
+                if (trigram_index_it != trigramIndices.end() &&
+                    !std::binary_search(close_matches.begin(), close_matches.end(), ordinal)) {
+                    continue;
+                }
+                std::string const &target_string = column->get(ordinal);
                 if (target_string.length() == 0) {
                     continue;
                 }
@@ -325,12 +1092,14 @@ namespace yuca {
             }
         }
 
-        // 5. sort list by final score
-        auto v = results.getStdVectorCopy();
-        std::sort(v.begin(), v.end(), SearchResultSortFunctor());
-        results.clear();
-        for (auto const &result : v) {
-            results.add(result);
+        // 4. sort list by final score
+        if (order_by_score) {
+            auto v = results.getStdVectorCopy();
+            std::sort(v.begin(), v.end(), SearchResultSortFunctor());
+            results.clear();
+            for (auto const &result : v) {
+                results.add(result);
+            }
         }
         if (opt_max_search_results > 0) {
             results = results.subList(0, opt_max_search_results);
@@ -338,37 +1107,228 @@ namespace yuca {
         return results;
     }
 
-    yuca::utils::List<SearchResult> Indexer::search(const std::string &query) {
-        return search(query, "", 0);
+    void Indexer::sortMatches(std::vector<DocOrdinal> &matches, SortBy const &sort_by,
+                              unsigned long max_results) const {
+        std::vector<SortKey> keys;
+        keys.reserve(matches.size());
+        PropertyId property = columns.findProperty(sort_by.property);
+        for (DocOrdinal ordinal : matches) {
+            SortKey key = {ordinal, SortKey::NO_VALUE, 0, nullptr};
+            if (property == ColumnStore::NO_PROPERTY) {
+                // nobody has the property
+            } else if (columns.longColumn(property)->hasValue(ordinal)) {
+                key.kind = SortKey::NUMBER;
+                key.number = columns.longColumn(property)->get(ordinal);
+            } else if (columns.intColumn(property)->hasValue(ordinal)) {
+                key.kind = SortKey::NUMBER;
+                key.number = columns.intColumn(property)->get(ordinal);
+            } else if (columns.byteColumn(property)->hasValue(ordinal)) {
+                key.kind = SortKey::NUMBER;
+                key.number = columns.byteColumn(property)->get(ordinal);
+            } else if (columns.boolColumn(property)->hasValue(ordinal)) {
+                key.kind = SortKey::NUMBER;
+                key.number = columns.boolColumn(property)->get(ordinal) ? 1 : 0;
+            } else if (columns.stringColumn(property)->hasValue(ordinal)) {
+                key.kind = SortKey::STRING;
+                key.text = &columns.stringColumn(property)->get(ordinal);
+            }
+            keys.push_back(key);
+        }
+        const bool descending = sort_by.descending;
+        auto before = [descending](SortKey const &a, SortKey const &b) {
+            if (a.kind != b.kind) {
+                // documents without a value go last either way
+                if (a.kind == SortKey::NO_VALUE || b.kind == SortKey::NO_VALUE) {
+                    return b.kind == SortKey::NO_VALUE;
+                }
+                return descending ? a.kind > b.kind : a.kind < b.kind;
+            }
+            int comparison = 0;
+            if (a.kind == SortKey::NUMBER) {
+                comparison = a.number < b.number ? -1 : (a.number > b.number ? 1 : 0);
+            } else if (a.kind == SortKey::STRING) {
+                comparison = a.text->compare(*b.text);
+            }
+            if (comparison == 0) {
+                comparison = a.ordinal < b.ordinal ? -1 : (a.ordinal > b.ordinal ? 1 : 0);
+            }
+            return descending ? comparison > 0 : comparison < 0;
+        };
+        if (max_results > 0 && max_results < keys.size()) {
+            // a heap of the first max_results
+            std::partial_sort(keys.begin(), keys.begin() + static_cast<long>(max_results), keys.end(), before);
+            keys.resize(max_results);
+        } else {
+            std::sort(keys.begin(), keys.end(), before);
+        }
+        matches.clear();
+        for (auto const &key : keys) {
+            matches.push_back(key.ordinal);
+        }
     }
 
-    yuca::utils::List<SearchResult> Indexer::search(const std::string &query,
-                                                    const std::string &opt_main_doc_property_for_query_comparison) {
+    bool Indexer::findFirstSorted(SearchRequest const &search_request,
+                                  QueryPostings const &query_postings,
+                                  SortBy const &sort_by,
+                                  unsigned long max_results,
+                                  std::vector<DocOrdinal> &first) const {
+        if (max_results == 0 || numericIndices.empty()) {
+            return false;
+        }
+        auto numeric_index_it = numericIndices.find(sort_by.property);
+        PropertyId property = columns.findProperty(sort_by.property);
+        if (numeric_index_it == numericIndices.end() || property == ColumnStore::NO_PROPERTY) {
+            return false;
+        }
+        // byte, bool and string values aren't in the numeric index but they'd sort among its values
+        if (columns.byteColumn(property)->getValueCount() > 0 || columns.boolColumn(property)->getValueCount() > 0 ||
+            columns.stringColumn(property)->getValueCount() > 0) {
+            return false;
+        }
+        std::vector<NumericIndex::Entry> const &entries = numeric_index_it->second.getSortedEntries();
+        first.clear();
+        std::vector<DocOrdinal> block;
+        std::vector<DocOrdinal> candidates;
+        std::size_t block_size = std::max<std::size_t>(64, 2 * max_results);
+        for (std::size_t done = 0; done < entries.size() && first.size() < max_results; block_size *= 2) {
+            std::size_t block_end = std::min(entries.size(), done + block_size);
+            block.clear();
+            for (std::size_t i = done; i < block_end; i++) {
+                block.push_back(entries[sort_by.descending ? entries.size() - 1 - i : i].second);
+            }
+            done = block_end;
+            candidates = block;
+            std::sort(candidates.begin(), candidates.end());
+            filterMatches(search_request, query_postings, candidates);
+            for (std::size_t i = 0; i < block.size() && first.size() < max_results; i++) {
+                if (std::binary_search(candidates.begin(), candidates.end(), block[i])) {
+                    first.push_back(block[i]);
+                }
+            }
+        }
+        return first.size() == max_results;
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(SearchSession &session,
+                                                    const std::string &query,
+                                                    const std::string &opt_main_doc_property_for_query_comparison,
+                                                    unsigned long opt_max_search_results) const {
+        PreparedQuery prepared_query = prepare(SearchSession::typeAheadQuery(query));
+        SearchRequest const &search_request = prepared_query.getSearchRequest();
+        yuca::utils::List<std::string> no_parameters;
+        if (!search_request.hasQuery()) {
+            session.reset();
+            return yuca::utils::List<SearchResult>();
+        }
+        bool refinable = session.previous_request != nullptr &&
+                         session.previous_indexer == this &&
+                         session.previous_documents_generation == documentsGeneration &&
+                         session.previous_settings_generation == settingsGeneration &&
+                         session.previous_expansions_complete &&
+                         SearchSession::isRefinement(*session.previous_request, search_request);
+        // a refinement only needs the expansions of its terms for the previous matches, so these are probed
+        // instead of merging every key's postings of the growing prefix
+        QueryPostings query_postings =
+            resolvePostings(prepared_query, no_parameters, refinable ? &session.previous_matches : nullptr);
+        if (refinable && query_postings.expanded_synonyms) {
+            refinable = false;
+            query_postings = resolvePostings(prepared_query, no_parameters);
+        }
+        std::vector<DocOrdinal> matches;
+        if (refinable) {
+            // the new matches are a subset of the previous ones, only those need to be looked at
+            matches = session.previous_matches;
+            filterMatches(search_request, query_postings, matches);
+            session.incremental_searches++;
+        } else {
+            if (estimateMatches(search_request, query_postings) > 0) {
+                matches = evaluateMatches(search_request, query_postings);
+            }
+            session.full_searches++;
+        }
+        session.previous_request = prepared_query.getSearchRequestPtr();
+        session.previous_matches = matches;
+        session.previous_indexer = this;
+        session.previous_documents_generation = documentsGeneration;
+        session.previous_settings_generation = settingsGeneration;
+        session.previous_expansions_complete = !query_postings.truncated_expansions;
+        return rankMatches(prepared_query, no_parameters, matches, query_postings,
+                           opt_main_doc_property_for_query_comparison, opt_max_search_results);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(const std::string &query) {
+        return search(query, "", 0);
+    }
+
+    yuca::utils::List<SearchResult> Indexer::search(const std::string &query,
+                                                    const std::string &opt_main_doc_property_for_query_comparison) {
         return search(query, opt_main_doc_property_for_query_comparison, 0);
     }
 
-    yuca::utils::Map<std::string, SPDocumentSet> Indexer::findDocuments(SearchRequest &search_request) const {
+    yuca::utils::List<SearchResult> Indexer::search(PreparedQuery const &prepared_query,
+                                                    yuca::utils::List<std::string> const &parameters) const {
+        return search(prepared_query, parameters, "", 0);
+    }
+
+    yuca::utils::Map<std::string, SPDocumentSet> Indexer::findDocuments(SearchRequest const &search_request) const {
         SPDocumentSet emptyDocSet;
         yuca::utils::Map<std::string, SPDocumentSet> r(emptyDocSet);
 
-        yuca::utils::List<std::string> search_groups = search_request.getGroups();
-        for (auto &group : search_groups.getStdVector()) {
-            SPDocumentSet matchedSPDocSet;
-            SPKeyList search_spkey_list;
-            yuca::utils::List<std::string> keywords = search_request.getKeywords(group);
+        // 1. posting list sizes are enough to know whether every group has a match
+        yuca::utils::SmallVector<ReverseIndex const *, 4> group_indices;
+        yuca::utils::SmallVector<long, 4> group_ids;
+        for (std::size_t g = 0; g < search_request.getGroupCount(); g++) {
+            yuca::utils::StringView group = search_request.getGroup(g);
+            long group_id = StringKey::groupId(group);
+            ReverseIndex const *r_index = findReverseIndex(group_id, group);
+            group_indices.add(r_index);
+            group_ids.add(group_id);
+            if (search_request.getKeywordCount(g) == 0) {
+                continue;
+            }
+            bool has_matches = false;
+            for (std::size_t k = 0; r_index != nullptr && k < search_request.getKeywordCount(g) && !has_matches; k++) {
+                yuca::utils::StringView keyword = search_request.getKeyword(g, k);
+                has_matches = !r_index->findPostings(StringKey::keyId(group_id, keyword), keyword).isEmpty();
+            }
+            if (!has_matches) {
+                return r;
+            }
+        }
 
-            for (auto keyword : keywords.getStdVector()) {
-                search_spkey_list.add(std::make_shared<StringKey>(keyword, group));
+        // 2. build the sets
+        for (std::size_t g = 0; g < search_request.getGroupCount(); g++) {
+            ReverseIndex const *r_index = group_indices[g];
+            if (r_index == nullptr) {
+                continue;
+            }
+            SPDocumentSet group_matched_spDoc_set;
+            for (std::size_t k = 0; k < search_request.getKeywordCount(g); k++) {
+                yuca::utils::StringView keyword = search_request.getKeyword(g, k);
+                SPDocumentSet const &docs = r_index->findDocuments(StringKey::keyId(group_ids[g], keyword), keyword);
+                group_matched_spDoc_set.getStdSet().insert(docs.getStdSet().begin(), docs.getStdSet().end());
             }
-            SPDocumentSet group_matched_spDoc_set = findDocuments(search_spkey_list);
             if (!group_matched_spDoc_set.isEmpty()) {
-                matchedSPDocSet.addAll(group_matched_spDoc_set);
-                r.put(group, matchedSPDocSet);
+                r.getStdMap().insert(std::make_pair(search_request.getGroup(g).toString(),
+                                                    std::move(group_matched_spDoc_set)));
             }
         }
         return r;
     }
 
+    SPDocumentSet const &Indexer::findDocuments(StringKeyView const &key) const {
+        ReverseIndex const *r_index = findReverseIndex(key.group_id, key.group);
+        if (r_index == nullptr) {
+            return ReverseIndex::NO_DOCUMENTS;
+        }
+        return r_index->findDocuments(key.id, key.string_key);
+    }
+
+    SPDocumentSet const &Indexer::findDocuments(yuca::utils::StringView string_key,
+                                                yuca::utils::StringView group) const {
+        return findDocuments(StringKeyView(string_key, group));
+    }
+
     SPDocumentSet Indexer::findDocuments(SPKey key) const {
         // code remains in commented for step-by-step debugging purposes
         //std::shared_ptr<ReverseIndex>spRIndex = getReverseIndex((key->getGroup()));
@@ -401,19 +1361,915 @@ namespace yuca {
         }
         // Make sure there's a ReverseIndex, if there isn't one, create an empty one
         std::shared_ptr<ReverseIndex> r_index = getReverseIndex(group);
+        DocOrdinal ordinal = docOrdinals.get(doc->getId());
         for (auto const &k_sp : doc_keys.getStdSet()) {
-            r_index->putDocument(k_sp, doc);
+            r_index->putDocument(k_sp, doc, ordinal);
+        }
+        if (r_index->keepsPositions()) {
+            putPositions(*r_index, group, doc, ordinal);
         }
         reverseIndices.put(group, r_index);
+        // on the (unlikely) event of two group names sharing a hash the first one keeps the slot,
+        // the other one is found through reverseIndices by findReverseIndex
+        groupIdReverseIndices.getStdMap().insert(std::make_pair(StringKey::groupId(group), r_index));
+    }
+
+    void Indexer::removeReverseIndex(std::string const &group) {
+        std::shared_ptr<ReverseIndex> r_index = reverseIndices.remove(group);
+        long group_id = StringKey::groupId(group);
+        if (groupIdReverseIndices.get(group_id) == r_index) {
+            groupIdReverseIndices.remove(group_id);
+        }
+    }
+
+    DocOrdinal Indexer::assignOrdinal(SPDocument const &doc) {
+        auto ordinal_it = docOrdinals.getStdMap().find(doc->getId());
+        if (ordinal_it != docOrdinals.getStdMap().end()) {
+            ordinalDocuments[ordinal_it->second] = doc;
+            return ordinal_it->second;
+        }
+        DocOrdinal ordinal;
+        if (!freeOrdinals.empty()) {
+            ordinal = freeOrdinals.back();
+            freeOrdinals.pop_back();
+            ordinalDocuments[ordinal] = doc;
+        } else {
+            ordinal = static_cast<DocOrdinal>(ordinalDocuments.size());
+            ordinalDocuments.push_back(doc);
+        }
+        docOrdinals.put(doc->getId(), ordinal);
+        liveDocuments.set(ordinal);
+        return ordinal;
+    }
+
+    Indexer::QueryPostings Indexer::resolvePostings(PreparedQuery const &prepared_query,
+                                                    yuca::utils::List<std::string> const &parameters,
+                                                    std::vector<DocOrdinal> const *candidates) const {
+        SearchRequest const &search_request = prepared_query.getSearchRequest();
+        QueryPostings query_postings;
+        yuca::utils::SmallVector<ReverseIndex const *, 4> group_indices;
+        for (std::uint32_t g = 0; g < search_request.getGroupCount(); g++) {
+            ReverseIndex const *r_index = findReverseIndex(prepared_query.getGroupId(g), search_request.getGroup(g));
+            group_indices.add(r_index);
+            std::size_t group_size = r_index == nullptr ? 0 : r_index->getDocumentCount();
+            if (!numericIndices.empty()) {
+                auto numeric_index_it = numericIndices.find(groupProperty(search_request.getGroup(g)));
+                if (numeric_index_it != numericIndices.end()) {
+                    group_size = std::max(group_size, numeric_index_it->second.getDocumentCount());
+                }
+            }
+            query_postings.group_sizes.push_back(group_size);
+        }
+        query_postings.terms.reserve(search_request.getTermCount());
+        query_postings.positions.resize(search_request.getTermCount(), nullptr);
+        // reserved so that the ranges pointing into the expansions don't move
+        query_postings.expansions.reserve(search_request.getTermCount());
+        for (std::uint32_t t = 0; t < search_request.getTermCount(); t++) {
+            if (search_request.getTerm(t).type == SearchRequest::RANGE) {
+                query_postings.expansions.push_back(findRange(search_request.getGroup(search_request.getTerm(t).group),
+                                                              search_request.getTermString(t)));
+                query_postings.terms.push_back(OrdinalRange(query_postings.expansions.back()));
+                continue;
+            }
+            ReverseIndex const *r_index = group_indices[search_request.getTerm(t).group];
+            if (r_index == nullptr) {
+                query_postings.terms.push_back(OrdinalRange());
+                continue;
+            }
+            SearchRequest::TermType term_type = prepared_query.getTermType(t, parameters);
+            if (term_type != SearchRequest::EXACT) {
+                yuca::utils::StringView keyword = SearchRequest::stripOperator(prepared_query.getKeyword(t, parameters),
+                                                                               term_type);
+                std::vector<OrdinalRange> expanded;
+                if (term_type == SearchRequest::PREFIX) {
+                    expanded = r_index->findPrefixPostings(keyword, maxTermExpansions);
+                } else if (term_type == SearchRequest::WILDCARD) {
+                    expanded = r_index->findWildcardPostings(keyword, maxTermExpansions);
+                } else {
+                    expanded = r_index->findFuzzyPostings(keyword, search_request.getTerm(t).max_edits,
+                                                          maxTermExpansions);
+                }
+                if (expanded.size() >= maxTermExpansions) {
+                    query_postings.truncated_expansions = true;
+                }
+                std::size_t expanded_total = 0;
+                for (auto const &list : expanded) {
+                    expanded_total += list.size();
+                }
+                if (candidates != nullptr && expanded.size() * candidates->size() < expanded_total) {
+                    // probing each list for the few candidates is cheaper than merging the lists
+                    query_postings.expansions.push_back(*candidates);
+                    postings::intersectWithAny(query_postings.expansions.back(), expanded);
+                } else {
+                    query_postings.expansions.push_back(postings::unionAll(expanded, ordinalDocuments.size()));
+                }
+                query_postings.terms.push_back(OrdinalRange(query_postings.expansions.back()));
+                continue;
+            }
+            long key_id = prepared_query.getKeyId(t, parameters);
+            yuca::utils::StringView keyword = prepared_query.getKeyword(t, parameters);
+            yuca::utils::StringView group = search_request.getGroup(search_request.getTerm(t).group);
+            SynonymExpansion const *synonym_expansion = synonyms.empty() ? nullptr :
+                                                        findSynonyms(key_id, group, keyword);
+            if (synonym_expansion != nullptr) {
+                // the keyword and its synonyms are one term, an OR of their postings
+                std::vector<OrdinalRange> alternatives(1, r_index->findPostings(key_id, keyword).range());
+                for (auto const &synonym : synonym_expansion->synonyms) {
+                    alternatives.push_back(r_index->findPostings(synonym.first, synonym.second).range());
+                }
+                query_postings.expansions.push_back(postings::unionAll(alternatives, ordinalDocuments.size()));
+                query_postings.terms.push_back(OrdinalRange(query_postings.expansions.back()));
+                query_postings.expanded_synonyms = true;
+                continue;
+            }
+            query_postings.terms.push_back(r_index->findPostings(key_id, keyword).range());
+            if (r_index->keepsPositions()) {
+                query_postings.positions[t] = &r_index->findPositions(key_id, keyword);
+            }
+        }
+        if (search_request.getFilterCount() > 0) {
+            query_postings.filter = liveDocuments;
+            for (std::size_t f = 0; f < search_request.getFilterCount(); f++) {
+                applyFilter(search_request, f, query_postings.filter);
+            }
+            query_postings.filter_count = query_postings.filter.count();
+        }
+        return query_postings;
+    }
+
+    void Indexer::applyFilter(SearchRequest const &search_request, std::size_t filter_index,
+                              DocBitmap &filter) const {
+        PropertyId property = columns.findProperty(search_request.getFilterProperty(filter_index).toString());
+        yuca::utils::StringView value = search_request.getFilterValue(filter_index);
+        if (property == ColumnStore::NO_PROPERTY) {
+            filter.clear();
+        } else if (value == "true") {
+            filter.andWith(*columns.trueBitmap(property));
+        } else if (value == "false") {
+            filter.andWith(columns.boolColumn(property)->getPresence());
+            filter.andNot(*columns.trueBitmap(property));
+        } else {
+            // a byte given as a number, or as the character itself
+            long number = 0;
+            DocBitmap const *byte_bitmap = nullptr;
+            if (NumericIndex::parseLong(value, number)) {
+                if (number >= -128 && number <= 255) {
+                    byte_bitmap = columns.byteValueBitmap(property, static_cast<char>(number));
+                }
+            } else if (value.size() == 1) {
+                byte_bitmap = columns.byteValueBitmap(property, value[0]);
+            }
+            if (byte_bitmap == nullptr) {
+                filter.clear();
+            } else {
+                filter.andWith(*byte_bitmap);
+            }
+        }
+    }
+
+    std::size_t Indexer::estimateMatches(SearchRequest const &search_request,
+                                         QueryPostings const &query_postings) const {
+        std::size_t estimated = ordinalDocuments.size();
+        if (search_request.getRoot() != SearchRequest::NO_NODE) {
+            estimated = estimate(search_request, search_request.getRoot(), query_postings);
+        }
+        if (search_request.getFilterCount() > 0) {
+            estimated = std::min(estimated, query_postings.filter_count);
+        }
+        return estimated;
+    }
+
+    std::vector<DocOrdinal> Indexer::evaluateMatches(SearchRequest const &search_request,
+                                                     QueryPostings const &query_postings) const {
+        if (search_request.getFilterCount() == 0) {
+            return evaluate(search_request, search_request.getRoot(), query_postings);
+        }
+        std::vector<DocOrdinal> matches;
+        if (search_request.getRoot() == SearchRequest::NO_NODE ||
+            query_postings.filter_count < estimate(search_request, search_request.getRoot(), query_postings)) {
+            matches.reserve(query_postings.filter_count);
+            query_postings.filter.toOrdinals(matches);
+            if (search_request.getRoot() != SearchRequest::NO_NODE) {
+                filter(search_request, search_request.getRoot(), query_postings, matches);
+            }
+        } else {
+            matches = evaluate(search_request, search_request.getRoot(), query_postings);
+            postings::intersectWith(matches, query_postings.filter);
+        }
+        return matches;
+    }
+
+    void Indexer::filterMatches(SearchRequest const &search_request,
+                                QueryPostings const &query_postings,
+                                std::vector<DocOrdinal> &candidates) const {
+        if (search_request.getFilterCount() > 0) {
+            postings::intersectWith(candidates, query_postings.filter);
+        }
+        if (search_request.getRoot() != SearchRequest::NO_NODE) {
+            filter(search_request, search_request.getRoot(), query_postings, candidates);
+        }
+    }
+
+    Indexer::SynonymExpansion const *Indexer::findSynonyms(long key_id,
+                                                           yuca::utils::StringView group,
+                                                           yuca::utils::StringView keyword) const {
+        auto bucket_it = synonyms.find(key_id);
+        if (bucket_it == synonyms.end()) {
+            return nullptr;
+        }
+        for (auto const &synonym_expansion : bucket_it->second) {
+            if (group == synonym_expansion.group && keyword == synonym_expansion.keyword) {
+                return &synonym_expansion;
+            }
+        }
+        return nullptr;
+    }
+
+    void Indexer::addSynonym(std::string const &group, std::string const &keyword, std::string const &synonym) {
+        long key_id = StringKey::keyId(StringKey::groupId(group), keyword);
+        auto &bucket = synonyms[key_id];
+        auto synonym_expansion_it = std::find_if(bucket.begin(), bucket.end(),
+                                                 [&group, &keyword](SynonymExpansion const &synonym_expansion) {
+                                                     return synonym_expansion.group == group &&
+                                                            synonym_expansion.keyword == keyword;
+                                                 });
+        if (synonym_expansion_it == bucket.end()) {
+            bucket.push_back(SynonymExpansion{group, keyword, {}});
+            synonym_expansion_it = bucket.end() - 1;
+        }
+        auto synonym_key = std::make_pair(StringKey::keyId(StringKey::groupId(group), synonym), synonym);
+        auto &expansion_synonyms = synonym_expansion_it->synonyms;
+        if (synonym != keyword &&
+            std::find(expansion_synonyms.begin(), expansion_synonyms.end(), synonym_key) == expansion_synonyms.end()) {
+            expansion_synonyms.push_back(synonym_key);
+        }
+        settingsGeneration++;
+        resultCache.clear();
+    }
+
+    void Indexer::removeSynonyms(std::string const &group, std::string const &keyword) {
+        auto bucket_it = synonyms.find(StringKey::keyId(StringKey::groupId(group), keyword));
+        if (bucket_it == synonyms.end()) {
+            return;
+        }
+        auto &bucket = bucket_it->second;
+        bucket.erase(std::remove_if(bucket.begin(), bucket.end(),
+                                    [&group, &keyword](SynonymExpansion const &synonym_expansion) {
+                                        return synonym_expansion.group == group &&
+                                               synonym_expansion.keyword == keyword;
+                                    }), bucket.end());
+        if (bucket.empty()) {
+            synonyms.erase(bucket_it);
+        }
+        settingsGeneration++;
+        resultCache.clear();
+    }
+
+    yuca::utils::List<std::string> Indexer::getSynonyms(std::string const &group, std::string const &keyword) const {
+        yuca::utils::List<std::string> synonyms_out;
+        SynonymExpansion const *synonym_expansion = findSynonyms(StringKey::keyId(StringKey::groupId(group), keyword),
+                                                                 group, keyword);
+        if (synonym_expansion != nullptr) {
+            for (auto const &synonym : synonym_expansion->synonyms) {
+                synonyms_out.add(synonym.second);
+            }
+        }
+        return synonyms_out;
+    }
+
+    std::size_t Indexer::estimate(SearchRequest const &search_request,
+                                  std::uint32_t node_index,
+                                  QueryPostings const &query_postings) const {
+        SearchRequest::QueryNode const &node = search_request.getNode(node_index);
+        const std::size_t live_count = docOrdinals.size();
+
+        if (node.type == SearchRequest::QueryNode::OR) {
+            std::size_t total = 0;
+            for (std::uint32_t child : node.children) {
+                total += estimate(search_request, child, query_postings);
+            }
+            return std::min(total, live_count);
+        }
+
+        if (node.type == SearchRequest::QueryNode::AND) {
+            std::vector<std::uint32_t> plan = planAnd(search_request, node, query_postings);
+            return plan.empty() ? live_count : estimate(search_request, plan[0], query_postings);
+        }
+
+        ClauseLists lists = splitClause(search_request, node, query_postings.terms);
+        if (node.min_should_match > lists.optional.size()) {
+            return 0;
+        }
+        if (!lists.required.empty()) {
+            std::size_t smallest = lists.required[0].size();
+            for (auto const &list : lists.required) {
+                smallest = std::min(smallest, list.size());
+            }
+            return smallest;
+        }
+        if (lists.optional.empty()) {
+            return live_count;
+        }
+        std::size_t total = 0;
+        for (auto const &list : lists.optional) {
+            total += list.size();
+        }
+        // a document needs min_should_match of the lists, and it can't be counted more than once in the group
+        return std::min(total / std::max<std::size_t>(node.min_should_match, 1), query_postings.group_sizes[node.group]);
+    }
+
+    std::vector<std::uint32_t> Indexer::planAnd(SearchRequest const &search_request,
+                                                SearchRequest::QueryNode const &node,
+                                                QueryPostings const &query_postings) const {
+        std::vector<std::pair<std::size_t, std::uint32_t>> costs;
+        for (std::uint32_t child : node.children) {
+            if (!isExclusionOnly(search_request, child)) {
+                costs.push_back(std::make_pair(estimate(search_request, child, query_postings), child));
+            }
+        }
+        std::stable_sort(costs.begin(), costs.end(),
+                         [](std::pair<std::size_t, std::uint32_t> const &a,
+                            std::pair<std::size_t, std::uint32_t> const &b) {
+                             return a.first < b.first;
+                         });
+        std::vector<std::uint32_t> plan;
+        plan.reserve(costs.size());
+        for (auto const &cost : costs) {
+            plan.push_back(cost.second);
+        }
+        return plan;
+    }
+
+    std::vector<DocOrdinal> Indexer::evaluate(SearchRequest const &search_request,
+                                              std::uint32_t node_index,
+                                              QueryPostings const &query_postings) const {
+        SearchRequest::QueryNode const &node = search_request.getNode(node_index);
+        std::vector<DocOrdinal> result;
+
+        if (node.type == SearchRequest::QueryNode::OR) {
+            std::vector<std::vector<DocOrdinal>> alternatives;
+            std::vector<OrdinalRange> alternative_ranges;
+            alternatives.reserve(node.children.size());
+            for (std::uint32_t child : node.children) {
+                alternatives.push_back(evaluate(search_request, child, query_postings));
+                alternative_ranges.push_back(OrdinalRange(alternatives.back()));
+            }
+            return postings::unionAll(alternative_ranges, ordinalDocuments.size());
+        }
+
+        if (node.type == SearchRequest::QueryNode::AND) {
+            std::vector<OrdinalRange> excluded;
+            for (std::uint32_t child : node.children) {
+                if (isExclusionOnly(search_request, child)) {
+                    for (std::uint32_t term_index : search_request.getNode(child).children) {
+                        excluded.push_back(query_postings.terms[term_index]);
+                    }
+                }
+            }
+            std::vector<std::uint32_t> plan = planAnd(search_request, node, query_postings);
+            if (plan.empty()) {
+                return allDocumentsExcept(excluded);
+            }
+            if (estimate(search_request, plan[0], query_postings) == 0) {
+                // some operand can't match anything, skip the whole AND
+                return result;
+            }
+            // materialize only the most selective operand, then probe the others for its documents
+            result = evaluate(search_request, plan[0], query_postings);
+            for (std::size_t i = 1; i < plan.size() && !result.empty(); i++) {
+                filter(search_request, plan[i], query_postings, result);
+            }
+            exclude(result, excluded);
+            return result;
+        }
+
+        // CLAUSE
+        ClauseLists lists = splitClause(search_request, node, query_postings.terms);
+        if (node.min_should_match > lists.optional.size()) {
+            return result;
+        }
+        if (lists.required.empty() && lists.optional.empty()) {
+            return allDocumentsExcept(lists.excluded);
+        }
+        if (lists.required.empty()) {
+            result = node.min_should_match <= 1 ?
+                     postings::unionAll(lists.optional, ordinalDocuments.size()) :
+                     postings::atLeast(lists.optional, node.min_should_match);
+        } else {
+            for (auto const &list : lists.required) {
+                if (list.isEmpty()) {
+                    return result;
+                }
+            }
+            result = postings::intersectAll(lists.required);
+            keepMinShouldMatch(result, lists.optional, node.min_should_match);
+        }
+        exclude(result, lists.excluded);
+        if (node.type != SearchRequest::QueryNode::CLAUSE) {
+            // PHRASE or NEAR, positions are only decoded for the documents that have all the keywords
+            keepProximate(node, query_postings, result);
+        }
+        return result;
+    }
+
+    void Indexer::filter(SearchRequest const &search_request,
+                         std::uint32_t node_index,
+                         QueryPostings const &query_postings,
+                         std::vector<DocOrdinal> &candidates) const {
+        SearchRequest::QueryNode const &node = search_request.getNode(node_index);
+
+        if (node.type == SearchRequest::QueryNode::OR) {
+            std::vector<DocOrdinal> matched;
+            std::vector<DocOrdinal> remaining(candidates);
+            for (std::size_t i = 0; i < node.children.size() && !remaining.empty(); i++) {
+                std::vector<DocOrdinal> child_matches(remaining);
+                filter(search_request, node.children[i], query_postings, child_matches);
+                if (!child_matches.empty()) {
+                    postings::subtract(remaining, OrdinalRange(child_matches));
+                    matched.insert(matched.end(), child_matches.begin(), child_matches.end());
+                }
+            }
+            std::sort(matched.begin(), matched.end());
+            candidates.swap(matched);
+            return;
+        }
+
+        if (node.type == SearchRequest::QueryNode::AND) {
+            for (std::uint32_t child : planAnd(search_request, node, query_postings)) {
+                if (candidates.empty()) {
+                    return;
+                }
+                filter(search_request, child, query_postings, candidates);
+            }
+            for (std::uint32_t child : node.children) {
+                if (isExclusionOnly(search_request, child)) {
+                    filter(search_request, child, query_postings, candidates);
+                }
+            }
+            return;
+        }
+
+        // CLAUSE
+        ClauseLists lists = splitClause(search_request, node, query_postings.terms);
+        if (node.min_should_match > lists.optional.size()) {
+            candidates.clear();
+            return;
+        }
+        for (auto const &list : lists.required) {
+            if (candidates.empty()) {
+                return;
+            }
+            postings::intersectWith(candidates, list);
+        }
+        keepMinShouldMatch(candidates, lists.optional, node.min_should_match);
+        exclude(candidates, lists.excluded);
+        if (node.type != SearchRequest::QueryNode::CLAUSE) {
+            keepProximate(node, query_postings, candidates);
+        }
+    }
+
+    void Indexer::keepProximate(SearchRequest::QueryNode const &node,
+                                QueryPostings const &query_postings,
+                                std::vector<DocOrdinal> &candidates) const {
+        std::vector<TermPositions const *> term_positions;
+        for (std::uint32_t term_index : node.children) {
+            if (query_postings.positions[term_index] == nullptr) {
+                // no positions to go by, the keywords being there is all that can be asked
+                return;
+            }
+            term_positions.push_back(query_postings.positions[term_index]);
+        }
+        std::vector<std::vector<KeyPosition>> lists(term_positions.size());
+        std::size_t kept = 0;
+        for (DocOrdinal candidate : candidates) {
+            bool decoded = true;
+            for (std::size_t i = 0; i < term_positions.size() && decoded; i++) {
+                lists[i].clear();
+                decoded = term_positions[i]->decode(candidate, lists[i]);
+            }
+            if (decoded && positions::matchSequence(lists, node.distances)) {
+                candidates[kept++] = candidate;
+            }
+        }
+        candidates.resize(kept);
+    }
+
+    void Indexer::putPositions(ReverseIndex &r_index, std::string const &group, SPDocument const &doc,
+                               DocOrdinal ordinal) {
+        yuca::utils::List<std::string> sequence = doc->getKeySequence(group);
+        std::map<std::string, std::vector<KeyPosition>> keyword_positions;
+        for (std::size_t i = 0; i < sequence.size(); i++) {
+            keyword_positions[sequence.getStdVector()[i]].push_back(static_cast<KeyPosition>(i));
+        }
+        for (auto const &k_sp : doc->getGroupSPKeys(group).getStdSet()) {
+            auto positions_it = keyword_positions.find(k_sp->getString());
+            r_index.putPositions(k_sp, ordinal, positions_it == keyword_positions.end() ?
+                                                std::vector<KeyPosition>() : positions_it->second);
+        }
+    }
+
+    void Indexer::keepPositions(std::string const &group) {
+        if (!positionalGroups.insert(group).second) {
+            return;
+        }
+        if (!reverseIndices.containsKey(group)) {
+            return;
+        }
+        std::shared_ptr<ReverseIndex> r_index = reverseIndices.get(group);
+        r_index->setKeepsPositions(true);
+        for (DocOrdinal ordinal = 0; ordinal < ordinalDocuments.size(); ordinal++) {
+            SPDocument const &doc = ordinalDocuments[ordinal];
+            if (doc != nullptr && doc->hasKeys(group)) {
+                putPositions(*r_index, group, doc, ordinal);
+            }
+        }
+        resultCache.clear();
+    }
+
+    bool Indexer::keepsPositions(std::string const &group) const {
+        return positionalGroups.count(group) > 0;
+    }
+
+    bool Indexer::isExclusionOnly(SearchRequest const &search_request, std::uint32_t node_index) const {
+        SearchRequest::QueryNode const &node = search_request.getNode(node_index);
+        if (node.type != SearchRequest::QueryNode::CLAUSE) {
+            return false;
+        }
+        for (std::uint32_t term_index : node.children) {
+            if (search_request.getTerm(term_index).occur != SearchRequest::MUST_NOT) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Indexer::exclude(std::vector<DocOrdinal> &candidates, std::vector<OrdinalRange> const &excluded) const {
+        if (candidates.empty() || excluded.empty()) {
+            return;
+        }
+        // dense candidates against several lists are cheaper as one bitmap ANDNOT pass per list
+        if (excluded.size() > 1 && candidates.size() * 64 >= ordinalDocuments.size()) {
+            DocBitmap bitmap(ordinalDocuments.size());
+            bitmap.orWith(OrdinalRange(candidates));
+            for (auto const &list : excluded) {
+                bitmap.andNot(list);
+            }
+            candidates.clear();
+            bitmap.toOrdinals(candidates);
+            return;
+        }
+        for (auto const &list : excluded) {
+            postings::subtract(candidates, list);
+        }
+    }
+
+    std::vector<DocOrdinal> Indexer::allDocumentsExcept(std::vector<OrdinalRange> const &excluded) const {
+        DocBitmap bitmap(liveDocuments);
+        for (auto const &list : excluded) {
+            bitmap.andNot(list);
+        }
+        std::vector<DocOrdinal> result;
+        bitmap.toOrdinals(result);
+        return result;
+    }
+
+    void Indexer::setResultCacheCapacity(std::size_t capacity) {
+        resultCache.setCapacity(capacity);
+    }
+
+    ResultCache const &Indexer::getResultCache() const {
+        return resultCache;
+    }
+
+    void Indexer::setMaxTermExpansions(std::size_t max_term_expansions) {
+        maxTermExpansions = max_term_expansions;
+        // cached results of prefix and wildcard queries could have been expanded differently
+        settingsGeneration++;
+        resultCache.clear();
+    }
+
+    std::size_t Indexer::getMaxTermExpansions() const {
+        return maxTermExpansions;
+    }
+
+    yuca::utils::List<Completion> Indexer::complete(std::string const &group,
+                                                    std::string const &prefix,
+                                                    std::size_t max_completions) const {
+        yuca::utils::List<Completion> completions;
+        ReverseIndex const *r_index = findReverseIndex(StringKey::groupId(group), group);
+        if (r_index != nullptr) {
+            completions.getStdVector() = r_index->complete(prefix, max_completions);
+        }
+        return completions;
+    }
+
+    yuca::utils::List<Suggestion> Indexer::suggest(const std::string &query,
+                                                   std::size_t max_suggestions_per_keyword) const {
+        yuca::utils::List<Suggestion> suggestions;
+        SearchRequest search_request(query, implicit_group);
+        std::set<std::pair<std::uint32_t, yuca::utils::StringView>> seen;
+        for (std::uint32_t t = 0; t < search_request.getTermCount(); t++) {
+            SearchRequest::QueryTerm const &term = search_request.getTerm(t);
+            yuca::utils::StringView keyword = search_request.getTermString(t);
+            if (term.occur == SearchRequest::MUST_NOT || term.type != SearchRequest::EXACT ||
+                !seen.insert(std::make_pair(term.group, keyword)).second) {
+                continue;
+            }
+            yuca::utils::StringView group = search_request.getGroup(term.group);
+            ReverseIndex const *r_index = findReverseIndex(StringKey::groupId(group), group);
+            if (r_index == nullptr) {
+                continue;
+            }
+            // within 2 edits almost every short keyword is near almost any other
+            std::uint32_t max_edits = keyword.size() <= 4 ? 1 : SearchRequest::MAX_FUZZY_EDITS;
+            std::vector<ReverseIndex::FuzzyKey> candidates = r_index->findFuzzyKeys(keyword, max_edits);
+            std::size_t keyword_document_count = 0;
+            for (auto const &candidate : candidates) {
+                if (candidate.edits == 0) {
+                    keyword_document_count = candidate.document_count;
+                }
+            }
+            // a keyword that is in the index is only corrected to more common ones
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                            [keyword_document_count](ReverseIndex::FuzzyKey const &candidate) {
+                                                return candidate.edits == 0 ||
+                                                       candidate.document_count <= keyword_document_count;
+                                            }), candidates.end());
+            std::size_t kept = std::min(candidates.size(), max_suggestions_per_keyword);
+            std::partial_sort(candidates.begin(), candidates.begin() + static_cast<long>(kept), candidates.end(),
+                              [](ReverseIndex::FuzzyKey const &a, ReverseIndex::FuzzyKey const &b) {
+                                  if (a.edits != b.edits) {
+                                      return a.edits < b.edits;
+                                  }
+                                  if (a.document_count != b.document_count) {
+                                      return a.document_count > b.document_count;
+                                  }
+                                  return a.keyword < b.keyword;
+                              });
+            for (std::size_t i = 0; i < kept; i++) {
+                suggestions.add(Suggestion{group.toString(), keyword.toString(), candidates[i].keyword.toString(),
+                                           candidates[i].edits, candidates[i].document_count});
+            }
+        }
+        return suggestions;
+    }
+
+    void Indexer::addTrigramIndex(std::string const &property) {
+        if (hasTrigramIndex(property)) {
+            return;
+        }
+        TrigramIndex &trigram_index =
+        trigramIndices.insert(std::make_pair(property, TrigramIndex(property))).first->second;
+        for (DocOrdinal ordinal = 0; ordinal < ordinalDocuments.size(); ordinal++) {
+            SPDocument const &doc = ordinalDocuments[ordinal];
+            if (doc != nullptr && doc->propertyKeys(STRING).contains(property)) {
+                trigram_index.putDocument(ordinal, doc->stringProperty(property));
+            }
+        }
+    }
+
+    void Indexer::removeTrigramIndex(std::string const &property) {
+        trigramIndices.erase(property);
+    }
+
+    bool Indexer::hasTrigramIndex(std::string const &property) const {
+        return trigramIndices.find(property) != trigramIndices.end();
+    }
+
+    SPDocumentSet Indexer::findDocumentsContaining(std::string const &property, std::string const &substring) const {
+        SPDocumentSet docs_out;
+        auto trigram_index_it = trigramIndices.find(property);
+        if (trigram_index_it != trigramIndices.end()) {
+            for (DocOrdinal ordinal : trigram_index_it->second.findContaining(substring)) {
+                docs_out.add(ordinalDocuments[ordinal]);
+            }
+            return docs_out;
+        }
+        PropertyColumn<std::string> const *column = columns.stringColumn(columns.findProperty(property));
+        if (column == nullptr) {
+            return docs_out;
+        }
+        std::string lower_case_substring = TrigramIndex::toLowerCase(substring);
+        std::vector<std::string> const &values = column->getValues();
+        for (DocOrdinal ordinal = 0; ordinal < values.size(); ordinal++) {
+            if (column->hasValue(ordinal) &&
+                TrigramIndex::toLowerCase(values[ordinal]).find(lower_case_substring) != std::string::npos) {
+                docs_out.add(ordinalDocuments[ordinal]);
+            }
+        }
+        return docs_out;
+    }
+
+    void Indexer::addNumericIndex(std::string const &property) {
+        if (hasNumericIndex(property)) {
+            return;
+        }
+        NumericIndex &numeric_index =
+        numericIndices.insert(std::make_pair(property, NumericIndex(property))).first->second;
+        for (DocOrdinal ordinal = 0; ordinal < ordinalDocuments.size(); ordinal++) {
+            long value;
+            if (ordinalDocuments[ordinal] != nullptr && findNumericValue(property, ordinal, value)) {
+                numeric_index.putDocument(ordinal, value);
+            }
+        }
+        // ranges over the property are now compared as numbers
+        settingsGeneration++;
+        resultCache.clear();
+    }
+
+    void Indexer::removeNumericIndex(std::string const &property) {
+        numericIndices.erase(property);
+        settingsGeneration++;
+        resultCache.clear();
+    }
+
+    bool Indexer::hasNumericIndex(std::string const &property) const {
+        return numericIndices.find(property) != numericIndices.end();
+    }
+
+    void Indexer::addFacetIndex(std::string const &group) {
+        if (hasFacetIndex(group)) {
+            return;
+        }
+        FacetIndex &facet_index = facetIndices.insert(std::make_pair(group, FacetIndex(group))).first->second;
+        for (DocOrdinal ordinal = 0; ordinal < ordinalDocuments.size(); ordinal++) {
+            if (ordinalDocuments[ordinal] != nullptr) {
+                facet_index.putDocument(ordinal, *ordinalDocuments[ordinal]);
+            }
+        }
+    }
+
+    void Indexer::removeFacetIndex(std::string const &group) {
+        facetIndices.erase(group);
+    }
+
+    bool Indexer::hasFacetIndex(std::string const &group) const {
+        return facetIndices.find(group) != facetIndices.end();
+    }
+
+    Facet Indexer::countFacet(std::string const &group, std::vector<DocOrdinal> const &matches,
+                              DocBitmap const &match_bitmap, std::size_t max_keys) const {
+        Facet facet;
+        facet.group = group;
+        ReverseIndex const *r_index = findReverseIndex(StringKey::groupId(group), group);
+        if (r_index == nullptr || matches.empty()) {
+            return facet;
+        }
+        std::vector<FacetCount> counts;
+        auto facet_index_it = facetIndices.find(group);
+        if (facet_index_it != facetIndices.end() && r_index->getKeyCount() > MAX_POSTINGS_FACET_KEYS) {
+            counts = facet_index_it->second.count(matches, max_keys);
+        } else {
+            counts = r_index->countKeys(match_bitmap, max_keys);
+        }
+        facet.counts.getStdVector().swap(counts);
+        return facet;
+    }
+
+    bool Indexer::findNumericValue(std::string const &property, DocOrdinal ordinal, long &value) const {
+        PropertyId property_id = columns.findProperty(property);
+        if (property_id == ColumnStore::NO_PROPERTY) {
+            return false;
+        }
+        PropertyColumn<long> const *long_column = columns.longColumn(property_id);
+        if (long_column->hasValue(ordinal)) {
+            value = long_column->get(ordinal);
+            return true;
+        }
+        PropertyColumn<int> const *int_column = columns.intColumn(property_id);
+        if (int_column->hasValue(ordinal)) {
+            value = int_column->get(ordinal);
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<DocOrdinal> Indexer::findRange(yuca::utils::StringView group,
+                                               yuca::utils::StringView range_text) const {
+        std::vector<DocOrdinal> ordinals;
+        SearchRequest::Range range;
+        if (!SearchRequest::parseRange(range_text, range)) {
+            return ordinals;
+        }
+        auto numeric_index_it = numericIndices.find(groupProperty(group));
+        if (numeric_index_it == numericIndices.end()) {
+            ReverseIndex const *r_index = findReverseIndex(StringKey::groupId(group), group);
+            if (r_index != nullptr) {
+                // unions of many keys go through a bitmap
+                ordinals = postings::unionAll(r_index->findRangePostings(range.lower, range.include_lower,
+                                                                         range.upper, range.include_upper),
+                                              ordinalDocuments.size());
+            }
+            return ordinals;
+        }
+        long min = std::numeric_limits<long>::min();
+        long max = std::numeric_limits<long>::max();
+        if (!range.lower.isEmpty()) {
+            if (!NumericIndex::parseLong(range.lower, min)) {
+                return ordinals;
+            }
+            if (!range.include_lower) {
+                if (min == std::numeric_limits<long>::max()) {
+                    return ordinals;
+                }
+                min++;
+            }
+        }
+        if (!range.upper.isEmpty()) {
+            if (!NumericIndex::parseLong(range.upper, max)) {
+                return ordinals;
+            }
+            if (!range.include_upper) {
+                if (max == std::numeric_limits<long>::min()) {
+                    return ordinals;
+                }
+                max--;
+            }
+        }
+        return numeric_index_it->second.findRange(min, max);
+    }
+
+    ColumnStore const &Indexer::getColumns() const {
+        return columns;
+    }
+
+    bool Indexer::findOrdinal(long doc_id, DocOrdinal &ordinal) const {
+        auto ordinal_it = docOrdinals.getStdMap().find(doc_id);
+        if (ordinal_it == docOrdinals.getStdMap().end()) {
+            return false;
+        }
+        ordinal = ordinal_it->second;
+        return true;
+    }
+
+    ResultCache::Entry Indexer::makeCacheEntry(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<SearchResult> const &results) const {
+        SearchRequest const &search_request = prepared_query.getSearchRequest();
+        ResultCache::Entry entry;
+        for (std::uint32_t g = 0; g < search_request.getGroupCount(); g++) {
+            ResultCache::Dependency dependency;
+            dependency.group = search_request.getGroup(g).toString();
+            dependency.group_id = prepared_query.getGroupId(g);
+            ReverseIndex const *r_index = findReverseIndex(dependency.group_id, search_request.getGroup(g));
+            dependency.generation = r_index == nullptr ? 0 : r_index->getGeneration();
+            entry.dependencies.push_back(std::move(dependency));
+        }
+        entry.depends_on_all_documents = false;
+        for (std::uint32_t n = 0; n < search_request.getNodeCount(); n++) {
+            entry.depends_on_all_documents = entry.depends_on_all_documents || isExclusionOnly(search_request, n);
+        }
+        // ranges look at numeric indices and filters at the columns, neither has generations of its own
+        for (std::uint32_t t = 0; t < search_request.getTermCount(); t++) {
+            entry.depends_on_all_documents = entry.depends_on_all_documents ||
+                                             search_request.getTerm(t).type == SearchRequest::RANGE;
+        }
+        entry.depends_on_all_documents = entry.depends_on_all_documents || search_request.getFilterCount() > 0;
+        entry.documents_generation = documentsGeneration;
+        entry.ordinals.reserve(results.size());
+        entry.scores.reserve(results.size());
+        for (auto const &sr : results.getStdVector()) {
+            entry.ordinals.push_back(docOrdinals.get(sr.document_sp->getId()));
+            entry.scores.push_back(sr.score);
+        }
+        return entry;
+    }
+
+    bool Indexer::isCurrent(ResultCache::Entry const &entry) const {
+        if (entry.depends_on_all_documents && entry.documents_generation != documentsGeneration) {
+            return false;
+        }
+        for (auto const &dependency : entry.dependencies) {
+            ReverseIndex const *r_index = findReverseIndex(dependency.group_id, dependency.group);
+            if ((r_index == nullptr ? 0 : r_index->getGeneration()) != dependency.generation) {
+                return false;
+            }
+        }
+        return true;
     }
 
     std::shared_ptr<ReverseIndex> Indexer::getReverseIndex(std::string const &group) const {
         if (!reverseIndices.containsKey(group)) {
-            return std::make_shared<ReverseIndex>();
+            auto r_index = std::make_shared<ReverseIndex>(group);
+            r_index->setKeepsPositions(positionalGroups.count(group) > 0);
+            return r_index;
         }
         return reverseIndices.get(group);
     }
 
+    ReverseIndex const *Indexer::findReverseIndex(long group_id, yuca::utils::StringView group) const {
+        auto r_index_it = groupIdReverseIndices.getStdMap().find(group_id);
+        if (r_index_it != groupIdReverseIndices.getStdMap().end() &&
+            yuca::utils::StringView(r_index_it->second->getGroup()) == group) {
+            return r_index_it->second.get();
+        }
+        if (r_index_it == groupIdReverseIndices.getStdMap().end()) {
+            return nullptr;
+        }
+        // group hash collision, fall back to the slower lookup by name
+        auto by_name_it = reverseIndices.getStdMap().find(group.toString());
+        return by_name_it == reverseIndices.getStdMap().end() ? nullptr : by_name_it->second.get();
+    }
+
     std::ostream &operator<<(std::ostream &output_stream, Indexer &indexer) {
         output_stream << "Indexer(@" << ((long) &indexer % 10000) << "): " << std::endl;
         output_stream << "{" << std::endl;
@@ -32,86 +32,182 @@
 #include "key.hpp"
 #include "document.hpp"
 #include "types.hpp"
+#include "query.hpp"
+#include "postings.hpp"
+#include "cache.hpp"
+#include "trigram.hpp"
+#include "completion.hpp"
+#include "session.hpp"
+#include "positions.hpp"
+#include "columns.hpp"
+#include "numeric.hpp"
+#include "facets.hpp"
+#include "aggregations.hpp"
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <memory>
 #include <algorithm>
 
 namespace yuca {
-    /** Maps *Key -> [Document Set] */
+    /** Maps *Key -> [Document Set], and keeps the ordinals of those documents in a sorted PostingList per Key */
     struct ReverseIndex {
-        ReverseIndex() : spkey_to_spdocset_map(SPDocumentSet()), keyPtrCache(nullptr) {
+        ReverseIndex() : ReverseIndex("") {
+        }
+
+        explicit ReverseIndex(std::string const &a_group) :
+        spkey_to_spdocset_map(SPDocumentSet()),
+        group(a_group),
+        positional(false),
+        termDictionary(std::vector<TermEntry>()) {
+            touch();
         }
 
         yuca::utils::Map<std::shared_ptr<Key>, SPDocumentSet> spkey_to_spdocset_map;
 
-        void putDocument(SPKey key, SPDocument doc);
+        /** @param ordinal the small dense number the Indexer gave the document, see postings.hpp */
+        void putDocument(SPKey key, SPDocument doc, DocOrdinal ordinal);
+
+        void removeDocument(SPKey key, SPDocument doc, DocOrdinal ordinal);
+
+        /** Positions of the key in the document, the key must have been put for the document first */
+        void putPositions(SPKey key, DocOrdinal ordinal, std::vector<KeyPosition> const &positions);
 
-        void removeDocument(SPKey key, SPDocument doc);
+        /** Call once the document's keys under this group have all been removed */
+        void removeDocumentOrdinal(DocOrdinal ordinal);
 
         bool hasDocuments(SPKey key) const;
 
         SPDocumentSet getDocuments(SPKey key) const;
 
+        /**
+         * Looks up the documents under the StringKey with the given id and string without building a Key
+         * or copying the document set. Returns NO_DOCUMENTS if there's no such key.
+         */
+        SPDocumentSet const &findDocuments(long key_id, yuca::utils::StringView string_key) const;
+
+        /** Positions of the given StringKey in its documents, TermPositions::EMPTY if there's no such key */
+        TermPositions const &findPositions(long key_id, yuca::utils::StringView string_key) const;
+
+        /** Does the Indexer put the positions of this group's keys? see Indexer::keepPositions() */
+        bool keepsPositions() const;
+
+        void setKeepsPositions(bool keeps_positions);
+
+        /** Ordinals of the documents under the given StringKey, PostingList::EMPTY if there's no such key */
+        PostingList const &findPostings(long key_id, yuca::utils::StringView string_key) const;
+
+        /** Postings of the first max_terms StringKeys, in string order, that start with the prefix */
+        std::vector<OrdinalRange> findPrefixPostings(yuca::utils::StringView prefix, std::size_t max_terms) const;
+
+        /**
+         * Postings of the first max_terms StringKeys, in string order, that match the wildcard pattern.
+         * Only the keys that start with the pattern's literal prefix are looked at.
+         */
+        std::vector<OrdinalRange> findWildcardPostings(yuca::utils::StringView pattern, std::size_t max_terms) const;
+
+        /**
+         * Postings of the StringKeys between lower and upper in string order, an empty bound leaves that side open.
+         * "1970" to "1980" takes "1975" but also "19750", ranges of numbers need them written with the same digits.
+         */
+        std::vector<OrdinalRange> findRangePostings(yuca::utils::StringView lower,
+                                                    bool include_lower,
+                                                    yuca::utils::StringView upper,
+                                                    bool include_upper) const;
+
+        /** A StringKey near a term, see findFuzzyKeys() */
+        struct FuzzyKey {
+            yuca::utils::StringView keyword; // points into the key, good while the key is in the index
+            long key_id;
+            std::uint32_t edits;
+            std::size_t document_count;
+        };
+
+        /**
+         * The StringKeys within max_edits (Levenshtein distance) of the term, in string order. The ordered
+         * dictionary is walked like a trie, one Levenshtein DP row per character, and every key under a prefix
+         * that can no longer get within max_edits is skipped at once.
+         */
+        std::vector<FuzzyKey> findFuzzyKeys(yuca::utils::StringView term, std::uint32_t max_edits) const;
+
+        /** Postings of the findFuzzyKeys() of the term, the closest max_terms of them if there are more */
+        std::vector<OrdinalRange> findFuzzyPostings(yuca::utils::StringView term,
+                                                    std::uint32_t max_edits,
+                                                    std::size_t max_terms) const;
+
+        /** The max_completions StringKeys that start with the prefix and have the most documents */
+        std::vector<Completion> complete(yuca::utils::StringView prefix, std::size_t max_completions) const;
+
+        /**
+         * The max_keys StringKeys the most of the given documents have, all of them if it's 0, most documents
+         * first, ties in string order. Every posting is tested against the bitmap, but the postings of keys with
+         * too few documents to make it are skipped.
+         */
+        std::vector<FacetCount> countKeys(DocBitmap const &ordinals, std::size_t max_keys) const;
+
+        std::string const &getGroup() const;
+
         long getKeyCount() const;
 
-        /** Given an equivalent shared_ptr<Key> gets the corresponding shared_ptr<Key> we have stored already */
+        /** Number of documents with at least one key in this group */
+        std::size_t getDocumentCount() const;
+
+        /**
+         * Changes every time a document is put or removed. Generations are never repeated, not even by
+         * different ReverseIndex objects, so a group that got removed and indexed again won't look unchanged.
+         */
+        std::uint64_t getGeneration() const;
+
+        /**
+         * Given an equivalent shared_ptr<Key> gets the corresponding shared_ptr<Key> we have stored already.
+         * Keys are bucketed by id, if two different keys hash to the same id the full key is compared.
+         */
         SPKey keyCacheGet(SPKey) const;
 
         void clear();
 
         friend std::ostream &operator<<(std::ostream &output_stream, ReverseIndex &rindex);
 
+        static const SPDocumentSet NO_DOCUMENTS;
+
     private:
+        struct TermEntry {
+            SPKey key;
+            PostingList postings;
+            // only kept when the group keeps positions
+            TermPositions positions;
+        };
+
+        TermEntry *findEntry(SPKey const &key);
 
-        void keyCachePut(SPKey key);
+        TermEntry const *findEntry(SPKey const &key) const;
+
+        TermEntry const *findEntry(long key_id, yuca::utils::StringView string_key) const;
 
         void keyCacheRemove(SPKey key);
 
-        yuca::utils::Map<long, SPKey> keyPtrCache;
-    };
+        void touch();
 
-    /**
-     * Given a search query it creates a structure that maps
-     * possible search groups to specified OffsetKeywords
-     */
-    struct SearchRequest {
-        SearchRequest(const std::string &query_str, const std::string &implicit_group) :
-        group_keywords_map(yuca::utils::List<std::string>()),
-        query(query_str),
-        id(rand()),
-        total_keywords(0) {
-            std::string group_prefix(":");
-            std::string current_group = implicit_group;
-            auto query_tokens = yuca::utils::split(query_str);
-
-            for (auto &keyword : query_tokens.getStdVectorCopy()) {
-                if (yuca::utils::startsWith(keyword, group_prefix)) {
-                    current_group = keyword;
-
-                    continue;
-                }
-                auto group_keywords = group_keywords_map.get(current_group);
-
-                group_keywords.add(keyword);
-                total_keywords++;
-                group_keywords_map.put(current_group, group_keywords);
-            }
-        }
+        /** Gives the entry's StringKey its current number of documents in the completion trie */
+        void updateCompletion(TermEntry const &entry);
 
-        yuca::utils::List<std::string> getGroups();
+        std::string group;
 
-        yuca::utils::List<std::string> getKeywords(std::string &group);
+        std::uint64_t generation;
 
-        yuca::utils::Map<std::string, yuca::utils::List<std::string>> group_keywords_map;
+        bool positional;
 
-        bool operator==(const SearchRequest &other) const;
+        // term dictionary: id -> [keys with that id and their postings], almost always a single element
+        yuca::utils::Map<long, std::vector<TermEntry>> termDictionary;
 
-        const std::string query;
+        // the same StringKeys ordered by their string, for prefix scans. Views point into the keys in termDictionary
+        std::map<yuca::utils::StringView, long> orderedTerms;
 
-        const long id;
+        // ordinals of the documents with at least one key in this group
+        PostingList documentOrdinals;
 
-        long total_keywords;
+        // the StringKeys weighted by their number of documents
+        CompletionTrie completions;
     };
 
     struct SearchResult {
@@ -137,31 +233,79 @@ namespace yuca {
         }
     };
 
+    /**
+     * How search(query, options, ...) compares, sorts, collapses and counts facets of its results. Any of them
+     * can be combined, the defaults rank every match by score.
+     */
+    struct SearchOptions {
+        SearchOptions() : max_results(0), max_facet_keys(0), max_per_group(0) {
+        }
+
+        // a string property compared to the query, see search(query, opt_main_doc_property_for_query_comparison)
+        std::string main_doc_property;
+
+        // 0 for all of them. When collapsing, how many collapse values
+        unsigned long max_results;
+
+        // "property desc" or "property asc", see search(..., opt_sort_by). "" ranks by score
+        std::string sort_by;
+
+        // groups whose keys are counted over all the matches, see search(..., facet_groups, ...)
+        yuca::utils::List<std::string> facet_groups;
+
+        // per facet group, 0 keeps all of them
+        std::size_t max_facet_keys;
+
+        // a property or ":group" results are collapsed by, see search(..., collapse_by, max_per_group). "" for none
+        std::string collapse_by;
+
+        std::size_t max_per_group;
+    };
+
 
     class Indexer {
     public:
         Indexer(const std::string &an_implicit_group) :
         reverseIndices(std::shared_ptr<ReverseIndex>()),
+        groupIdReverseIndices(std::shared_ptr<ReverseIndex>()),
         docPtrCache(nullptr),
+        docOrdinals(0),
+        documentsGeneration(0),
+        settingsGeneration(0),
+        maxTermExpansions(DEFAULT_MAX_TERM_EXPANSIONS),
         implicit_group(an_implicit_group) {
         }
 
         Indexer() : Indexer(":keyword") {
         }
 
-        /** Wrapper meant for non C++ users so their API surface doesn't need to deal with shared_ptr */
-        void indexDocument(Document doc);
+        static const std::size_t DEFAULT_MAX_TERM_EXPANSIONS = 1024;
+
+        /**
+         * Wrapper meant for non C++ users so their API surface doesn't need to deal with shared_ptr.
+         * The document is copied once, into the shared_ptr the Indexer keeps.
+         */
+        void indexDocument(Document const &doc);
+
+        /** Moves the document into the shared_ptr the Indexer keeps, its keys and properties aren't copied */
+        void indexDocument(Document &&doc);
 
+        /** A copy of the indexed document, Document::NULL_DOCUMENT if there's none. See findDocument() */
         Document getDocument(long doc_id) const noexcept;
 
         Document getDocument(std::string const &doc_id) const noexcept;
 
+        /** The indexed document itself, nothing is copied. nullptr if there's no document with that id */
+        SPDocument findDocument(long doc_id) const noexcept;
+
+        SPDocument findDocument(std::string const &doc_id) const noexcept;
+
         bool removeDocument(long doc_id);
 
         bool removeDocument(std::string const &doc_id);
 
         /** Wrapper meant for non C++ users so their API surface doesn't need to deal with shared_ptr */
-        bool removeDocument(Document doc);
+        bool removeDocument(Document const &doc);
 
         void indexDocument(SPDocument doc);
 
@@ -183,6 +327,11 @@ namespace yuca {
          * "the twilight zone :extension mp4"
          * ":city new york :year 2018 :sex female"
          *
+         * Keywords can be +required or -excluded, group clauses can be ORed and parenthesized, and ":group~N"
+         * asks for at least N of the group's keywords, see SearchRequest for the whole syntax.
+         *
+         * ":title +twilight -zone :extension mp4 OR (:extension avi :year 1959)"
+         *
          * @param opt_main_doc_property_for_query_comparison - Optional. Pass "" if you don't intend to use it.
          * After groupged keys are used to filter out search results we can compare the given document property value
          * against the given query. The lowest the Levenshtein distance the higher ranked the search result will be.
@@ -214,15 +363,260 @@ namespace yuca {
         yuca::utils::List<SearchResult> search(const std::string &query,
                                                const std::string &opt_main_doc_property_for_query_comparison);
 
+        /**
+         * Parses the query and hashes its groups and keywords once, so it can be searched many times
+         * with search(prepared_query, parameters, ...). Keywords written as "?" are parameters.
+         * A PreparedQuery doesn't hold on to any of this Indexer's state, it stays valid as documents come and go.
+         */
+        PreparedQuery prepare(const std::string &query_template) const;
+
+        /**
+         * Same as search(query, ...) for the prepared query with its parameters bound, in order, to the given values.
+         * Missing parameters are searched for as a literal "?", extra values are ignored.
+         */
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results) const;
+
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters) const;
+
+        /**
+         * Same as search(query, ...), and also counts the keys the matches have under each of the facet groups,
+         * all the matches, not only the results returned. Groups with a FacetIndex, see addFacetIndex(), and many
+         * keys are counted from the keys of the matches, the others from the postings of their keys.
+         * search(":title communism", "", 10, {":extension", ":author"}, 5, facets)
+         * -> facets [{":extension", [{"pdf", 42}, {"epub", 17}]}, {":author", [...]}]
+         *
+         * @param max_facet_keys how many keys to keep per group, those with the most matches. 0 keeps all of them
+         * @param facets cleared, then one Facet per facet group, in order
+         */
+        yuca::utils::List<SearchResult> search(const std::string &query,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results,
+                                               yuca::utils::List<std::string> const &facet_groups,
+                                               std::size_t max_facet_keys,
+                                               yuca::utils::List<Facet> &facets) const;
+
+        /**
+         * Aggregates the long, or else int, values of each of the properties over all the documents that match
+         * the query, see NumericAggregation. No SearchResult is built, the values are read from getColumns().
+         * aggregate(":extension pdf", {"file_size"}, 1048576) -> min, max, sum, average, a histogram of 1MB
+         * buckets and the percentiles of the file sizes of the PDFs
+         *
+         * @param histogram_interval width of the histogram buckets, 0 for no histogram
+         * @return one NumericAggregation per property, in order
+         */
+        yuca::utils::List<NumericAggregation> aggregate(const std::string &query,
+                                                        yuca::utils::List<std::string> const &properties,
+                                                        long histogram_interval) const;
+
+        /**
+         * Same as search(query, ...) with the results ordered by a document property instead of their score,
+         * opt_sort_by is "property desc" or "property asc", see SortBy. Long, int, byte and bool values are
+         * compared as numbers, string values as strings, documents without a value go last. Equal values are
+         * ordered by document ordinal, reversed when descending. Pass "" to rank by score.
+         *
+         * Only the first opt_max_search_results matches are kept in a heap. When the property has a numeric
+         * index, see addNumericIndex(), its sorted values are walked instead and the query is only checked
+         * against them until opt_max_search_results matches are found, without evaluating the whole query.
+         *
+         * search(":extension mp4", "", 20, "file_size desc") -> the 20 largest mp4s
+         */
+        yuca::utils::List<SearchResult> search(const std::string &query,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results,
+                                               const std::string &opt_sort_by) const;
+
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results,
+                                               const std::string &opt_sort_by) const;
+
+        /**
+         * Same as search(query, ..., opt_sort_by) with the results collapsed by a property, "info_hash", or a key
+         * group, ":author". At most max_per_group results are kept per value, in a bounded heap per value, and
+         * opt_max_search_results counts distinct values, the ones with the best results. Results come out value
+         * by value, the value with the best result first, each value's results best first. Documents without a
+         * value, or whose collapse key group has no keys, aren't collapsed with any other. A document with many
+         * keys under the group is collapsed by the first of them in string order.
+         *
+         * search(":title communism", "", 10, "", ":author", 2) -> the 2 best results of each of the 10 best authors
+         */
+        yuca::utils::List<SearchResult> search(const std::string &query,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results,
+                                               const std::string &opt_sort_by,
+                                               const std::string &collapse_by,
+                                               std::size_t max_per_group) const;
+
+        /**
+         * Same as the search(query, ...) overloads above, with every option in one place so they can be combined:
+         * the facets are counted over all the matches, which are then sorted, collapsed and truncated.
+         * Results are cached, see setResultCacheCapacity(), unless facets are counted. Sorted searches, collapsed
+         * or not, stop early on the property's numeric index when they can.
+         *
+         * SearchOptions options;
+         * options.max_results = 10; options.sort_by = "file_size desc"; options.collapse_by = ":author";
+         * options.max_per_group = 2; options.facet_groups.add(":extension");
+         * search(":title communism", options, facets) -> the 2 largest files of each of the 10 authors with the
+         * largest files, and the extensions of all the matches
+         *
+         * @param facets cleared, then one Facet per facet group, in order
+         */
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters,
+                                               SearchOptions const &options,
+                                               yuca::utils::List<Facet> &facets) const;
+
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters,
+                                               SearchOptions const &options) const;
+
+        yuca::utils::List<SearchResult> search(const std::string &query,
+                                               SearchOptions const &options,
+                                               yuca::utils::List<Facet> &facets) const;
+
+        yuca::utils::List<SearchResult> search(const std::string &query, SearchOptions const &options) const;
+
+        /**
+         * Search-as-you-type, the session's last keyword is searched as a prefix, see SearchSession::typeAheadQuery().
+         * When the query only narrows the session's previous one, and no documents came or went since,
+         * the previous matches are filtered against it instead of evaluating it from scratch. The keys its
+         * prefix terms expand to are still looked up, but their postings are only probed for the previous matches.
+         * Results are ranked like search(query, ...) ranks them. The result cache is not used.
+         * Queries that expand keywords to their synonyms are always evaluated from scratch.
+         */
+        yuca::utils::List<SearchResult> search(SearchSession &session,
+                                               const std::string &query,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results) const;
+
+        /**
+         * Keeps the ranked results of up to capacity distinct searches. 0, the default, disables the cache.
+         * Cached results are dropped as soon as any of the groups their query looked at changes.
+         */
+        void setResultCacheCapacity(std::size_t capacity);
+
+        ResultCache const &getResultCache() const;
+
+        /** How many keys a prefix or wildcard keyword can expand to at most, DEFAULT_MAX_TERM_EXPANSIONS by default */
+        void setMaxTermExpansions(std::size_t max_term_expansions);
+
+        std::size_t getMaxTermExpansions() const;
+
+        /**
+         * Type-ahead completion, the max_completions keywords of the group that start with the prefix
+         * and have the most documents, see CompletionTrie. It's kept up to date as documents come and go.
+         * complete(":title", "mas", 5) -> [{"master", 12}, {"masters", 7}, {"mask", 2}]
+         */
+        yuca::utils::List<Completion> complete(std::string const &group,
+                                               std::string const &prefix,
+                                               std::size_t max_completions) const;
+
+        /**
+         * Keeps the positions of the keywords documents add with Document::addKeySequence() under the group,
+         * so "quoted phrases" and NEAR/k queries can check where the keywords are. Documents already indexed
+         * get theirs right away. In groups without positions phrases and NEARs only need their keywords.
+         */
+        void keepPositions(std::string const &group);
+
+        bool keepsPositions(std::string const &group) const;
+
+        /**
+         * Makes the keyword, under the given group, also match the documents that have the synonym,
+         * addSynonym(":extension", "jpg", "jpeg"). It's one way, "jpeg" doesn't match "jpg" unless added too.
+         * Keys are hashed once here, a keyword and its synonyms are searched as a single OR of their postings.
+         * Only exact keywords are expanded, not prefixes, wildcards or fuzzy keywords.
+         */
+        void addSynonym(std::string const &group, std::string const &keyword, std::string const &synonym);
+
+        void removeSynonyms(std::string const &group, std::string const &keyword);
+
+        yuca::utils::List<std::string> getSynonyms(std::string const &group, std::string const &keyword) const;
+
+        /**
+         * "Did you mean", for each keyword of the query that can match (not -excluded, no operators), up to
+         * max_suggestions_per_keyword keys of its group within a few edits of it, fewest edits first, then
+         * most documents. Keywords of up to 4 characters get 1 edit, longer ones 2. A keyword that is in
+         * the index only gets the keys that have more documents than it.
+         * suggest(":title comunism") -> [{":title", "comunism", "communism", 1, 42}]
+         */
+        yuca::utils::List<Suggestion> suggest(const std::string &query, std::size_t max_suggestions_per_keyword) const;
+
+        /**
+         * Keeps a trigram index of the given string property of every document, see TrigramIndex.
+         * It answers findDocumentsContaining(property, ...), and when search() ranks by the property
+         * it skips the Levenshtein distance of the results whose value can't be close enough to score.
+         * Documents already indexed are added right away.
+         */
+        void addTrigramIndex(std::string const &property);
+
+        void removeTrigramIndex(std::string const &property);
+
+        bool hasTrigramIndex(std::string const &property) const;
+
+        /**
+         * Documents whose string property contains the substring, ignoring ASCII case.
+         * Without a trigram index of the property every document is checked.
+         */
+        SPDocumentSet findDocumentsContaining(std::string const &property, std::string const &substring) const;
+
+        /**
+         * Keeps the values of the given long or int property of every document sorted, see NumericIndex,
+         * so that ":property [a TO b]", ":property >= a" and the other ranges of search() find the documents
+         * with a value in range. Documents with both a long and an int property of that name are indexed by
+         * the long one. Documents already indexed are added right away.
+         */
+        void addNumericIndex(std::string const &property);
+
+        void removeNumericIndex(std::string const &property);
+
+        bool hasNumericIndex(std::string const &property) const;
+
+        /**
+         * Keeps the keys of every document under the group as term ids, see FacetIndex, so that facets of a group
+         * with many keys are counted from the keys of the matches instead of every posting of the group.
+         * Documents already indexed are added right away.
+         */
+        void addFacetIndex(std::string const &group);
+
+        void removeFacetIndex(std::string const &group);
+
+        bool hasFacetIndex(std::string const &group) const;
+
+        /**
+         * The properties of the indexed documents by property and document ordinal, see ColumnStore.
+         * They are copied when a document is indexed, index it again to update them.
+         */
+        ColumnStore const &getColumns() const;
+
+        /** Ordinal of an indexed document, what its values are found under in getColumns() */
+        bool findOrdinal(long doc_id, DocOrdinal &ordinal) const;
+
         friend std::ostream &operator<<(std::ostream &output_stream, Indexer &indexer);
 
-        yuca::utils::Map<std::string, SPDocumentSet> findDocuments(SearchRequest &search_request) const;
+        /**
+         * Documents matching any of the keywords of each group, by group. Excluded (-keyword) keywords are ignored.
+         * Groups get ANDed, so if any of them has no matches an empty map is returned without building the others.
+         */
+        yuca::utils::Map<std::string, SPDocumentSet> findDocuments(SearchRequest const &search_request) const;
 
         /** Given a key, it finds all related documents to its group */
         SPDocumentSet findDocuments(SPKey key) const;
 
         SPDocumentSet findDocuments(SPKeyList keys) const;
 
+        /**
+         * Allocation free lookup of the documents under a (string, group) key, nothing is copied.
+         * Returns ReverseIndex::NO_DOCUMENTS when there are none.
+         */
+        SPDocumentSet const &findDocuments(StringKeyView const &key) const;
+
+        SPDocumentSet const &findDocuments(yuca::utils::StringView string_key, yuca::utils::StringView group) const;
+
     private:
         /**
          * The Indexer is conformed by multiple reverse indexes,
@@ -241,12 +635,228 @@ namespace yuca {
          * */
         std::shared_ptr<ReverseIndex> getReverseIndex(std::string const &group) const;
 
+        /** Finds an existing ReverseIndex by its group hash, nullptr if there's none. Doesn't allocate */
+        ReverseIndex const *findReverseIndex(long group_id, yuca::utils::StringView group) const;
+
         void addToIndex(std::string const &group, SPDocument doc);
 
+        void removeReverseIndex(std::string const &group);
+
+        /** Gives the document an ordinal, reusing the one it already has or a freed one if possible */
+        DocOrdinal assignOrdinal(SPDocument const &doc);
+
+        /** A query resolved against this Indexer, what the planner and the evaluator work on */
+        struct QueryPostings {
+            // by term index, terms nobody has are empty ranges
+            std::vector<OrdinalRange> terms;
+            // the unions of the keys prefix/wildcard terms expand to, terms point into them
+            std::vector<std::vector<DocOrdinal>> expansions;
+            // by group index, number of documents with at least one key in the group
+            std::vector<std::size_t> group_sizes;
+            // did any prefix/wildcard/fuzzy term expand to more keys than maxTermExpansions?
+            bool truncated_expansions = false;
+            // did any keyword get expanded to its synonyms?
+            bool expanded_synonyms = false;
+            // by term index, nullptr unless the term is a key of a group that keeps positions
+            std::vector<TermPositions const *> positions;
+            // the AND of the live documents and the request's @property=value filters, if it has any
+            DocBitmap filter;
+            std::size_t filter_count = 0;
+        };
+
+        /**
+         * @param candidates sorted ordinals, or nullptr. When given, prefix, wildcard and fuzzy terms whose keys'
+         * postings are large next to the candidates are only resolved for the candidates, by probing those
+         * postings instead of merging them. Such terms then only tell which of the candidates have them.
+         */
+        QueryPostings resolvePostings(PreparedQuery const &prepared_query,
+                                      yuca::utils::List<std::string> const &parameters,
+                                      std::vector<DocOrdinal> const *candidates = nullptr) const;
+
+        /** A keyword's synonyms, with their key ids, see addSynonym() */
+        struct SynonymExpansion {
+            std::string group;
+            std::string keyword;
+            std::vector<std::pair<long, std::string>> synonyms;
+        };
+
+        SynonymExpansion const *findSynonyms(long key_id,
+                                             yuca::utils::StringView group,
+                                             yuca::utils::StringView keyword) const;
+
+        /**
+         * Upper bound of the number of documents the node can match, from the cardinalities of its keys and groups.
+         * The planner runs the most selective operands of an AND first, a 0 means the node can be skipped.
+         */
+        std::size_t estimate(SearchRequest const &search_request,
+                             std::uint32_t node_index,
+                             QueryPostings const &query_postings) const;
+
+        /** Child nodes of an AND that aren't exclusion only clauses, most selective first */
+        std::vector<std::uint32_t> planAnd(SearchRequest const &search_request,
+                                           SearchRequest::QueryNode const &node,
+                                           QueryPostings const &query_postings) const;
+
+        /** Ordinals of the documents that match the given node of the request's query tree */
+        std::vector<DocOrdinal> evaluate(SearchRequest const &search_request,
+                                         std::uint32_t node_index,
+                                         QueryPostings const &query_postings) const;
+
+        /**
+         * Keeps the candidates that match the given node. Instead of materializing the node it probes
+         * its postings for each candidate, so it costs O(candidates * log(postings)), not O(postings).
+         */
+        void filter(SearchRequest const &search_request,
+                    std::uint32_t node_index,
+                    QueryPostings const &query_postings,
+                    std::vector<DocOrdinal> &candidates) const;
+
+        /** filter = filter AND the documents that pass the request's filter at filter_index */
+        void applyFilter(SearchRequest const &search_request, std::size_t filter_index, DocBitmap &filter) const;
+
+        /** Upper bound of the number of documents the whole request, its query tree and its filters, can match */
+        std::size_t estimateMatches(SearchRequest const &search_request, QueryPostings const &query_postings) const;
+
+        /**
+         * Ordinals of the documents that match the query tree and pass the filters. The filters' bitmap drives
+         * the evaluation when it's more selective than the tree, otherwise it's probed for the tree's matches.
+         */
+        std::vector<DocOrdinal> evaluateMatches(SearchRequest const &search_request,
+                                                QueryPostings const &query_postings) const;
+
+        /** Keeps the candidates that match the query tree and pass the filters */
+        void filterMatches(SearchRequest const &search_request,
+                           QueryPostings const &query_postings,
+                           std::vector<DocOrdinal> &candidates) const;
+
+        /** The max_keys keys the matches have the most under the group, see search(..., facet_groups, ...) */
+        Facet countFacet(std::string const &group, std::vector<DocOrdinal> const &matches,
+                         DocBitmap const &match_bitmap, std::size_t max_keys) const;
+
+        /** Keeps the candidates in which the PHRASE or NEAR node's keywords are where it wants them */
+        void keepProximate(SearchRequest::QueryNode const &node,
+                           QueryPostings const &query_postings,
+                           std::vector<DocOrdinal> &candidates) const;
+
+        /** The document's long, or else int, value of the property, false if it has neither */
+        bool findNumericValue(std::string const &property, DocOrdinal ordinal, long &value) const;
+
+        /**
+         * Ordinals of the documents in the RANGE term's range. When the group's property, the group without its ':',
+         * has a numeric index its values are compared as numbers, otherwise the group's keys are compared as strings.
+         */
+        std::vector<DocOrdinal> findRange(yuca::utils::StringView group, yuca::utils::StringView range_text) const;
+
+        /** Puts the positions of the document's key sequence under the group */
+        void putPositions(ReverseIndex &r_index, std::string const &group, SPDocument const &doc, DocOrdinal ordinal);
+
+        /** A clause made only of -excluded keywords, it filters its siblings instead of matching on its own */
+        bool isExclusionOnly(SearchRequest const &search_request, std::uint32_t node_index) const;
+
+        /** candidates = candidates AND NOT (excluded_1 OR ... OR excluded_N) */
+        void exclude(std::vector<DocOrdinal> &candidates, std::vector<OrdinalRange> const &excluded) const;
+
+        /** Every live document AND NOT (excluded_1 OR ... OR excluded_N) */
+        std::vector<DocOrdinal> allDocumentsExcept(std::vector<OrdinalRange> const &excluded) const;
+
+        /**
+         * Scores the matches by how many of the query's keywords they have, and by how close the given
+         * property is to the query, then sorts them by score, unless they're already in order, and truncates them
+         */
+        yuca::utils::List<SearchResult> rankMatches(PreparedQuery const &prepared_query,
+                                                    yuca::utils::List<std::string> const &parameters,
+                                                    std::vector<DocOrdinal> const &matches,
+                                                    QueryPostings const &query_postings,
+                                                    const std::string &opt_main_doc_property_for_query_comparison,
+                                                    unsigned long opt_max_search_results,
+                                                    bool order_by_score = true) const;
+
+        /**
+         * The value the document is collapsed by, see search(..., collapse_by, max_per_group). False if it has none:
+         * the value of the property, or the first key in string order of the key group when it starts with ':'
+         */
+        bool findCollapseKey(std::string const &collapse_by, DocOrdinal ordinal, std::string &collapse_key) const;
+
+        /**
+         * The best options.max_per_group hits of each of the options.max_results best collapse values, hits[i]
+         * being the result of matches[i]. Hits are in sort order already unless by_score. complete is set when
+         * there are options.max_results values, each with as many hits as it can have, so that more matches
+         * further down the sort order couldn't change them.
+         */
+        yuca::utils::List<SearchResult> collapseHits(std::vector<SearchResult> const &hits,
+                                                     std::vector<DocOrdinal> const &matches,
+                                                     SearchOptions const &options,
+                                                     bool by_score,
+                                                     bool &complete) const;
+
+        /** Orders the matches by the sort_by property, only the first max_results are kept if it's > 0 */
+        void sortMatches(std::vector<DocOrdinal> &matches, SortBy const &sort_by, unsigned long max_results) const;
+
+        /**
+         * The first max_results matches in sort_by order, found by walking the property's numeric index in
+         * growing blocks and filtering each block with the query. False when the property has no numeric
+         * index, or fewer than max_results matches have a value in it.
+         */
+        bool findFirstSorted(SearchRequest const &search_request,
+                             QueryPostings const &query_postings,
+                             SortBy const &sort_by,
+                             unsigned long max_results,
+                             std::vector<DocOrdinal> &first) const;
+
+        /** Remembers the generations of the groups the results depend on, along with the results */
+        ResultCache::Entry makeCacheEntry(PreparedQuery const &prepared_query,
+                                          yuca::utils::List<SearchResult> const &results) const;
+
+        /** Has none of the groups the entry depends on changed? */
+        bool isCurrent(ResultCache::Entry const &entry) const;
+
         yuca::utils::Map<std::string, std::shared_ptr<ReverseIndex>> reverseIndices;
 
+        // same reverse indices, by StringKey::groupId(group), so lookups don't need a std::string
+        yuca::utils::Map<long, std::shared_ptr<ReverseIndex>> groupIdReverseIndices;
+
         yuca::utils::Map<long, SPDocument> docPtrCache;
 
+        // documents by ordinal, removed documents leave a nullptr until their ordinal is reused
+        std::vector<SPDocument> ordinalDocuments;
+
+        // document id -> ordinal
+        yuca::utils::Map<long, DocOrdinal> docOrdinals;
+
+        std::vector<DocOrdinal> freeOrdinals;
+
+        // ordinals of the documents currently indexed, the universe -excluded keywords are taken out of
+        DocBitmap liveDocuments;
+
+        // changes whenever a document is indexed or removed
+        std::uint64_t documentsGeneration;
+
+        // changes whenever synonyms, the term expansion limit or the numeric indices change what a query matches
+        std::uint64_t settingsGeneration;
+
+        std::size_t maxTermExpansions;
+
+        // searches are const but they fill the cache, it locks itself so concurrent searches can share it
+        mutable ResultCache resultCache;
+
+        // the documents' properties, by ordinal
+        ColumnStore columns;
+
+        // by property, see addTrigramIndex()
+        std::map<std::string, TrigramIndex> trigramIndices;
+
+        // by property, see addNumericIndex()
+        std::map<std::string, NumericIndex> numericIndices;
+
+        // by group, see addFacetIndex()
+        std::map<std::string, FacetIndex> facetIndices;
+
+        // groups that keep positions, see keepPositions()
+        std::set<std::string> positionalGroups;
+
+        // by the key id of the keyword they expand, see addSynonym()
+        std::unordered_map<long, std::vector<SynonymExpansion>> synonyms;
+
         const std::string implicit_group;
     };
 }
@@ -32,19 +32,22 @@
 
 namespace yuca {
     bool Key::operator<(const Key &right_side) const {
-        return id < right_side.id;
+        if (id != right_side.id) {
+            return id < right_side.id;
+        }
+        return group < right_side.group;
     }
 
     bool Key::operator<=(const Key &right_side) const {
-        return id <= right_side.id;
+        return !(right_side < *this);
     }
 
     bool Key::operator>(const Key &right_side) const {
-        return id > right_side.id;
+        return right_side < *this;
     }
 
     bool Key::operator>=(const Key &right_side) const {
-        return id >= right_side.id;
+        return !(*this < right_side);
     }
 
     bool Key::operator==(const Key &other) const {
@@ -59,6 +62,28 @@ namespace yuca {
         return id;
     }
 
+    bool StringKey::operator<(const Key &right_side) const {
+        auto right_string_key = dynamic_cast<const StringKey *>(&right_side);
+        if (right_string_key == nullptr) {
+            return Key::operator<(right_side);
+        }
+        if (id != right_string_key->id) {
+            return id < right_string_key->id;
+        }
+        if (group != right_string_key->group) {
+            return group < right_string_key->group;
+        }
+        return str_key < right_string_key->str_key;
+    }
+
+    bool StringKey::operator==(const Key &other) const {
+        auto other_string_key = dynamic_cast<const StringKey *>(&other);
+        if (other_string_key == nullptr) {
+            return Key::operator==(other);
+        }
+        return id == other_string_key->id && group == other_string_key->group && str_key == other_string_key->str_key;
+    }
+
     std::ostream &operator<<(std::ostream &output_stream, Key &key) {
         output_stream << "Key(@" << (long(&key) % 10000) << ", id=" << key.id << ", group=" << key.group << ")";
         output_stream.flush();
@@ -31,6 +31,7 @@
 
 #include <string>
 #include <utility>
+#include "hash.hpp"
 
 namespace yuca {
     class Key {
@@ -45,6 +46,7 @@ namespace yuca {
         virtual ~Key() = default;
 
         // THIS OPERATOR IS USED FOR std::set.find()
+        // Keys are ordered by id first, then by group, so that two keys whose ids collide are still told apart
         virtual bool operator<(const Key &right_side) const;
 
         virtual bool operator<=(const Key &right_side) const;
@@ -68,19 +70,66 @@ namespace yuca {
 
     class StringKey : public Key {
     public:
+        /** The id is a stable 64-bit hash of (group, string_key), see yuca::utils::hashKey */
         explicit StringKey(const std::string &string_key, const std::string &my_group) :
-        Key(static_cast<long>(std::hash<std::string>{}(my_group + string_key)), my_group), str_key(string_key) {
+        Key(keyId(groupId(my_group), string_key), my_group), str_key(string_key) {
         }
 
-        std::string getString() const {
+        std::string const &getString() const noexcept {
             return str_key;
         }
 
+        /** Does this key hold exactly this string? Doesn't allocate */
+        bool hasString(yuca::utils::StringView string_key) const noexcept {
+            return yuca::utils::StringView(str_key) == string_key;
+        }
+
+        /** Hash of a group name, it's also the seed used to hash the group's keys */
+        static long groupId(yuca::utils::StringView group) noexcept {
+            return static_cast<long>(yuca::utils::hash64(group));
+        }
+
+        /**
+         * The id a StringKey(string_key, group) would have, given groupId(group).
+         * Lets callers pre-hash query keys without building StringKey objects.
+         */
+        static long keyId(long group_id, yuca::utils::StringView string_key) noexcept {
+            return static_cast<long>(yuca::utils::hash64(string_key, static_cast<std::uint64_t>(group_id)));
+        }
+
+        /** Ids can collide, when comparing against another StringKey with the same id and group the strings decide */
+        bool operator<(const Key &right_side) const override;
+
+        bool operator==(const Key &other) const override;
+
         friend std::ostream &operator<<(std::ostream &output_stream, StringKey &key);
 
     private:
         std::string str_key;
     };
+
+    /**
+     * A non-owning (string, group) pair with the ids a StringKey would have for them.
+     * Meant for lookups, it never allocates. The viewed strings must outlive it.
+     */
+    struct StringKeyView {
+        StringKeyView(yuca::utils::StringView a_string_key, yuca::utils::StringView a_group) noexcept :
+        StringKeyView(a_string_key, a_group, StringKey::groupId(a_group)) {
+        }
+
+        /** Use when the group has already been hashed, e.g. for all the keywords of the same group */
+        StringKeyView(yuca::utils::StringView a_string_key, yuca::utils::StringView a_group, long a_group_id) noexcept :
+        string_key(a_string_key),
+        group(a_group),
+        group_id(a_group_id),
+        id(StringKey::keyId(a_group_id, a_string_key)) {
+        }
+
+        yuca::utils::StringView string_key;
+        yuca::utils::StringView group;
+        long group_id;
+        long id;
+    };
 }
 
 #endif //YUCA_KEY_H
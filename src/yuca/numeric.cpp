@@ -0,0 +1,215 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <limits>
+#include "numeric.hpp"
+
+namespace yuca {
+    NumericIndex::NumericIndex(NumericIndex const &other) : flushed(true), document_count(0) {
+        *this = other;
+    }
+
+    NumericIndex::NumericIndex(NumericIndex &&other) : flushed(true), document_count(0) {
+        *this = std::move(other);
+    }
+
+    NumericIndex &NumericIndex::operator=(NumericIndex const &other) {
+        if (this == &other) {
+            return *this;
+        }
+        // a reader of the other index could be flushing it
+        std::lock(flush_mutex, other.flush_mutex);
+        std::lock_guard<std::mutex> lock(flush_mutex, std::adopt_lock);
+        std::lock_guard<std::mutex> other_lock(other.flush_mutex, std::adopt_lock);
+        property = other.property;
+        entries = other.entries;
+        pending = other.pending;
+        stale = other.stale;
+        flushed.store(other.flushed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        values = other.values;
+        documents = other.documents;
+        document_count = other.document_count;
+        return *this;
+    }
+
+    NumericIndex &NumericIndex::operator=(NumericIndex &&other) {
+        if (this == &other) {
+            return *this;
+        }
+        std::lock(flush_mutex, other.flush_mutex);
+        std::lock_guard<std::mutex> lock(flush_mutex, std::adopt_lock);
+        std::lock_guard<std::mutex> other_lock(other.flush_mutex, std::adopt_lock);
+        property = std::move(other.property);
+        entries = std::move(other.entries);
+        pending = std::move(other.pending);
+        stale = std::move(other.stale);
+        flushed.store(other.flushed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        values = std::move(other.values);
+        documents = std::move(other.documents);
+        document_count = other.document_count;
+        return *this;
+    }
+
+    std::string const &NumericIndex::getProperty() const noexcept {
+        return property;
+    }
+
+    void NumericIndex::putDocument(DocOrdinal ordinal, long value) {
+        removeDocument(ordinal);
+        if (ordinal >= values.size()) {
+            values.resize(static_cast<std::size_t>(ordinal) + 1, 0);
+        }
+        values[ordinal] = value;
+        documents.set(ordinal);
+        document_count++;
+        pending.push_back(std::make_pair(value, ordinal));
+        flushed.store(false, std::memory_order_relaxed);
+    }
+
+    void NumericIndex::removeDocument(DocOrdinal ordinal) {
+        if (!hasDocument(ordinal)) {
+            return;
+        }
+        documents.unset(ordinal);
+        document_count--;
+        stale.push_back(ordinal);
+        flushed.store(false, std::memory_order_relaxed);
+    }
+
+    bool NumericIndex::hasDocument(DocOrdinal ordinal) const noexcept {
+        return documents.test(ordinal);
+    }
+
+    std::size_t NumericIndex::getDocumentCount() const noexcept {
+        return document_count;
+    }
+
+    std::vector<DocOrdinal> NumericIndex::findRange(long min, long max) const {
+        std::vector<DocOrdinal> ordinals;
+        auto range = equalRange(min, max);
+        ordinals.reserve(static_cast<std::size_t>(range.second - range.first));
+        for (auto entry_it = range.first; entry_it != range.second; ++entry_it) {
+            ordinals.push_back(entry_it->second);
+        }
+        std::sort(ordinals.begin(), ordinals.end());
+        return ordinals;
+    }
+
+    std::size_t NumericIndex::countRange(long min, long max) const {
+        auto range = equalRange(min, max);
+        return static_cast<std::size_t>(range.second - range.first);
+    }
+
+    std::vector<NumericIndex::Entry> const &NumericIndex::getSortedEntries() const {
+        flush();
+        return entries;
+    }
+
+    void NumericIndex::clear() {
+        std::vector<Entry>().swap(entries);
+        pending.clear();
+        stale.clear();
+        std::vector<long>().swap(values);
+        documents.clear();
+        document_count = 0;
+        flushed.store(true, std::memory_order_relaxed);
+    }
+
+    bool NumericIndex::parseLong(yuca::utils::StringView text, long &value) noexcept {
+        std::size_t i = 0;
+        bool negative = false;
+        if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+            negative = text[i] == '-';
+            i++;
+        }
+        if (i == text.size()) {
+            return false;
+        }
+        // accumulated as a negative number, its range reaches one further than the positive one
+        long result = 0;
+        const long lowest = std::numeric_limits<long>::min();
+        for (; i < text.size(); i++) {
+            if (text[i] < '0' || text[i] > '9') {
+                return false;
+            }
+            long digit = text[i] - '0';
+            if (result < (lowest + digit) / 10) {
+                return false;
+            }
+            result = result * 10 - digit;
+        }
+        if (!negative && result == lowest) {
+            return false;
+        }
+        value = negative ? result : -result;
+        return true;
+    }
+
+    void NumericIndex::flush() const {
+        if (flushed.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(flush_mutex);
+        if (flushed.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (!stale.empty()) {
+            DocBitmap stale_ordinals;
+            for (DocOrdinal ordinal : stale) {
+                stale_ordinals.set(ordinal);
+            }
+            entries.erase(std::remove_if(entries.begin(), entries.end(), [&stale_ordinals](Entry const &entry) {
+                return stale_ordinals.test(entry.second);
+            }), entries.end());
+            stale.clear();
+        }
+        if (!pending.empty()) {
+            // a document put more than once only keeps its current value
+            pending.erase(std::remove_if(pending.begin(), pending.end(), [this](Entry const &entry) {
+                return !documents.test(entry.second) || values[entry.second] != entry.first;
+            }), pending.end());
+            std::sort(pending.begin(), pending.end());
+            pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+            std::size_t sorted_count = entries.size();
+            entries.insert(entries.end(), pending.begin(), pending.end());
+            std::inplace_merge(entries.begin(), entries.begin() + static_cast<long>(sorted_count), entries.end());
+            pending.clear();
+        }
+        flushed.store(true, std::memory_order_release);
+    }
+
+    std::pair<std::vector<NumericIndex::Entry>::const_iterator, std::vector<NumericIndex::Entry>::const_iterator>
+    NumericIndex::equalRange(long min, long max) const {
+        flush();
+        if (min > max) {
+            return std::make_pair(entries.cend(), entries.cend());
+        }
+        auto first = std::lower_bound(entries.cbegin(), entries.cend(), std::make_pair(min, DocOrdinal(0)));
+        auto last = std::upper_bound(first, entries.cend(),
+                                     std::make_pair(max, std::numeric_limits<DocOrdinal>::max()));
+        return std::make_pair(first, last);
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+//
+// Sorted index over a numeric (long or int) property of the indexed documents.
+//
+// (value, ordinal) pairs are kept sorted by value, a range of values is then a contiguous run of the
+// array found with two binary searches. Writes are buffered and merged into the array by the first read
+// after them, so indexing many documents doesn't shift it once per document. That merge is done under a
+// lock, concurrent reads only ever see the merged array; writes still need the index to themselves.
+//
+
+#ifndef YUCA_NUMERIC_HPP
+#define YUCA_NUMERIC_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "postings.hpp"
+#include "utils.hpp"
+
+namespace yuca {
+    /** The values of one numeric property, sorted, by document ordinal */
+    class NumericIndex {
+    public:
+        typedef std::pair<long, DocOrdinal> Entry;
+
+        explicit NumericIndex(std::string const &a_property) :
+        property(a_property),
+        flushed(true),
+        document_count(0) {
+        }
+
+        /** Copies and moves take the other index's values, each index keeps its own lock */
+        NumericIndex(NumericIndex const &other);
+
+        NumericIndex(NumericIndex &&other);
+
+        NumericIndex &operator=(NumericIndex const &other);
+
+        NumericIndex &operator=(NumericIndex &&other);
+
+        std::string const &getProperty() const noexcept;
+
+        /** Indexes the document's value of the property, replacing the one it had */
+        void putDocument(DocOrdinal ordinal, long value);
+
+        void removeDocument(DocOrdinal ordinal);
+
+        bool hasDocument(DocOrdinal ordinal) const noexcept;
+
+        /** Number of documents with a value */
+        std::size_t getDocumentCount() const noexcept;
+
+        /** Ordinals, in increasing order, of the documents with min <= value <= max */
+        std::vector<DocOrdinal> findRange(long min, long max) const;
+
+        /** Number of documents with min <= value <= max, without collecting them */
+        std::size_t countRange(long min, long max) const;
+
+        /** The (value, ordinal) pairs sorted by value, then ordinal. Good until the next write */
+        std::vector<Entry> const &getSortedEntries() const;
+
+        void clear();
+
+        /** Parses a base 10 long, an optional sign and digits only. False if it isn't one or it overflows */
+        static bool parseLong(yuca::utils::StringView text, long &value) noexcept;
+
+    private:
+        /** Merges the buffered writes into the sorted entries, once, when some of the readers gets there first */
+        void flush() const;
+
+        /** The run of sorted entries with min <= value <= max */
+        std::pair<std::vector<Entry>::const_iterator, std::vector<Entry>::const_iterator>
+        equalRange(long min, long max) const;
+
+        std::string property;
+
+        // sorted by value, then ordinal
+        mutable std::vector<Entry> entries;
+
+        // put since the last flush(), some of them may have been replaced or removed since
+        mutable std::vector<Entry> pending;
+
+        // ordinals whose sorted entry got replaced or removed since the last flush()
+        mutable std::vector<DocOrdinal> stale;
+
+        // held while flush() merges
+        mutable std::mutex flush_mutex;
+
+        // no writes are buffered, entries can be read as they are
+        mutable std::atomic<bool> flushed;
+
+        // current values by ordinal
+        std::vector<long> values;
+
+        // ordinals that have a value
+        DocBitmap documents;
+
+        std::size_t document_count;
+    };
+}
+
+#endif //YUCA_NUMERIC_HPP
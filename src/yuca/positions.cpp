@@ -0,0 +1,124 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include "positions.hpp"
+
+namespace yuca {
+    const TermPositions TermPositions::EMPTY;
+
+    void TermPositions::put(DocOrdinal ordinal, std::vector<KeyPosition> const &positions) {
+        if (positions.empty()) {
+            remove(ordinal);
+            return;
+        }
+        std::string &encoded = lists[ordinal];
+        encoded.clear();
+        positions::encode(positions, encoded);
+    }
+
+    void TermPositions::remove(DocOrdinal ordinal) {
+        lists.erase(ordinal);
+    }
+
+    bool TermPositions::decode(DocOrdinal ordinal, std::vector<KeyPosition> &out) const {
+        auto list_it = lists.find(ordinal);
+        if (list_it == lists.end()) {
+            return false;
+        }
+        positions::decode(list_it->second, out);
+        return true;
+    }
+
+    std::size_t TermPositions::size() const noexcept {
+        return lists.size();
+    }
+
+    namespace positions {
+        void encode(std::vector<KeyPosition> const &positions, std::string &out) {
+            KeyPosition previous = 0;
+            for (KeyPosition position : positions) {
+                KeyPosition delta = position - previous;
+                previous = position;
+                // 7 bits at a time, the high bit says more follow
+                while (delta >= 0x80) {
+                    out.push_back(static_cast<char>((delta & 0x7f) | 0x80));
+                    delta >>= 7;
+                }
+                out.push_back(static_cast<char>(delta));
+            }
+        }
+
+        void decode(std::string const &encoded, std::vector<KeyPosition> &out) {
+            KeyPosition previous = 0;
+            KeyPosition delta = 0;
+            unsigned shift = 0;
+            for (char c : encoded) {
+                auto byte = static_cast<unsigned char>(c);
+                delta |= static_cast<KeyPosition>(byte & 0x7f) << shift;
+                if ((byte & 0x80) != 0) {
+                    shift += 7;
+                    continue;
+                }
+                previous += delta;
+                out.push_back(previous);
+                delta = 0;
+                shift = 0;
+            }
+        }
+
+        bool matchSequence(std::vector<std::vector<KeyPosition>> const &lists,
+                           std::vector<std::uint32_t> const &max_distances) {
+            if (lists.empty()) {
+                return false;
+            }
+            // positions of the current list reachable through a chain of picks from the previous lists
+            std::vector<KeyPosition> reachable(lists[0]);
+            std::vector<KeyPosition> next;
+            for (std::size_t i = 1; i < lists.size() && !reachable.empty(); i++) {
+                std::uint32_t max_distance = max_distances[i - 1];
+                next.clear();
+                for (KeyPosition position : lists[i]) {
+                    if (max_distance == 0) {
+                        if (position > 0 && std::binary_search(reachable.begin(), reachable.end(), position - 1)) {
+                            next.push_back(position);
+                        }
+                        continue;
+                    }
+                    KeyPosition low = position > max_distance ? position - max_distance : 0;
+                    for (auto it = std::lower_bound(reachable.begin(), reachable.end(), low);
+                         it != reachable.end() && *it <= position + max_distance; ++it) {
+                        if (*it != position) {
+                            next.push_back(position);
+                            break;
+                        }
+                    }
+                }
+                reachable.swap(next);
+            }
+            return !reachable.empty();
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Positional postings, where in a document's key sequence each of its keys is.
+//
+// Positions of a key in a document are sorted, delta encoded and written as varints, a short list
+// fits in a std::string's inline buffer. They are only decoded for the documents that already have
+// all of a phrase's keys, to check the keys are where the phrase wants them.
+//
+
+#ifndef YUCA_POSITIONS_HPP
+#define YUCA_POSITIONS_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "postings.hpp"
+
+namespace yuca {
+    typedef std::uint32_t KeyPosition;
+
+    /** The encoded positions of one key, by the ordinal of the documents that have it */
+    class TermPositions {
+    public:
+        /** @param positions sorted, duplicate free */
+        void put(DocOrdinal ordinal, std::vector<KeyPosition> const &positions);
+
+        void remove(DocOrdinal ordinal);
+
+        /** Appends the document's positions to out, false if there are none */
+        bool decode(DocOrdinal ordinal, std::vector<KeyPosition> &out) const;
+
+        std::size_t size() const noexcept;
+
+        static const TermPositions EMPTY;
+
+    private:
+        std::unordered_map<DocOrdinal, std::string> lists;
+    };
+
+    namespace positions {
+        void encode(std::vector<KeyPosition> const &positions, std::string &out);
+
+        void decode(std::string const &encoded, std::vector<KeyPosition> &out);
+
+        /**
+         * Can one position be picked from each list so that every position follows the previous one?
+         * With max_distance 0 each must come right after it (a phrase), otherwise it must be within
+         * max_distances[i - 1] positions of it on either side (NEAR/k).
+         */
+        bool matchSequence(std::vector<std::vector<KeyPosition>> const &lists,
+                           std::vector<std::uint32_t> const &max_distances);
+    }
+}
+
+#endif //YUCA_POSITIONS_HPP
@@ -0,0 +1,322 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "postings.hpp"
+
+namespace yuca {
+    namespace {
+        inline std::size_t popCount(std::uint64_t word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<std::size_t>(__builtin_popcountll(word));
+#else
+            std::size_t n = 0;
+            while (word != 0) {
+                word &= word - 1;
+                n++;
+            }
+            return n;
+#endif
+        }
+
+        inline unsigned countTrailingZeros(std::uint64_t word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+            unsigned n = 0;
+            while ((word & 1) == 0) {
+                word >>= 1;
+                n++;
+            }
+            return n;
+#endif
+        }
+    }
+
+    const PostingList PostingList::EMPTY;
+
+    bool PostingList::add(DocOrdinal ordinal) {
+        if (ordinals.empty() || ordinal > ordinals.back()) {
+            ordinals.push_back(ordinal);
+            return true;
+        }
+        auto it = std::lower_bound(ordinals.begin(), ordinals.end(), ordinal);
+        if (it != ordinals.end() && *it == ordinal) {
+            return false;
+        }
+        ordinals.insert(it, ordinal);
+        return true;
+    }
+
+    bool PostingList::remove(DocOrdinal ordinal) {
+        auto it = std::lower_bound(ordinals.begin(), ordinals.end(), ordinal);
+        if (it == ordinals.end() || *it != ordinal) {
+            return false;
+        }
+        ordinals.erase(it);
+        return true;
+    }
+
+    bool PostingCursor::advance(DocOrdinal target) noexcept {
+        if (pos == last || *pos >= target) {
+            return pos != last;
+        }
+        std::size_t remaining = static_cast<std::size_t>(last - pos);
+        std::size_t step = 1;
+        while (step < remaining && pos[step] < target) {
+            step <<= 1;
+        }
+        const DocOrdinal *lo = pos + (step >> 1);
+        const DocOrdinal *hi = step < remaining ? pos + step + 1 : last;
+        pos = std::lower_bound(lo, hi, target);
+        return pos != last;
+    }
+
+    void DocBitmap::orWith(OrdinalRange const &ordinals) {
+        if (ordinals.isEmpty()) {
+            return;
+        }
+        ensureCapacity(static_cast<std::size_t>(*(ordinals.end() - 1)) + 1);
+        for (DocOrdinal ordinal : ordinals) {
+            words[ordinal >> 6] |= std::uint64_t(1) << (ordinal & 63);
+        }
+    }
+
+    void DocBitmap::orWith(DocBitmap const &other) {
+        ensureCapacity(other.words.size() * 64);
+        for (std::size_t i = 0; i < other.words.size(); i++) {
+            words[i] |= other.words[i];
+        }
+    }
+
+    void DocBitmap::andWith(DocBitmap const &other) noexcept {
+        std::size_t common = std::min(words.size(), other.words.size());
+        for (std::size_t i = 0; i < common; i++) {
+            words[i] &= other.words[i];
+        }
+        for (std::size_t i = common; i < words.size(); i++) {
+            words[i] = 0;
+        }
+    }
+
+    void DocBitmap::andNot(OrdinalRange const &ordinals) noexcept {
+        for (DocOrdinal ordinal : ordinals) {
+            if ((ordinal >> 6) >= words.size()) {
+                break;
+            }
+            words[ordinal >> 6] &= ~(std::uint64_t(1) << (ordinal & 63));
+        }
+    }
+
+    void DocBitmap::andNot(DocBitmap const &other) noexcept {
+        std::size_t common = std::min(words.size(), other.words.size());
+        for (std::size_t i = 0; i < common; i++) {
+            words[i] &= ~other.words[i];
+        }
+    }
+
+    std::size_t DocBitmap::count() const noexcept {
+        std::size_t n = 0;
+        for (std::uint64_t word : words) {
+            n += popCount(word);
+        }
+        return n;
+    }
+
+    void DocBitmap::toOrdinals(std::vector<DocOrdinal> &out) const {
+        for (std::size_t i = 0; i < words.size(); i++) {
+            std::uint64_t word = words[i];
+            while (word != 0) {
+                out.push_back(static_cast<DocOrdinal>(i * 64 + countTrailingZeros(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+    namespace postings {
+        void intersectWith(std::vector<DocOrdinal> &candidates, OrdinalRange const &ordinals) {
+            PostingCursor cursor(ordinals);
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < candidates.size(); i++) {
+                if (!cursor.advance(candidates[i])) {
+                    break;
+                }
+                if (cursor.current() == candidates[i]) {
+                    candidates[kept++] = candidates[i];
+                }
+            }
+            candidates.resize(kept);
+        }
+
+        void intersectWith(std::vector<DocOrdinal> &candidates, DocBitmap const &bitmap) {
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < candidates.size(); i++) {
+                if (bitmap.test(candidates[i])) {
+                    candidates[kept++] = candidates[i];
+                }
+            }
+            candidates.resize(kept);
+        }
+
+        void intersectWithAny(std::vector<DocOrdinal> &candidates, std::vector<OrdinalRange> const &lists) {
+            std::vector<bool> found(candidates.size(), false);
+            for (auto const &list : lists) {
+                PostingCursor cursor(list);
+                for (std::size_t i = 0; i < candidates.size(); i++) {
+                    if (!cursor.advance(candidates[i])) {
+                        break;
+                    }
+                    if (cursor.current() == candidates[i]) {
+                        found[i] = true;
+                    }
+                }
+            }
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < candidates.size(); i++) {
+                if (found[i]) {
+                    candidates[kept++] = candidates[i];
+                }
+            }
+            candidates.resize(kept);
+        }
+
+        void subtract(std::vector<DocOrdinal> &candidates, OrdinalRange const &ordinals) {
+            PostingCursor cursor(ordinals);
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < candidates.size(); i++) {
+                if (!cursor.advance(candidates[i]) || cursor.current() != candidates[i]) {
+                    candidates[kept++] = candidates[i];
+                }
+            }
+            candidates.resize(kept);
+        }
+
+        std::vector<DocOrdinal> intersectAll(std::vector<OrdinalRange> lists) {
+            std::vector<DocOrdinal> result;
+            if (lists.empty()) {
+                return result;
+            }
+            std::sort(lists.begin(), lists.end(), [](OrdinalRange const &a, OrdinalRange const &b) {
+                return a.size() < b.size();
+            });
+            result.assign(lists[0].begin(), lists[0].end());
+            for (std::size_t i = 1; i < lists.size() && !result.empty(); i++) {
+                intersectWith(result, lists[i]);
+            }
+            return result;
+        }
+
+        std::vector<DocOrdinal> unionAll(std::vector<OrdinalRange> const &lists, std::size_t max_ordinal) {
+            std::vector<DocOrdinal> result;
+            std::size_t total = 0;
+            const OrdinalRange *non_empty = nullptr;
+            std::size_t non_empty_count = 0;
+            for (auto const &list : lists) {
+                total += list.size();
+                if (!list.isEmpty()) {
+                    non_empty = &list;
+                    non_empty_count++;
+                }
+            }
+            if (non_empty_count == 0) {
+                return result;
+            }
+            if (non_empty_count == 1) {
+                result.assign(non_empty->begin(), non_empty->end());
+                return result;
+            }
+            // a bitmap costs max_ordinal / 64 words to set up and scan, merging costs total * log(lists)
+            if (total * 64 >= max_ordinal) {
+                DocBitmap bitmap(max_ordinal);
+                for (auto const &list : lists) {
+                    bitmap.orWith(list);
+                }
+                result.reserve(total);
+                bitmap.toOrdinals(result);
+                return result;
+            }
+            // k-way merge, a min heap of cursors keyed by their current ordinal
+            std::vector<PostingCursor> heap;
+            heap.reserve(non_empty_count);
+            for (auto const &list : lists) {
+                if (!list.isEmpty()) {
+                    heap.emplace_back(list);
+                }
+            }
+            auto after = [](PostingCursor const &a, PostingCursor const &b) {
+                return a.current() > b.current();
+            };
+            std::make_heap(heap.begin(), heap.end(), after);
+            result.reserve(total);
+            while (!heap.empty()) {
+                std::pop_heap(heap.begin(), heap.end(), after);
+                PostingCursor &cursor = heap.back();
+                if (result.empty() || result.back() != cursor.current()) {
+                    result.push_back(cursor.current());
+                }
+                cursor.next();
+                if (cursor.isDone()) {
+                    heap.pop_back();
+                } else {
+                    std::push_heap(heap.begin(), heap.end(), after);
+                }
+            }
+            return result;
+        }
+
+        std::vector<DocOrdinal> atLeast(std::vector<OrdinalRange> const &lists, std::size_t min_should_match) {
+            std::vector<DocOrdinal> result;
+            if (min_should_match > lists.size()) {
+                return result;
+            }
+            std::vector<PostingCursor> cursors;
+            cursors.reserve(lists.size());
+            for (auto const &list : lists) {
+                if (!list.isEmpty()) {
+                    cursors.emplace_back(list);
+                }
+            }
+            // walk all the lists in ordinal order counting in how many of them each ordinal appears
+            while (cursors.size() >= min_should_match && !cursors.empty()) {
+                DocOrdinal smallest = cursors[0].current();
+                for (auto const &cursor : cursors) {
+                    smallest = std::min(smallest, cursor.current());
+                }
+                std::size_t matches = 0;
+                for (auto &cursor : cursors) {
+                    if (cursor.current() == smallest) {
+                        matches++;
+                        cursor.next();
+                    }
+                }
+                if (matches >= min_should_match) {
+                    result.push_back(smallest);
+                }
+                cursors.erase(std::remove_if(cursors.begin(), cursors.end(), [](PostingCursor const &cursor) {
+                    return cursor.isDone();
+                }), cursors.end());
+            }
+            return result;
+        }
+    }
+}
@@ -0,0 +1,242 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Posting lists of document ordinals and the set operations the query engine runs on them.
+//
+// Every Document indexed by an Indexer gets a small dense integer, its ordinal.
+// Postings are sorted ordinal arrays, so they can be intersected by skipping ahead (galloping)
+// instead of probing std::sets, and turned into bitmaps when they get dense.
+//
+
+#ifndef YUCA_POSTINGS_HPP
+#define YUCA_POSTINGS_HPP
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace yuca {
+    typedef std::uint32_t DocOrdinal;
+
+    /** A read-only range over a sorted, duplicate free array of ordinals */
+    struct OrdinalRange {
+        OrdinalRange() : first(nullptr), last(nullptr) {
+        }
+
+        OrdinalRange(const DocOrdinal *a_first, const DocOrdinal *a_last) : first(a_first), last(a_last) {
+        }
+
+        explicit OrdinalRange(std::vector<DocOrdinal> const &ordinals) :
+        first(ordinals.data()),
+        last(ordinals.data() + ordinals.size()) {
+        }
+
+        std::size_t size() const noexcept {
+            return static_cast<std::size_t>(last - first);
+        }
+
+        bool isEmpty() const noexcept {
+            return first == last;
+        }
+
+        bool contains(DocOrdinal ordinal) const noexcept {
+            return std::binary_search(first, last, ordinal);
+        }
+
+        const DocOrdinal *begin() const noexcept {
+            return first;
+        }
+
+        const DocOrdinal *end() const noexcept {
+            return last;
+        }
+
+        const DocOrdinal *first;
+        const DocOrdinal *last;
+    };
+
+    /** Sorted, duplicate free list of the ordinals of the documents under a key */
+    class PostingList {
+    public:
+        /** Appends in O(1) when ordinals come in increasing order, which is the common case */
+        bool add(DocOrdinal ordinal);
+
+        bool remove(DocOrdinal ordinal);
+
+        bool contains(DocOrdinal ordinal) const noexcept {
+            return range().contains(ordinal);
+        }
+
+        std::size_t size() const noexcept {
+            return ordinals.size();
+        }
+
+        bool isEmpty() const noexcept {
+            return ordinals.empty();
+        }
+
+        void clear() noexcept {
+            ordinals.clear();
+        }
+
+        OrdinalRange range() const noexcept {
+            return OrdinalRange(ordinals);
+        }
+
+        std::vector<DocOrdinal> const &getStdVector() const noexcept {
+            return ordinals;
+        }
+
+        static const PostingList EMPTY;
+
+    private:
+        std::vector<DocOrdinal> ordinals;
+    };
+
+    /** Forward only cursor over an OrdinalRange */
+    class PostingCursor {
+    public:
+        explicit PostingCursor(OrdinalRange const &a_range) : pos(a_range.first), last(a_range.last) {
+        }
+
+        bool isDone() const noexcept {
+            return pos == last;
+        }
+
+        DocOrdinal current() const noexcept {
+            return *pos;
+        }
+
+        void next() noexcept {
+            ++pos;
+        }
+
+        /**
+         * Skips to the first ordinal >= target. It gallops (1, 2, 4, ... steps) and then binary searches
+         * the last step, so skipping over long runs costs O(log distance).
+         * @return false if the cursor got exhausted
+         */
+        bool advance(DocOrdinal target) noexcept;
+
+    private:
+        const DocOrdinal *pos;
+        const DocOrdinal *last;
+    };
+
+    /** Dense bitset over document ordinals */
+    class DocBitmap {
+    public:
+        DocBitmap() = default;
+
+        explicit DocBitmap(std::size_t num_bits) : words((num_bits + 63) / 64, 0) {
+        }
+
+        /** Grows (never shrinks) so that it can hold ordinals in [0, num_bits) */
+        void ensureCapacity(std::size_t num_bits) {
+            std::size_t num_words = (num_bits + 63) / 64;
+            if (num_words > words.size()) {
+                words.resize(num_words, 0);
+            }
+        }
+
+        void set(DocOrdinal ordinal) {
+            ensureCapacity(static_cast<std::size_t>(ordinal) + 1);
+            words[ordinal >> 6] |= std::uint64_t(1) << (ordinal & 63);
+        }
+
+        void unset(DocOrdinal ordinal) noexcept {
+            if ((ordinal >> 6) < words.size()) {
+                words[ordinal >> 6] &= ~(std::uint64_t(1) << (ordinal & 63));
+            }
+        }
+
+        bool test(DocOrdinal ordinal) const noexcept {
+            return (ordinal >> 6) < words.size() && ((words[ordinal >> 6] >> (ordinal & 63)) & 1) != 0;
+        }
+
+        void clear() noexcept {
+            words.clear();
+        }
+
+        void orWith(OrdinalRange const &ordinals);
+
+        void orWith(DocBitmap const &other);
+
+        void andWith(DocBitmap const &other) noexcept;
+
+        /** this = this AND NOT ordinals, one word write per ordinal */
+        void andNot(OrdinalRange const &ordinals) noexcept;
+
+        void andNot(DocBitmap const &other) noexcept;
+
+        std::size_t count() const noexcept;
+
+        /** Appends the set ordinals in increasing order */
+        void toOrdinals(std::vector<DocOrdinal> &out) const;
+
+        std::vector<std::uint64_t> const &getWords() const noexcept {
+            return words;
+        }
+
+        std::vector<std::uint64_t> &getWords() noexcept {
+            return words;
+        }
+
+    private:
+        std::vector<std::uint64_t> words;
+    };
+
+    namespace postings {
+        /** candidates = candidates AND ordinals, by galloping over ordinals */
+        void intersectWith(std::vector<DocOrdinal> &candidates, OrdinalRange const &ordinals);
+
+        /** candidates = candidates AND bitmap, one bit test per candidate */
+        void intersectWith(std::vector<DocOrdinal> &candidates, DocBitmap const &bitmap);
+
+        /**
+         * candidates = candidates AND (lists_1 OR ... OR lists_N), galloping over each list. Costs about
+         * O(lists * candidates * log), cheaper than their union when the candidates are few.
+         */
+        void intersectWithAny(std::vector<DocOrdinal> &candidates, std::vector<OrdinalRange> const &lists);
+
+        /** candidates = candidates AND NOT ordinals, by galloping over ordinals */
+        void subtract(std::vector<DocOrdinal> &candidates, OrdinalRange const &ordinals);
+
+        /** Intersection of all the given lists, smallest first, so that each step can skip the most */
+        std::vector<DocOrdinal> intersectAll(std::vector<OrdinalRange> lists);
+
+        /**
+         * Union of all the given lists. Merges when they are small relative to the ordinal space and
+         * goes through a DocBitmap otherwise.
+         * @param max_ordinal one past the largest possible ordinal
+         */
+        std::vector<DocOrdinal> unionAll(std::vector<OrdinalRange> const &lists, std::size_t max_ordinal);
+
+        /** Ordinals that appear in at least min_should_match of the given lists */
+        std::vector<DocOrdinal> atLeast(std::vector<OrdinalRange> const &lists, std::size_t min_should_match);
+    }
+}
+
+#endif //YUCA_POSTINGS_HPP
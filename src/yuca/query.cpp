@@ -0,0 +1,681 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Created by gubatron.
+//
+
+#include <algorithm>
+#include "query.hpp"
+#include "key.hpp"
+
+namespace yuca {
+    namespace {
+        inline bool isQuerySpace(char c) noexcept {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        inline bool isWordEnd(char c) noexcept {
+            return isQuerySpace(c) || c == '(' || c == ')';
+        }
+
+        inline bool isComparison(yuca::utils::StringView text) noexcept {
+            return text == ">" || text == ">=" || text == "<" || text == "<=";
+        }
+
+        yuca::utils::StringView trim(yuca::utils::StringView text) noexcept {
+            std::size_t start = 0;
+            std::size_t end = text.size();
+            while (start < end && isQuerySpace(text[start])) {
+                start++;
+            }
+            while (end > start && isQuerySpace(text[end - 1])) {
+                end--;
+            }
+            return text.subView(start, end - start);
+        }
+
+        /** "*" is an open bound */
+        yuca::utils::StringView rangeBound(yuca::utils::StringView text) noexcept {
+            text = trim(text);
+            return text == "*" ? yuca::utils::StringView() : text;
+        }
+    }
+
+    const std::uint32_t SearchRequest::NO_NODE;
+
+    const std::uint32_t SearchRequest::MAX_FUZZY_EDITS;
+
+    SearchRequest::TermType SearchRequest::termType(yuca::utils::StringView keyword, std::uint32_t &max_edits) noexcept {
+        if (keyword == "?") {
+            // a prepared query parameter
+            return EXACT;
+        }
+        if (keyword.size() > 1 && (keyword[0] == '[' || keyword[0] == '{' || keyword[0] == '<' || keyword[0] == '>')) {
+            return RANGE;
+        }
+        // keyword~ or keyword~N
+        std::size_t tilde = keyword.size();
+        while (tilde > 0 && keyword[tilde - 1] >= '0' && keyword[tilde - 1] <= '9') {
+            tilde--;
+        }
+        if (tilde > 1 && keyword[tilde - 1] == '~' && keyword.size() - tilde <= 1) {
+            max_edits = tilde == keyword.size() ? MAX_FUZZY_EDITS :
+                        std::min<std::uint32_t>(static_cast<std::uint32_t>(keyword[tilde] - '0'), MAX_FUZZY_EDITS);
+            return FUZZY;
+        }
+        std::size_t wildcards = 0;
+        for (char c : keyword) {
+            wildcards += (c == '*' || c == '?') ? 1 : 0;
+        }
+        if (wildcards == 0) {
+            return EXACT;
+        }
+        return wildcards == 1 && keyword[keyword.size() - 1] == '*' ? PREFIX : WILDCARD;
+    }
+
+    void SearchRequest::tokenize(yuca::utils::SmallVector<Token, 32> &tokens) const {
+        const char *data = query.data();
+        const std::size_t length = query.size();
+        std::size_t i = 0;
+
+        while (i < length) {
+            while (i < length && isQuerySpace(data[i])) {
+                i++;
+            }
+            if (i == length) {
+                break;
+            }
+            Token token = {Token::WORD, {static_cast<std::uint32_t>(i), 1}, 0, 0};
+            if (data[i] == '"') {
+                // a phrase goes on until the closing quote or the end of the query
+                std::size_t phrase_end = i + 1;
+                while (phrase_end < length && data[phrase_end] != '"') {
+                    phrase_end++;
+                }
+                token.kind = Token::PHRASE;
+                token.span = {static_cast<std::uint32_t>(i + 1), static_cast<std::uint32_t>(phrase_end - i - 1)};
+                tokens.add(token);
+                i = phrase_end < length ? phrase_end + 1 : length;
+                continue;
+            }
+            std::size_t range_start = (data[i] == '+' || data[i] == '-') && i + 1 < length ? i + 1 : i;
+            if (data[range_start] == '[' || data[range_start] == '{') {
+                // a range goes on until its closing bracket or the end of the query
+                std::size_t range_end = range_start + 1;
+                while (range_end < length && data[range_end] != ']' && data[range_end] != '}') {
+                    range_end++;
+                }
+                range_end = range_end < length ? range_end + 1 : length;
+                token.span.length = static_cast<std::uint32_t>(range_end - i);
+                tokens.add(token);
+                i = range_end;
+                continue;
+            }
+            if (data[i] == '(' || data[i] == ')') {
+                token.kind = data[i] == '(' ? Token::LEFT_PAREN : Token::RIGHT_PAREN;
+                tokens.add(token);
+                i++;
+                continue;
+            }
+            std::size_t token_start = i;
+            while (i < length && !isWordEnd(data[i])) {
+                i++;
+            }
+            token.span.length = static_cast<std::uint32_t>(i - token_start);
+            yuca::utils::StringView text = view(token.span);
+
+            yuca::utils::StringView operator_text = text;
+            if (text.size() > 1 && (text[0] == '+' || text[0] == '-')) {
+                operator_text = text.subView(1, text.size());
+            }
+            if (isComparison(operator_text)) {
+                // ">= 1970" is a single keyword
+                std::size_t value_start = i;
+                while (value_start < length && isQuerySpace(data[value_start])) {
+                    value_start++;
+                }
+                std::size_t value_end = value_start;
+                while (value_end < length && !isWordEnd(data[value_end])) {
+                    value_end++;
+                }
+                if (value_end > value_start && data[value_start] != ':') {
+                    token.span.length = static_cast<std::uint32_t>(value_end - token_start);
+                    i = value_end;
+                }
+            } else if (text == "OR") {
+                token.kind = Token::OR;
+            } else if (text[0] == '@') {
+                // @property=value, anything else starting with '@' is a keyword
+                std::size_t equals = 1;
+                while (equals < text.size() && text[equals] != '=') {
+                    equals++;
+                }
+                if (equals > 1 && equals + 1 < text.size()) {
+                    token.kind = Token::FILTER;
+                }
+            } else if (text.size() > 5 && text.startsWith("NEAR/")) {
+                std::uint32_t distance = 0;
+                std::size_t d = 5;
+                while (d < text.size() && text[d] >= '0' && text[d] <= '9') {
+                    distance = distance * 10 + static_cast<std::uint32_t>(text[d] - '0');
+                    d++;
+                }
+                if (d == text.size() && distance > 0) {
+                    token.kind = Token::NEAR;
+                    token.distance = distance;
+                }
+            } else if (text[0] == ':') {
+                token.kind = Token::GROUP;
+                // :group~N, at least N of the group's optional keywords must match
+                std::size_t tilde = text.size();
+                while (tilde > 1 && text[tilde - 1] >= '0' && text[tilde - 1] <= '9') {
+                    tilde--;
+                }
+                if (tilde > 2 && tilde < text.size() && text[tilde - 1] == '~') {
+                    std::uint32_t min_should_match = 0;
+                    for (std::size_t d = tilde; d < text.size(); d++) {
+                        min_should_match = min_should_match * 10 + static_cast<std::uint32_t>(text[d] - '0');
+                    }
+                    token.span.length = static_cast<std::uint32_t>(tilde - 1);
+                    token.min_should_match = min_should_match;
+                }
+            }
+            tokens.add(token);
+        }
+    }
+
+    void SearchRequest::parse() {
+        yuca::utils::SmallVector<Token, 32> tokens;
+        tokenize(tokens);
+
+        GroupContext implicit_context = {{0, 0}, true, 0};
+        std::vector<std::uint32_t> top_level;
+        std::size_t pos = 0;
+        while (pos < tokens.size()) {
+            std::uint32_t node = parseOr(tokens, pos, implicit_context);
+            if (node != NO_NODE) {
+                top_level.push_back(node);
+            }
+            if (pos < tokens.size()) {
+                // unbalanced ')', skip it
+                pos++;
+            }
+        }
+        if (top_level.size() == 1) {
+            root = top_level[0];
+        } else if (top_level.size() > 1) {
+            root = addNode(QueryNode::AND, top_level);
+        }
+
+        // a clause without +required keywords needs at least one of its optional keywords
+        for (auto &node : nodes) {
+            if (node.type != QueryNode::CLAUSE || node.min_should_match > 0) {
+                continue;
+            }
+            bool has_must = false;
+            bool has_should = false;
+            for (std::uint32_t term_index : node.children) {
+                has_must = has_must || terms[term_index].occur == MUST;
+                has_should = has_should || terms[term_index].occur == SHOULD;
+            }
+            if (!has_must && has_should) {
+                node.min_should_match = 1;
+            }
+        }
+
+        // lay out the keywords that can match group by group, keeping their order within each group
+        for (std::uint32_t g = 0; g < groups.size(); g++) {
+            groups[g].first_keyword = static_cast<std::uint32_t>(keywords.size());
+            for (auto const &term : terms) {
+                if (term.group == g && term.occur != MUST_NOT) {
+                    keywords.add(term.text);
+                    groups[g].keyword_count++;
+                    total_keywords++;
+                }
+            }
+        }
+    }
+
+    std::uint32_t SearchRequest::parseOr(yuca::utils::SmallVector<Token, 32> const &tokens, std::size_t &pos,
+                                         GroupContext const &inherited_group) {
+        std::vector<std::uint32_t> alternatives;
+        while (true) {
+            std::uint32_t node = parseAnd(tokens, pos, inherited_group);
+            if (node != NO_NODE) {
+                alternatives.push_back(node);
+            }
+            if (pos < tokens.size() && tokens[pos].kind == Token::OR) {
+                pos++;
+                continue;
+            }
+            break;
+        }
+        if (alternatives.empty()) {
+            return NO_NODE;
+        }
+        return alternatives.size() == 1 ? alternatives[0] : addNode(QueryNode::OR, alternatives);
+    }
+
+    std::uint32_t SearchRequest::parseAnd(yuca::utils::SmallVector<Token, 32> const &tokens, std::size_t &pos,
+                                          GroupContext const &inherited_group) {
+        GroupContext current_group = inherited_group;
+        std::vector<std::uint32_t> operands;
+
+        while (pos < tokens.size()) {
+            Token const &token = tokens[pos];
+            if (token.kind == Token::OR || token.kind == Token::RIGHT_PAREN) {
+                break;
+            }
+            pos++;
+            if (token.kind == Token::GROUP) {
+                current_group.name = token.span;
+                current_group.implicit = false;
+                current_group.min_should_match = token.min_should_match;
+                continue;
+            }
+            if (token.kind == Token::LEFT_PAREN) {
+                std::uint32_t node = parseOr(tokens, pos, current_group);
+                if (pos < tokens.size() && tokens[pos].kind == Token::RIGHT_PAREN) {
+                    pos++;
+                }
+                if (node != NO_NODE) {
+                    operands.push_back(node);
+                }
+                continue;
+            }
+
+            if (token.kind == Token::NEAR) {
+                // a NEAR without a keyword before it
+                continue;
+            }
+            if (token.kind == Token::FILTER) {
+                yuca::utils::StringView text = view(token.span);
+                std::uint32_t equals = 1;
+                while (text[equals] != '=') {
+                    equals++;
+                }
+                Filter filter = {{token.span.offset + 1, equals - 1},
+                                 {token.span.offset + equals + 1, token.span.length - equals - 1}};
+                filters.push_back(filter);
+                continue;
+            }
+            if (token.kind == Token::PHRASE) {
+                std::vector<Span> words;
+                std::size_t i = token.span.offset;
+                const std::size_t phrase_end = token.span.offset + token.span.length;
+                while (i < phrase_end) {
+                    while (i < phrase_end && isQuerySpace(query[i])) {
+                        i++;
+                    }
+                    std::size_t word_start = i;
+                    while (i < phrase_end && !isQuerySpace(query[i])) {
+                        i++;
+                    }
+                    if (i > word_start) {
+                        words.push_back({static_cast<std::uint32_t>(word_start),
+                                         static_cast<std::uint32_t>(i - word_start)});
+                    }
+                }
+                if (!words.empty()) {
+                    operands.push_back(addProximityNode(QueryNode::PHRASE, words,
+                                                        std::vector<std::uint32_t>(words.size() - 1, 0),
+                                                        groupIndex(current_group)));
+                }
+                continue;
+            }
+            if (pos + 1 < tokens.size() && tokens[pos].kind == Token::NEAR && tokens[pos + 1].kind == Token::WORD) {
+                // keyword NEAR/k keyword [NEAR/k keyword ...]
+                std::vector<Span> words(1, token.span);
+                std::vector<std::uint32_t> distances;
+                while (pos + 1 < tokens.size() && tokens[pos].kind == Token::NEAR &&
+                       tokens[pos + 1].kind == Token::WORD) {
+                    distances.push_back(tokens[pos].distance);
+                    words.push_back(tokens[pos + 1].span);
+                    pos += 2;
+                }
+                for (auto &word : words) {
+                    char prefix = query[word.offset];
+                    if ((prefix == '+' || prefix == '-') && word.length > 1) {
+                        word.offset++;
+                        word.length--;
+                    }
+                }
+                operands.push_back(addProximityNode(QueryNode::NEAR, words, distances, groupIndex(current_group)));
+                continue;
+            }
+
+            QueryTerm term = {token.span, 0, SHOULD, EXACT, 0};
+            char prefix = query[token.span.offset];
+            if (prefix == '+' || prefix == '-') {
+                term.occur = prefix == '+' ? MUST : MUST_NOT;
+                term.text.offset++;
+                term.text.length--;
+            }
+            if (term.text.length == 0) {
+                continue;
+            }
+            term.type = termType(view(term.text), term.max_edits);
+            term.group = groupIndex(current_group);
+
+            // keywords of the same group at the same level share one clause, like they always have
+            std::uint32_t clause = NO_NODE;
+            for (std::uint32_t operand : operands) {
+                if (nodes[operand].type == QueryNode::CLAUSE && nodes[operand].group == term.group) {
+                    clause = operand;
+                    break;
+                }
+            }
+            if (clause == NO_NODE) {
+                clause = addNode(QueryNode::CLAUSE, std::vector<std::uint32_t>());
+                nodes[clause].group = term.group;
+                operands.push_back(clause);
+            }
+            nodes[clause].min_should_match = std::max(nodes[clause].min_should_match,
+                                                      current_group.min_should_match);
+            nodes[clause].children.push_back(static_cast<std::uint32_t>(terms.size()));
+            terms.push_back(term);
+        }
+
+        if (operands.empty()) {
+            return NO_NODE;
+        }
+        return operands.size() == 1 ? operands[0] : addNode(QueryNode::AND, operands);
+    }
+
+    std::uint32_t SearchRequest::groupIndex(GroupContext const &group_context) {
+        // groups only exist once they have a keyword, a group mentioned twice is the same group
+        yuca::utils::StringView group_name = group_context.implicit ?
+                                             yuca::utils::StringView(implicit_group) : view(group_context.name);
+        for (std::uint32_t g = 0; g < groups.size(); g++) {
+            if (getGroup(g) == group_name) {
+                return g;
+            }
+        }
+        GroupSpan group_span = {group_context.name, group_context.implicit, 0, 0};
+        groups.add(group_span);
+        return static_cast<std::uint32_t>(groups.size() - 1);
+    }
+
+    std::uint32_t SearchRequest::addProximityNode(QueryNode::Type type,
+                                                  std::vector<Span> const &words,
+                                                  std::vector<std::uint32_t> const &distances,
+                                                  std::uint32_t group) {
+        std::uint32_t node_index = addNode(type, std::vector<std::uint32_t>());
+        nodes[node_index].group = group;
+        nodes[node_index].distances = distances;
+        for (auto const &word : words) {
+            // positions are kept for keys, not for what prefixes or wildcards expand to
+            QueryTerm term = {word, group, MUST, EXACT, 0};
+            nodes[node_index].children.push_back(static_cast<std::uint32_t>(terms.size()));
+            terms.push_back(term);
+        }
+        return node_index;
+    }
+
+    std::uint32_t SearchRequest::addNode(QueryNode::Type type, std::vector<std::uint32_t> children) {
+        QueryNode node;
+        node.type = type;
+        node.group = 0;
+        node.min_should_match = 0;
+        node.children = std::move(children);
+        nodes.push_back(std::move(node));
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+
+    yuca::utils::StringView SearchRequest::view(Span const &span) const noexcept {
+        return yuca::utils::StringView(query.data() + span.offset, span.length);
+    }
+
+    std::size_t SearchRequest::getGroupCount() const noexcept {
+        return groups.size();
+    }
+
+    yuca::utils::StringView SearchRequest::getGroup(std::size_t group_index) const noexcept {
+        GroupSpan const &group_span = groups[group_index];
+        return group_span.implicit ? yuca::utils::StringView(implicit_group) : view(group_span.name);
+    }
+
+    std::size_t SearchRequest::getKeywordCount(std::size_t group_index) const noexcept {
+        return groups[group_index].keyword_count;
+    }
+
+    yuca::utils::StringView SearchRequest::getKeyword(std::size_t group_index, std::size_t keyword_index) const noexcept {
+        return view(keywords[groups[group_index].first_keyword + keyword_index]);
+    }
+
+    bool SearchRequest::hasQuery() const noexcept {
+        return root != NO_NODE || !filters.empty();
+    }
+
+    std::uint32_t SearchRequest::getRoot() const noexcept {
+        return root;
+    }
+
+    std::size_t SearchRequest::getFilterCount() const noexcept {
+        return filters.size();
+    }
+
+    yuca::utils::StringView SearchRequest::getFilterProperty(std::size_t filter_index) const noexcept {
+        return view(filters[filter_index].property);
+    }
+
+    yuca::utils::StringView SearchRequest::getFilterValue(std::size_t filter_index) const noexcept {
+        return view(filters[filter_index].value);
+    }
+
+    SearchRequest::QueryNode const &SearchRequest::getNode(std::uint32_t node_index) const noexcept {
+        return nodes[node_index];
+    }
+
+    std::size_t SearchRequest::getNodeCount() const noexcept {
+        return nodes.size();
+    }
+
+    std::size_t SearchRequest::getTermCount() const noexcept {
+        return terms.size();
+    }
+
+    SearchRequest::QueryTerm const &SearchRequest::getTerm(std::uint32_t term_index) const noexcept {
+        return terms[term_index];
+    }
+
+    yuca::utils::StringView SearchRequest::getTermString(std::uint32_t term_index) const noexcept {
+        return view(terms[term_index].text);
+    }
+
+    yuca::utils::StringView SearchRequest::stripOperator(yuca::utils::StringView keyword, TermType type) noexcept {
+        if (type == PREFIX) {
+            return keyword.subView(0, keyword.size() - 1);
+        }
+        if (type == FUZZY) {
+            std::size_t tilde = keyword.size();
+            while (tilde > 0 && keyword[tilde - 1] != '~') {
+                tilde--;
+            }
+            return keyword.subView(0, tilde - 1);
+        }
+        return keyword;
+    }
+
+    bool SearchRequest::parseRange(yuca::utils::StringView text, Range &range) noexcept {
+        range = {yuca::utils::StringView(), yuca::utils::StringView(), true, true};
+        if (text.isEmpty()) {
+            return false;
+        }
+        char first = text[0];
+        if (first == '<' || first == '>') {
+            bool inclusive = text.size() > 1 && text[1] == '=';
+            yuca::utils::StringView value = trim(text.subView(inclusive ? 2 : 1, text.size()));
+            if (value.isEmpty()) {
+                return false;
+            }
+            if (first == '>') {
+                range.lower = value;
+                range.include_lower = inclusive;
+            } else {
+                range.upper = value;
+                range.include_upper = inclusive;
+            }
+            return true;
+        }
+        if (first != '[' && first != '{') {
+            return false;
+        }
+        range.include_lower = first == '[';
+        std::size_t end = text.size();
+        if (text[end - 1] == ']' || text[end - 1] == '}') {
+            range.include_upper = text[end - 1] == ']';
+            end--;
+        }
+        yuca::utils::StringView inner = text.subView(1, end - 1);
+        for (std::size_t i = 0; i + 4 <= inner.size(); i++) {
+            if (inner.subView(i, 4) == " TO ") {
+                range.lower = rangeBound(inner.subView(0, i));
+                range.upper = rangeBound(inner.subView(i + 4, inner.size()));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    SortBy SortBy::parse(std::string const &sort_by) {
+        SortBy sort_by_out = {"", false};
+        yuca::utils::StringView text = trim(sort_by);
+        std::size_t property_end = 0;
+        while (property_end < text.size() && !isQuerySpace(text[property_end])) {
+            property_end++;
+        }
+        sort_by_out.property = text.subView(0, property_end).toString();
+        yuca::utils::StringView order = trim(text.subView(property_end, text.size()));
+        sort_by_out.descending = order == "desc" || order == "DESC";
+        return sort_by_out;
+    }
+
+    yuca::utils::List<std::string> SearchRequest::getGroups() const {
+        yuca::utils::List<std::string> result;
+        for (std::size_t g = 0; g < getGroupCount(); g++) {
+            result.add(getGroup(g).toString());
+        }
+        return result;
+    }
+
+    yuca::utils::List<std::string> SearchRequest::getKeywords(std::string const &group) const {
+        yuca::utils::List<std::string> result;
+        for (std::size_t g = 0; g < getGroupCount(); g++) {
+            if (getGroup(g) == group) {
+                for (std::size_t k = 0; k < getKeywordCount(g); k++) {
+                    result.add(getKeyword(g, k).toString());
+                }
+                break;
+            }
+        }
+        return result;
+    }
+
+    bool SearchRequest::operator==(const SearchRequest &other) const {
+        return this->query == other.query && this->id == other.id && this->total_keywords == other.total_keywords;
+    }
+
+    const std::uint32_t PreparedQuery::NO_PARAMETER;
+
+    PreparedQuery::PreparedQuery(std::string const &query_template, std::string const &implicit_group) :
+    request(std::make_shared<SearchRequest>(query_template, implicit_group)),
+    parameter_count(0) {
+        for (std::size_t g = 0; g < request->getGroupCount(); g++) {
+            group_ids.push_back(StringKey::groupId(request->getGroup(g)));
+        }
+        key_ids.reserve(request->getTermCount());
+        term_parameters.reserve(request->getTermCount());
+        for (std::uint32_t t = 0; t < request->getTermCount(); t++) {
+            yuca::utils::StringView keyword = request->getTermString(t);
+            key_ids.push_back(StringKey::keyId(group_ids[request->getTerm(t).group], keyword));
+            if (keyword == "?") {
+                term_parameters.push_back(static_cast<std::uint32_t>(parameter_count++));
+            } else {
+                term_parameters.push_back(NO_PARAMETER);
+            }
+        }
+    }
+
+    std::size_t PreparedQuery::getParameterCount() const noexcept {
+        return parameter_count;
+    }
+
+    SearchRequest const &PreparedQuery::getSearchRequest() const noexcept {
+        return *request;
+    }
+
+    std::shared_ptr<SearchRequest> const &PreparedQuery::getSearchRequestPtr() const noexcept {
+        return request;
+    }
+
+    long PreparedQuery::getGroupId(std::uint32_t group_index) const noexcept {
+        return group_ids[group_index];
+    }
+
+    bool PreparedQuery::isBound(std::uint32_t term_index,
+                                yuca::utils::List<std::string> const &parameters) const noexcept {
+        return term_parameters[term_index] != NO_PARAMETER && term_parameters[term_index] < parameters.size();
+    }
+
+    yuca::utils::StringView PreparedQuery::getKeyword(std::uint32_t term_index,
+                                                      yuca::utils::List<std::string> const &parameters) const noexcept {
+        if (isBound(term_index, parameters)) {
+            return parameters.getStdVector()[term_parameters[term_index]];
+        }
+        return request->getTermString(term_index);
+    }
+
+    SearchRequest::TermType PreparedQuery::getTermType(std::uint32_t term_index,
+                                                       yuca::utils::List<std::string> const &parameters) const noexcept {
+        return isBound(term_index, parameters) ? SearchRequest::EXACT : request->getTerm(term_index).type;
+    }
+
+    long PreparedQuery::getKeyId(std::uint32_t term_index,
+                                 yuca::utils::List<std::string> const &parameters) const noexcept {
+        if (isBound(term_index, parameters)) {
+            return StringKey::keyId(group_ids[request->getTerm(term_index).group],
+                                    parameters.getStdVector()[term_parameters[term_index]]);
+        }
+        return key_ids[term_index];
+    }
+
+    std::string PreparedQuery::bind(yuca::utils::List<std::string> const &parameters) const {
+        std::string bound_query;
+        std::size_t copied = 0;
+        for (std::uint32_t t = 0; t < request->getTermCount(); t++) {
+            if (!isBound(t, parameters)) {
+                continue;
+            }
+            yuca::utils::StringView placeholder = request->getTermString(t);
+            std::size_t offset = static_cast<std::size_t>(placeholder.data() - request->query.data());
+            bound_query.append(request->query, copied, offset - copied);
+            bound_query.append(parameters.getStdVector()[term_parameters[t]]);
+            copied = offset + placeholder.size();
+        }
+        bound_query.append(request->query, copied, std::string::npos);
+        return bound_query;
+    }
+}
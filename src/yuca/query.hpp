@@ -0,0 +1,347 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Created by gubatron on 11/16/16.
+//
+
+#ifndef YUCA_QUERY_HPP
+#define YUCA_QUERY_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <memory>
+#include "utils.hpp"
+
+namespace yuca {
+    /**
+     * Given a search query it creates a structure that maps
+     * possible search groups to specified OffsetKeywords
+     *
+     * The query is tokenized in a single pass, groups and keywords are kept as
+     * offsets into the query string, no per token strings are created.
+     *
+     * Query syntax:
+     *  - keywords under the same :group are ORed, different :groups are ANDed
+     *    "love hate :extension mp4 avi"
+     *  - "+keyword" must match, "-keyword" must not match
+     *    ":title +love -hate"
+     *  - "OR" (uppercase) between group clauses, after an OR keywords go back to the implicit group
+     *    ":author hoover OR :title communism"
+     *  - parentheses, they start out under the group that was current when they were opened
+     *    "(:author hoover :year 1974) OR (:author leon :year 2018)"
+     *  - ":group~N" at least N of the group's optional keywords must match
+     *    ":title~2 love is all you need"
+     *  - "prefix*" matches the keywords that start with prefix, '*' and '?' anywhere else make a wildcard
+     *    ":title comm* :extension mp?"
+     *  - "keyword~N" matches the keywords within N (1 or 2, 2 if omitted) edits of keyword
+     *    ":title comunism~1"
+     *  - "\"a phrase\"" its keywords must all match, one right after the other, see Indexer::keepPositions()
+     *    ":title \"masters of deceit\""
+     *  - "keyword NEAR/k keyword" both keywords must match, at most k positions apart
+     *    ":title hoover NEAR/3 deceit"
+     *  - "[a TO b]" the values of the group's numeric property between a and b, see Indexer::addNumericIndex(),
+     *    or else the group's keywords between a and b in string order. "{a TO b}" leaves a and b out,
+     *    "*" leaves a side open. ">= a", "> a", "<= b" and "< b" are one sided ranges
+     *    ":file_size [1000000 TO 5000000] :year >= 1970 :date [2018-01-01 TO 2018-06-30]"
+     *  - "@property=value" the documents whose bool property is true/false, or whose byte property has the value,
+     *    given as a number or a single character. Filters apply to the whole query wherever they are written
+     *    ":title communism @top_secret=false @rating=5"
+     */
+    struct SearchRequest {
+        /** How a keyword takes part in its group clause */
+        enum Occur {
+            SHOULD,
+            MUST,
+            MUST_NOT
+        };
+
+        /** A token of the query string, offsets keep it valid when the request is copied */
+        struct Span {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+        /** How a keyword is matched against the group's keys */
+        enum TermType {
+            EXACT,
+            PREFIX, // "comm*", the text keeps its trailing '*'
+            WILDCARD, // "c?mm*n*"
+            FUZZY, // "comunism~1", the text keeps its "~N"
+            RANGE // "[1970 TO 1980]", ">= 1970", see parseRange()
+        };
+
+        /** The bounds of a RANGE term, an empty bound leaves that side open */
+        struct Range {
+            yuca::utils::StringView lower;
+            yuca::utils::StringView upper;
+            bool include_lower;
+            bool include_upper;
+        };
+
+        static const std::uint32_t MAX_FUZZY_EDITS = 2;
+
+        struct QueryTerm {
+            Span text; // without its +/- prefix
+            std::uint32_t group; // index of the term's group, see getGroup()
+            Occur occur;
+            TermType type;
+            std::uint32_t max_edits; // FUZZY only
+        };
+
+        /**
+         * A node of the query tree. A CLAUSE holds the terms of one group, AND/OR combine other nodes.
+         * A CLAUSE matches a document when all its MUST terms, none of its MUST_NOT terms and at least
+         * min_should_match of its SHOULD terms match.
+         * PHRASE and NEAR hold MUST terms of one group that must also be close to each other in the document.
+         */
+        struct QueryNode {
+            enum Type {
+                CLAUSE,
+                AND,
+                OR,
+                PHRASE,
+                NEAR
+            };
+
+            Type type;
+            std::uint32_t group; // CLAUSE, PHRASE and NEAR
+            std::uint32_t min_should_match; // CLAUSE only
+            std::vector<std::uint32_t> children; // node indices for AND/OR, term indices for the others
+            // PHRASE and NEAR, how far the term at i + 1 can be from the one at i, 0 means right after it
+            std::vector<std::uint32_t> distances;
+        };
+
+        static const std::uint32_t NO_NODE = 0xffffffff;
+
+        SearchRequest(const std::string &query_str, const std::string &an_implicit_group) :
+        query(query_str),
+        id(rand()),
+        total_keywords(0),
+        implicit_group(an_implicit_group),
+        root(NO_NODE) {
+            parse();
+        }
+
+        /** Returns a copy of the groups in the order they first appear in the query */
+        yuca::utils::List<std::string> getGroups() const;
+
+        /** Returns a copy of the keywords under the given group, excluded (-keyword) ones are left out */
+        yuca::utils::List<std::string> getKeywords(std::string const &group) const;
+
+        std::size_t getGroupCount() const noexcept;
+
+        yuca::utils::StringView getGroup(std::size_t group_index) const noexcept;
+
+        /** Number of keywords under the group, excluded (-keyword) ones are left out */
+        std::size_t getKeywordCount(std::size_t group_index) const noexcept;
+
+        yuca::utils::StringView getKeyword(std::size_t group_index, std::size_t keyword_index) const noexcept;
+
+        /** Is there anything to search for? A query of only filters has no root */
+        bool hasQuery() const noexcept;
+
+        /** The root of the query tree, NO_NODE if the query has no keywords */
+        std::uint32_t getRoot() const noexcept;
+
+        /** Number of "@property=value" filters, see getFilterProperty() and getFilterValue() */
+        std::size_t getFilterCount() const noexcept;
+
+        yuca::utils::StringView getFilterProperty(std::size_t filter_index) const noexcept;
+
+        yuca::utils::StringView getFilterValue(std::size_t filter_index) const noexcept;
+
+        QueryNode const &getNode(std::uint32_t node_index) const noexcept;
+
+        std::size_t getNodeCount() const noexcept;
+
+        std::size_t getTermCount() const noexcept;
+
+        QueryTerm const &getTerm(std::uint32_t term_index) const noexcept;
+
+        yuca::utils::StringView getTermString(std::uint32_t term_index) const noexcept;
+
+        /** The keyword without its matching operator, "comm*" -> "comm", "comunism~1" -> "comunism" */
+        static yuca::utils::StringView stripOperator(yuca::utils::StringView keyword, TermType type) noexcept;
+
+        /**
+         * Splits the text of a RANGE term into its bounds, "[1970 TO *]" -> lower "1970", open upper.
+         * Returns false if the text isn't a range. The bounds point into the text.
+         */
+        static bool parseRange(yuca::utils::StringView text, Range &range) noexcept;
+
+        bool operator==(const SearchRequest &other) const;
+
+        const std::string query;
+
+        const long id;
+
+        // keywords that can match, excluded (-keyword) ones are not counted
+        long total_keywords;
+
+    private:
+        struct Token {
+            enum Kind {
+                WORD,
+                GROUP,
+                LEFT_PAREN,
+                RIGHT_PAREN,
+                OR,
+                PHRASE, // the span is what's between the quotes
+                NEAR,
+                FILTER // "@property=value"
+            };
+
+            Kind kind;
+            Span span;
+            std::uint32_t min_should_match; // GROUP only
+            std::uint32_t distance; // NEAR only
+        };
+
+        /** A group and the range of its keywords in the keywords vector */
+        struct GroupSpan {
+            Span name;
+            bool implicit;
+            std::uint32_t first_keyword;
+            std::uint32_t keyword_count;
+        };
+
+        /** A "@property=value" filter */
+        struct Filter {
+            Span property;
+            Span value;
+        };
+
+        /** The group a parser level is currently adding keywords to */
+        struct GroupContext {
+            Span name;
+            bool implicit;
+            std::uint32_t min_should_match;
+        };
+
+        void parse();
+
+        /** @param max_edits set for FUZZY keywords */
+        static TermType termType(yuca::utils::StringView keyword, std::uint32_t &max_edits) noexcept;
+
+        void tokenize(yuca::utils::SmallVector<Token, 32> &tokens) const;
+
+        std::uint32_t parseOr(yuca::utils::SmallVector<Token, 32> const &tokens, std::size_t &pos,
+                              GroupContext const &inherited_group);
+
+        std::uint32_t parseAnd(yuca::utils::SmallVector<Token, 32> const &tokens, std::size_t &pos,
+                               GroupContext const &inherited_group);
+
+        std::uint32_t groupIndex(GroupContext const &group_context);
+
+        /** Adds a PHRASE or NEAR node and its terms */
+        std::uint32_t addProximityNode(QueryNode::Type type,
+                                       std::vector<Span> const &words,
+                                       std::vector<std::uint32_t> const &distances,
+                                       std::uint32_t group);
+
+        std::uint32_t addNode(QueryNode::Type type, std::vector<std::uint32_t> children);
+
+        yuca::utils::StringView view(Span const &span) const noexcept;
+
+        const std::string implicit_group;
+
+        yuca::utils::SmallVector<GroupSpan, 4> groups;
+
+        // keywords that can match, sorted by group, each group's keywords are contiguous
+        yuca::utils::SmallVector<Span, 16> keywords;
+
+        std::vector<QueryTerm> terms;
+
+        std::vector<QueryNode> nodes;
+
+        // ANDed with the whole query tree
+        std::vector<Filter> filters;
+
+        std::uint32_t root;
+    };
+
+    /** How search results are ordered by a document property, see Indexer::search(..., opt_sort_by) */
+    struct SortBy {
+        std::string property; // empty to rank the results by their score
+        bool descending;
+
+        /** "file_size desc", "year asc", "year" is ascending. An empty string ranks by score */
+        static SortBy parse(std::string const &sort_by);
+    };
+
+    /**
+     * A query parsed and hashed once, see Indexer::prepare(), so it can be searched many times.
+     * Keywords written as "?" are parameters, every search binds them in order to the values it is given.
+     * ":title ? :extension mp4" -> search(prepared_query, {"love"}) searches ":title love :extension mp4"
+     */
+    class PreparedQuery {
+    public:
+        PreparedQuery(std::string const &query_template, std::string const &implicit_group);
+
+        std::size_t getParameterCount() const noexcept;
+
+        SearchRequest const &getSearchRequest() const noexcept;
+
+        std::shared_ptr<SearchRequest> const &getSearchRequestPtr() const noexcept;
+
+        long getGroupId(std::uint32_t group_index) const noexcept;
+
+        /** The term's keyword, or the value bound to it if it's a parameter. Unbound parameters stay "?" */
+        yuca::utils::StringView getKeyword(std::uint32_t term_index,
+                                           yuca::utils::List<std::string> const &parameters) const noexcept;
+
+        /** Bound parameters are always EXACT, their values are taken literally */
+        SearchRequest::TermType getTermType(std::uint32_t term_index,
+                                            yuca::utils::List<std::string> const &parameters) const noexcept;
+
+        /** Key id of getKeyword(), pre-hashed unless the term is a bound parameter */
+        long getKeyId(std::uint32_t term_index, yuca::utils::List<std::string> const &parameters) const noexcept;
+
+        /** The query template with its parameters replaced by the given values */
+        std::string bind(yuca::utils::List<std::string> const &parameters) const;
+
+        static const std::uint32_t NO_PARAMETER = 0xffffffff;
+
+    private:
+        bool isBound(std::uint32_t term_index, yuca::utils::List<std::string> const &parameters) const noexcept;
+
+        std::shared_ptr<SearchRequest> request;
+
+        // by group index
+        std::vector<long> group_ids;
+
+        // by term index
+        std::vector<long> key_ids;
+
+        // by term index, the parameter a term binds to or NO_PARAMETER
+        std::vector<std::uint32_t> term_parameters;
+
+        std::size_t parameter_count;
+    };
+}
+
+#endif //YUCA_QUERY_HPP
@@ -0,0 +1,160 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include "session.hpp"
+
+namespace yuca {
+    namespace {
+        inline bool isQuerySpace(char c) noexcept {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+    }
+
+    std::string SearchSession::typeAheadQuery(std::string const &query) {
+        if (query.empty() || isQuerySpace(query.back())) {
+            return query;
+        }
+        std::size_t start = query.size();
+        while (start > 0 && !isQuerySpace(query[start - 1]) && query[start - 1] != '(') {
+            start--;
+        }
+        // keywords of phrases and NEARs are matched exactly
+        if (std::count(query.begin(), query.end(), '"') % 2 != 0) {
+            return query;
+        }
+        std::size_t previous_end = start;
+        while (previous_end > 0 && isQuerySpace(query[previous_end - 1])) {
+            previous_end--;
+        }
+        std::size_t previous_start = previous_end;
+        while (previous_start > 0 && !isQuerySpace(query[previous_start - 1])) {
+            previous_start--;
+        }
+        yuca::utils::StringView previous(query.data() + previous_start, previous_end - previous_start);
+        if (previous.startsWith("NEAR/") || previous.startsWith("<") || previous.startsWith(">") ||
+            previous.startsWith("+<") || previous.startsWith("+>") || previous.startsWith("-<") ||
+            previous.startsWith("->")) {
+            return query;
+        }
+        // ranges are matched by value
+        if (std::count(query.begin(), query.end(), '[') + std::count(query.begin(), query.end(), '{') >
+            std::count(query.begin(), query.end(), ']') + std::count(query.begin(), query.end(), '}')) {
+            return query;
+        }
+        yuca::utils::StringView keyword(query.data() + start, query.size() - start);
+        if (keyword.startsWith("+")) {
+            keyword = keyword.subView(1, keyword.size());
+        }
+        if (keyword.isEmpty() || keyword.startsWith(":") || keyword.startsWith("-") || keyword.startsWith("@") ||
+            keyword == "OR" || keyword.startsWith("NEAR/")) {
+            return query;
+        }
+        for (char c : keyword) {
+            if (c == '*' || c == '?' || c == '~' || c == ')' || c == ']' || c == '}' || c == '<' || c == '>') {
+                return query;
+            }
+        }
+        return query + "*";
+    }
+
+    bool SearchSession::isRefinement(SearchRequest const &previous, SearchRequest const &current) {
+        if (previous.getRoot() != current.getRoot() ||
+            previous.getNodeCount() != current.getNodeCount() ||
+            previous.getTermCount() != current.getTermCount() ||
+            previous.getGroupCount() != current.getGroupCount()) {
+            return false;
+        }
+        for (std::size_t g = 0; g < current.getGroupCount(); g++) {
+            if (previous.getGroup(g) != current.getGroup(g)) {
+                return false;
+            }
+        }
+        // the previous matches passed the previous filters
+        if (previous.getFilterCount() != current.getFilterCount()) {
+            return false;
+        }
+        for (std::size_t f = 0; f < current.getFilterCount(); f++) {
+            if (previous.getFilterProperty(f) != current.getFilterProperty(f) ||
+                previous.getFilterValue(f) != current.getFilterValue(f)) {
+                return false;
+            }
+        }
+        for (std::uint32_t n = 0; n < current.getNodeCount(); n++) {
+            SearchRequest::QueryNode const &previous_node = previous.getNode(n);
+            SearchRequest::QueryNode const &current_node = current.getNode(n);
+            if (previous_node.type != current_node.type ||
+                previous_node.group != current_node.group ||
+                previous_node.min_should_match != current_node.min_should_match ||
+                previous_node.children != current_node.children ||
+                previous_node.distances != current_node.distances) {
+                return false;
+            }
+        }
+        for (std::uint32_t t = 0; t < current.getTermCount(); t++) {
+            SearchRequest::QueryTerm const &previous_term = previous.getTerm(t);
+            SearchRequest::QueryTerm const &current_term = current.getTerm(t);
+            if (previous_term.group != current_term.group || previous_term.occur != current_term.occur) {
+                return false;
+            }
+            if (previous_term.type == current_term.type &&
+                previous_term.max_edits == current_term.max_edits &&
+                previous.getTermString(t) == current.getTermString(t)) {
+                continue;
+            }
+            // narrowing an excluded keyword lets more documents through
+            if (current_term.occur == SearchRequest::MUST_NOT ||
+                previous_term.type != SearchRequest::PREFIX ||
+                (current_term.type != SearchRequest::PREFIX && current_term.type != SearchRequest::EXACT)) {
+                return false;
+            }
+            yuca::utils::StringView previous_prefix = SearchRequest::stripOperator(previous.getTermString(t),
+                                                                                   SearchRequest::PREFIX);
+            yuca::utils::StringView current_keyword = SearchRequest::stripOperator(current.getTermString(t),
+                                                                                   current_term.type);
+            if (!current_keyword.startsWith(previous_prefix)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void SearchSession::reset() {
+        previous_request.reset();
+        previous_matches.clear();
+        previous_indexer = nullptr;
+        previous_documents_generation = 0;
+        previous_settings_generation = 0;
+        previous_expansions_complete = false;
+    }
+
+    unsigned long SearchSession::getIncrementalSearches() const noexcept {
+        return incremental_searches;
+    }
+
+    unsigned long SearchSession::getFullSearches() const noexcept {
+        return full_searches;
+    }
+}
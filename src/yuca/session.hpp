@@ -0,0 +1,106 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Search-as-you-type sessions.
+//
+// Consecutive keystroke queries mostly narrow the previous one, "masters of dec" becomes "masters of dece".
+// A session remembers the documents its last query matched, when the next query can only match a subset
+// of them they are filtered against the new query instead of evaluating it from its posting lists.
+//
+
+#ifndef YUCA_SESSION_HPP
+#define YUCA_SESSION_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "postings.hpp"
+#include "query.hpp"
+
+namespace yuca {
+    class Indexer;
+
+    /** State kept between the queries of a search-as-you-type session, see Indexer::search(SearchSession &, ...) */
+    class SearchSession {
+    public:
+        SearchSession() :
+        previous_indexer(nullptr),
+        previous_documents_generation(0),
+        previous_settings_generation(0),
+        previous_expansions_complete(false),
+        incremental_searches(0),
+        full_searches(0) {
+        }
+
+        /**
+         * The last keyword of a query that doesn't end in a space is likely still being typed, it's searched
+         * as a prefix. "masters of dec" -> "masters of dec*". Keywords with operators, groups, "OR" and
+         * the keywords of phrases, NEARs and ranges are kept.
+         */
+        static std::string typeAheadQuery(std::string const &query);
+
+        /**
+         * Can the current request only match documents the previous one matched? It has to have the same
+         * query tree, and each of its terms has to be the previous term or, if the term can match
+         * (not -excluded), a longer keyword under the previous prefix, "dec*" -> "dece*" or "deceit".
+         */
+        static bool isRefinement(SearchRequest const &previous, SearchRequest const &current);
+
+        /** Forgets the previous query, the next search is evaluated from scratch */
+        void reset();
+
+        /** Searches that filtered the previous matches */
+        unsigned long getIncrementalSearches() const noexcept;
+
+        /** Searches evaluated from the posting lists */
+        unsigned long getFullSearches() const noexcept;
+
+    private:
+        friend class Indexer;
+
+        std::shared_ptr<SearchRequest> previous_request;
+
+        // sorted ordinals the previous request matched
+        std::vector<DocOrdinal> previous_matches;
+
+        // the matches are only good for the Indexer and documents they came from
+        Indexer const *previous_indexer;
+
+        std::uint64_t previous_documents_generation;
+
+        std::uint64_t previous_settings_generation;
+
+        // false if a prefix keyword had more expansions than the Indexer takes, a longer prefix could then
+        // match keys that were left out
+        bool previous_expansions_complete;
+
+        unsigned long incremental_searches;
+
+        unsigned long full_searches;
+    };
+}
+
+#endif //YUCA_SESSION_HPP
@@ -0,0 +1,179 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "trigram.hpp"
+
+namespace yuca {
+    std::string const &TrigramIndex::getProperty() const noexcept {
+        return property;
+    }
+
+    void TrigramIndex::putDocument(DocOrdinal ordinal, std::string const &value) {
+        removeDocument(ordinal);
+        if (ordinal >= values.size()) {
+            values.resize(static_cast<std::size_t>(ordinal) + 1);
+        }
+        values[ordinal] = toLowerCase(value);
+        for (auto const &trigram : trigrams(values[ordinal])) {
+            postings[trigram.first].add(ordinal);
+        }
+        documents.set(ordinal);
+        document_count++;
+    }
+
+    void TrigramIndex::removeDocument(DocOrdinal ordinal) {
+        if (!hasDocument(ordinal)) {
+            return;
+        }
+        for (auto const &trigram : trigrams(values[ordinal])) {
+            auto postings_it = postings.find(trigram.first);
+            postings_it->second.remove(ordinal);
+            if (postings_it->second.isEmpty()) {
+                postings.erase(postings_it);
+            }
+        }
+        std::string().swap(values[ordinal]);
+        documents.unset(ordinal);
+        document_count--;
+    }
+
+    bool TrigramIndex::hasDocument(DocOrdinal ordinal) const noexcept {
+        return documents.test(ordinal);
+    }
+
+    std::size_t TrigramIndex::getDocumentCount() const noexcept {
+        return document_count;
+    }
+
+    std::size_t TrigramIndex::getTrigramCount() const noexcept {
+        return postings.size();
+    }
+
+    std::vector<DocOrdinal> TrigramIndex::findContaining(yuca::utils::StringView substring) const {
+        std::string needle = toLowerCase(substring);
+        std::vector<DocOrdinal> candidates;
+        if (needle.size() < 3) {
+            documents.toOrdinals(candidates);
+        } else {
+            std::vector<OrdinalRange> lists;
+            for (auto const &trigram : trigrams(needle)) {
+                auto postings_it = postings.find(trigram.first);
+                if (postings_it == postings.end()) {
+                    return candidates;
+                }
+                lists.push_back(postings_it->second.range());
+            }
+            candidates = postings::intersectAll(std::move(lists));
+            if (needle.size() == 3) {
+                return candidates;
+            }
+        }
+        // a value with all the trigrams can still have them in another order, "abcab" for "cabc"
+        std::size_t kept = 0;
+        for (DocOrdinal candidate : candidates) {
+            if (values[candidate].find(needle) != std::string::npos) {
+                candidates[kept++] = candidate;
+            }
+        }
+        candidates.resize(kept);
+        return candidates;
+    }
+
+    void TrigramIndex::keepPossiblyWithin(yuca::utils::StringView text,
+                                          std::size_t max_edits,
+                                          std::vector<DocOrdinal> &candidates) const {
+        std::string lower_case_text = toLowerCase(text);
+        // windows of the text that must still be found in a value within max_edits of it
+        std::size_t windows = lower_case_text.size() < 3 ? 0 : lower_case_text.size() - 2;
+        std::size_t required = windows > 3 * max_edits ? windows - 3 * max_edits : 0;
+        std::vector<std::pair<PostingCursor, std::uint32_t>> cursors;
+        if (required > 0) {
+            for (auto const &trigram : trigrams(lower_case_text)) {
+                auto postings_it = postings.find(trigram.first);
+                if (postings_it != postings.end()) {
+                    cursors.emplace_back(PostingCursor(postings_it->second.range()), trigram.second);
+                }
+            }
+        }
+        std::size_t kept = 0;
+        for (DocOrdinal candidate : candidates) {
+            if (!hasDocument(candidate)) {
+                continue;
+            }
+            std::size_t length = values[candidate].size();
+            std::size_t length_difference = length > lower_case_text.size() ? length - lower_case_text.size()
+                                                                             : lower_case_text.size() - length;
+            if (length_difference > max_edits) {
+                continue;
+            }
+            std::size_t found = 0;
+            for (auto &cursor : cursors) {
+                if (cursor.first.advance(candidate) && cursor.first.current() == candidate) {
+                    found += cursor.second;
+                }
+            }
+            if (found >= required) {
+                candidates[kept++] = candidate;
+            }
+        }
+        candidates.resize(kept);
+    }
+
+    void TrigramIndex::clear() {
+        postings.clear();
+        values.clear();
+        documents.clear();
+        document_count = 0;
+    }
+
+    std::string TrigramIndex::toLowerCase(yuca::utils::StringView text) {
+        std::string lower_case_text(text.data(), text.size());
+        for (char &c : lower_case_text) {
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+        return lower_case_text;
+    }
+
+    std::vector<std::pair<TrigramIndex::Trigram, std::uint32_t>>
+    TrigramIndex::trigrams(std::string const &lower_case_text) {
+        std::vector<Trigram> windows;
+        for (std::size_t i = 0; i + 3 <= lower_case_text.size(); i++) {
+            windows.push_back((Trigram(static_cast<unsigned char>(lower_case_text[i])) << 16) |
+                              (Trigram(static_cast<unsigned char>(lower_case_text[i + 1])) << 8) |
+                              Trigram(static_cast<unsigned char>(lower_case_text[i + 2])));
+        }
+        std::sort(windows.begin(), windows.end());
+        std::vector<std::pair<Trigram, std::uint32_t>> counted;
+        for (Trigram window : windows) {
+            if (counted.empty() || counted.back().first != window) {
+                counted.emplace_back(window, 0);
+            }
+            counted.back().second++;
+        }
+        return counted;
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016-2018 Angel Leon, Alden Torres
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Character trigram index over a string property of the indexed documents.
+//
+// Every value is lower cased (ASCII) and cut into its overlapping 3 character windows,
+// "Deceit" -> "dec", "ece", "cei", "eit". A value containing a substring has all of the substring's
+// trigrams, so intersecting their postings gives the candidates, which are then verified.
+// Trigrams also bound the edit distance between two strings, each edit touches at most 3 of them,
+// which makes them a cheap filter before any Levenshtein computation.
+//
+
+#ifndef YUCA_TRIGRAM_HPP
+#define YUCA_TRIGRAM_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "postings.hpp"
+#include "utils.hpp"
+
+namespace yuca {
+    /** Trigram postings of one string property, by document ordinal */
+    class TrigramIndex {
+    public:
+        explicit TrigramIndex(std::string const &a_property) : property(a_property), document_count(0) {
+        }
+
+        std::string const &getProperty() const noexcept;
+
+        /** Indexes the document's value of the property, replacing the one it had */
+        void putDocument(DocOrdinal ordinal, std::string const &value);
+
+        void removeDocument(DocOrdinal ordinal);
+
+        bool hasDocument(DocOrdinal ordinal) const noexcept;
+
+        /** Number of documents with a value */
+        std::size_t getDocumentCount() const noexcept;
+
+        /** Number of distinct trigrams */
+        std::size_t getTrigramCount() const noexcept;
+
+        /**
+         * Ordinals, in increasing order, of the documents whose value contains the substring, ignoring ASCII case.
+         * Substrings shorter than a trigram can't be looked up, every value gets checked for them.
+         */
+        std::vector<DocOrdinal> findContaining(yuca::utils::StringView substring) const;
+
+        /**
+         * Drops the candidates whose value is certainly more than max_edits (Levenshtein distance) away from
+         * the text, ignoring ASCII case. Candidates must be sorted, the ones kept still need to be verified.
+         * A value within max_edits of the text has all but 3 * max_edits of the text's trigram windows and
+         * a length within max_edits of it.
+         */
+        void keepPossiblyWithin(yuca::utils::StringView text,
+                                std::size_t max_edits,
+                                std::vector<DocOrdinal> &candidates) const;
+
+        void clear();
+
+        static std::string toLowerCase(yuca::utils::StringView text);
+
+    private:
+        typedef std::uint32_t Trigram;
+
+        /** The distinct trigrams of a lower cased text, sorted, with how many windows have each one */
+        static std::vector<std::pair<Trigram, std::uint32_t>> trigrams(std::string const &lower_case_text);
+
+        std::string property;
+
+        std::unordered_map<Trigram, PostingList> postings;
+
+        // lower cased values by ordinal, what candidates are verified against
+        std::vector<std::string> values;
+
+        // ordinals that have a value, values can be empty
+        DocBitmap documents;
+
+        std::size_t document_count;
+    };
+}
+
+#endif //YUCA_TRIGRAM_HPP
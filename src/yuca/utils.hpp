@@ -39,6 +39,11 @@
 #include <numeric>
 #include <chrono>
 #include <algorithm>
+#include <utility>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
 
 namespace yuca {
     namespace utils {
@@ -101,10 +106,19 @@ namespace yuca {
                 return s;
             }
 
-            std::set<T> &getStdSet() noexcept {
+            std::set<T> &getStdSet() & noexcept {
                 return s;
             }
 
+            std::set<T> const &getStdSet() const & noexcept {
+                return s;
+            }
+
+            /** On a temporary Set we hand over the std::set, so that range-for loops over it don't dangle */
+            std::set<T> getStdSet() && noexcept {
+                return std::move(s);
+            }
+
             unsigned long size() const noexcept {
                 return s.size();
             }
@@ -251,10 +265,19 @@ namespace yuca {
                 return v;
             }
 
-            std::vector<T> &getStdVector() noexcept {
+            std::vector<T> &getStdVector() & noexcept {
                 return v;
             }
 
+            std::vector<T> const &getStdVector() const & noexcept {
+                return v;
+            }
+
+            /** On a temporary List we hand over the std::vector, so that range-for loops over it don't dangle */
+            std::vector<T> getStdVector() && noexcept {
+                return std::move(v);
+            }
+
             friend std::ostream &operator<<(std::ostream &output_stream, List<T> list) {
                 output_stream << "[";
                 auto it = list.v.begin();
@@ -366,10 +389,19 @@ namespace yuca {
                 return m;
             }
 
-            std::map<K, V> &getStdMap() noexcept {
+            std::map<K, V> &getStdMap() & noexcept {
+                return m;
+            }
+
+            std::map<K, V> const &getStdMap() const & noexcept {
                 return m;
             }
 
+            /** On a temporary Map we hand over the std::map, so that range-for loops over it don't dangle */
+            std::map<K, V> getStdMap() && noexcept {
+                return std::move(m);
+            }
+
             bool operator==(const Map<K, V> &other) const {
                 return this == &other;
             }
@@ -393,6 +425,188 @@ namespace yuca {
             V default_empty_value;
         };
 
+        /**
+         * A vector that keeps its first N elements inline and only goes to the heap when it grows past them.
+         * Restricted to trivially copyable element types, e.g. offsets, ids, small PODs.
+         */
+        template<class T, std::size_t N>
+        class SmallVector {
+            static_assert(std::is_trivially_copyable<T>::value, "SmallVector only holds trivially copyable types");
+        public:
+            SmallVector() noexcept : inline_items(), count(0), on_heap(false) {
+            }
+
+            void add(T const &t) {
+                if (!on_heap && count == N) {
+                    heap_items.assign(inline_items, inline_items + N);
+                    on_heap = true;
+                }
+                if (on_heap) {
+                    heap_items.push_back(t);
+                } else {
+                    inline_items[count] = t;
+                }
+                count++;
+            }
+
+            T &operator[](std::size_t index) noexcept {
+                return data()[index];
+            }
+
+            T const &operator[](std::size_t index) const noexcept {
+                return data()[index];
+            }
+
+            T *data() noexcept {
+                return on_heap ? heap_items.data() : inline_items;
+            }
+
+            T const *data() const noexcept {
+                return on_heap ? heap_items.data() : inline_items;
+            }
+
+            T *begin() noexcept {
+                return data();
+            }
+
+            T *end() noexcept {
+                return data() + count;
+            }
+
+            T const *begin() const noexcept {
+                return data();
+            }
+
+            T const *end() const noexcept {
+                return data() + count;
+            }
+
+            /** Inserts t before the element at index, index can be size() */
+            void insert(std::size_t index, T const &t) {
+                add(t);
+                T *items = data();
+                std::rotate(items + index, items + count - 1, items + count);
+            }
+
+            void removeAt(std::size_t index) noexcept {
+                T *items = data();
+                std::copy(items + index + 1, items + count, items + index);
+                if (on_heap) {
+                    heap_items.pop_back();
+                }
+                count--;
+            }
+
+            std::size_t size() const noexcept {
+                return count;
+            }
+
+            bool isEmpty() const noexcept {
+                return count == 0;
+            }
+
+            void clear() noexcept {
+                heap_items.clear();
+                on_heap = false;
+                count = 0;
+            }
+
+        private:
+            T inline_items[N];
+            std::vector<T> heap_items;
+            std::size_t count;
+            bool on_heap;
+        };
+
+        /**
+         * A non-owning, read-only view over a sequence of chars, like C++17's std::string_view.
+         * The viewed buffer must outlive the view.
+         */
+        class StringView {
+        public:
+            StringView() noexcept : ptr(nullptr), len(0) {
+            }
+
+            StringView(const char *c_str) noexcept : ptr(c_str), len(c_str == nullptr ? 0 : std::strlen(c_str)) {
+            }
+
+            StringView(const char *str, std::size_t length) noexcept : ptr(str), len(length) {
+            }
+
+            StringView(std::string const &str) noexcept : ptr(str.data()), len(str.size()) {
+            }
+
+            const char *data() const noexcept {
+                return ptr;
+            }
+
+            std::size_t size() const noexcept {
+                return len;
+            }
+
+            bool isEmpty() const noexcept {
+                return len == 0;
+            }
+
+            char operator[](std::size_t index) const noexcept {
+                return ptr[index];
+            }
+
+            const char *begin() const noexcept {
+                return ptr;
+            }
+
+            const char *end() const noexcept {
+                return ptr + len;
+            }
+
+            /** View of at most length chars starting at start, clamped to the end of this view */
+            StringView subView(std::size_t start, std::size_t length) const noexcept {
+                if (start > len) {
+                    start = len;
+                }
+                return StringView(ptr + start, std::min(length, len - start));
+            }
+
+            bool startsWith(StringView prefix) const noexcept {
+                return prefix.len <= len && (prefix.len == 0 || std::memcmp(ptr, prefix.ptr, prefix.len) == 0);
+            }
+
+            int compare(StringView other) const noexcept {
+                std::size_t common = std::min(len, other.len);
+                int r = common == 0 ? 0 : std::memcmp(ptr, other.ptr, common);
+                if (r != 0) {
+                    return r;
+                }
+                return len < other.len ? -1 : (len > other.len ? 1 : 0);
+            }
+
+            std::string toString() const {
+                return std::string(ptr, len);
+            }
+
+            bool operator==(StringView other) const noexcept {
+                return len == other.len && compare(other) == 0;
+            }
+
+            bool operator!=(StringView other) const noexcept {
+                return !(*this == other);
+            }
+
+            bool operator<(StringView other) const noexcept {
+                return compare(other) < 0;
+            }
+
+            friend std::ostream &operator<<(std::ostream &output_stream, StringView view) {
+                output_stream.write(view.ptr, static_cast<std::streamsize>(view.len));
+                return output_stream;
+            }
+
+        private:
+            const char *ptr;
+            std::size_t len;
+        };
+
         /////////////////////////////////////////////////
 
         inline std::size_t maxRand(std::size_t maxInclusive) noexcept {
@@ -456,6 +670,34 @@ namespace yuca {
             delete[] column;
             return result;
         }
+
+        /** Does the text match the pattern? '*' matches any run of characters, '?' any single character */
+        inline bool wildcardMatch(StringView pattern, StringView text) noexcept {
+            std::size_t p = 0;
+            std::size_t t = 0;
+            std::size_t star = pattern.size();
+            std::size_t star_text = 0;
+            while (t < text.size()) {
+                if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+                    p++;
+                    t++;
+                } else if (p < pattern.size() && pattern[p] == '*') {
+                    // remember the star, first try matching it against nothing
+                    star = p++;
+                    star_text = t;
+                } else if (star != pattern.size()) {
+                    // let the last star swallow one more character
+                    p = star + 1;
+                    t = ++star_text;
+                } else {
+                    return false;
+                }
+            }
+            while (p < pattern.size() && pattern[p] == '*') {
+                p++;
+            }
+            return p == pattern.size();
+        }
     }
 }
 
@@ -18,6 +18,11 @@
 #include "yuca/utils.hpp"
 #include "yuca/key.hpp"
 #include "yuca/document.hpp"
+#include "yuca/query.hpp"
+#include "yuca/completion.hpp"
+#include "yuca/facets.hpp"
+#include "yuca/aggregations.hpp"
+#include "yuca/session.hpp"
 #include "yuca/indexer.hpp"
 %}
 
@@ -138,6 +143,8 @@ namespace yuca {
         explicit Document(const std::string &str_based_id);
         long getId() const;
         void addKey(StringKey const &key);
+        void addKeySequence(std::string const &group, yuca::utils::List<std::string> const &keywords);
+        yuca::utils::List<std::string> getKeySequence(std::string const &group) const;
         bool hasKeys(std::string const &group) const;
 %extend {
         yuca::utils::List<std::string> getGroupsList() const {
@@ -189,14 +196,10 @@ namespace yuca {
 
     struct SearchRequest {
         SearchRequest(const std::string &query_str, const std::string &implicit_group);
-        yuca::utils::List<std::string> getGroups();
-        yuca::utils::List<std::string> getKeywords(std::string &group);
+        yuca::utils::List<std::string> getGroups() const;
+        yuca::utils::List<std::string> getKeywords(std::string const &group) const;
 
         %extend {
-          yuca::utils::List<std::string> getKeywords(const std::string &group) const {
-            return $self->group_keywords_map.get(group);
-          }
-
           bool op_eq(const SearchRequest &right_side) const {
             return $self->query == right_side.query && $self->id == right_side.id && $self->total_keywords == right_side.total_keywords;
           }
@@ -227,23 +230,149 @@ namespace yuca {
         yuca::SPDocument document_sp;
     };
 
+    class PreparedQuery {
+    public:
+        std::size_t getParameterCount() const noexcept;
+        std::string bind(yuca::utils::List<std::string> const &parameters) const;
+    };
+
+    class SearchSession {
+    public:
+        SearchSession();
+        void reset();
+        unsigned long getIncrementalSearches() const noexcept;
+        unsigned long getFullSearches() const noexcept;
+    };
+
+    struct Completion {
+        std::string keyword;
+        std::size_t document_count;
+    };
+
+    struct Suggestion {
+        std::string group;
+        std::string keyword;
+        std::string suggestion;
+        std::uint32_t edits;
+        std::size_t document_count;
+    };
+
+    struct FacetCount {
+        std::string keyword;
+        std::size_t document_count;
+    };
+
+    struct Facet {
+        std::string group;
+        yuca::utils::List<FacetCount> counts;
+    };
+
+    struct HistogramBucket {
+        long lower;
+        std::size_t document_count;
+    };
+
+    struct NumericAggregation {
+        std::string property;
+        std::size_t count;
+        long min;
+        long max;
+        long sum;
+        double average;
+        yuca::utils::List<HistogramBucket> histogram;
+        double percentile(double percent) const;
+    };
+
+    struct SearchOptions {
+        SearchOptions();
+        std::string main_doc_property;
+        unsigned long max_results;
+        std::string sort_by;
+        yuca::utils::List<std::string> facet_groups;
+        std::size_t max_facet_keys;
+        std::string collapse_by;
+        std::size_t max_per_group;
+    };
+
     class Indexer {
     public:
         Indexer(const std::string &an_implicit_group);
         Indexer();
-        void indexDocument(yuca::Document doc);
+        void indexDocument(yuca::Document const &doc);
         yuca::Document getDocument(long doc_id) const noexcept;
         yuca::Document getDocument(std::string const &doc_id) const noexcept;
         bool removeDocument(long doc_id);
         bool removeDocument(std::string const &doc_id);
-        bool removeDocument(yuca::Document doc);
+        bool removeDocument(yuca::Document const &doc);
         void clear();
         yuca::utils::List<SearchResult> search(const std::string &query,
                                                const std::string &opt_main_doc_property_for_query_comparison,
                                                unsigned long opt_max_search_results) const;
+        yuca::utils::List<SearchResult> search(const std::string &query,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results,
+                                               const std::string &opt_sort_by) const;
+        yuca::utils::List<SearchResult> search(const std::string &query,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results,
+                                               const std::string &opt_sort_by,
+                                               const std::string &collapse_by,
+                                               std::size_t max_per_group) const;
         yuca::utils::List<SearchResult> search(const std::string &query);
         yuca::utils::List<SearchResult> search(const std::string &query,
                                                const std::string &opt_main_doc_property_for_query_comparison);
+        PreparedQuery prepare(const std::string &query_template) const;
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results) const;
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters) const;
+        yuca::utils::List<SearchResult> search(const std::string &query,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results,
+                                               yuca::utils::List<std::string> const &facet_groups,
+                                               std::size_t max_facet_keys,
+                                               yuca::utils::List<Facet> &facets) const;
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters,
+                                               SearchOptions const &options,
+                                               yuca::utils::List<Facet> &facets) const;
+        yuca::utils::List<SearchResult> search(PreparedQuery const &prepared_query,
+                                               yuca::utils::List<std::string> const &parameters,
+                                               SearchOptions const &options) const;
+        yuca::utils::List<SearchResult> search(const std::string &query,
+                                               SearchOptions const &options,
+                                               yuca::utils::List<Facet> &facets) const;
+        yuca::utils::List<SearchResult> search(const std::string &query, SearchOptions const &options) const;
+        yuca::utils::List<NumericAggregation> aggregate(const std::string &query,
+                                                        yuca::utils::List<std::string> const &properties,
+                                                        long histogram_interval) const;
+        yuca::utils::List<SearchResult> search(SearchSession &session,
+                                               const std::string &query,
+                                               const std::string &opt_main_doc_property_for_query_comparison,
+                                               unsigned long opt_max_search_results) const;
+        void setResultCacheCapacity(std::size_t capacity);
+        void setMaxTermExpansions(std::size_t max_term_expansions);
+        yuca::utils::List<Completion> complete(std::string const &group,
+                                               std::string const &prefix,
+                                               std::size_t max_completions) const;
+        void keepPositions(std::string const &group);
+        bool keepsPositions(std::string const &group) const;
+        void addSynonym(std::string const &group, std::string const &keyword, std::string const &synonym);
+        void removeSynonyms(std::string const &group, std::string const &keyword);
+        yuca::utils::List<std::string> getSynonyms(std::string const &group, std::string const &keyword) const;
+        yuca::utils::List<Suggestion> suggest(const std::string &query, std::size_t max_suggestions_per_keyword) const;
+        void addNumericIndex(std::string const &property);
+        void removeNumericIndex(std::string const &property);
+        bool hasNumericIndex(std::string const &property) const;
+        void addFacetIndex(std::string const &group);
+        void removeFacetIndex(std::string const &group);
+        bool hasFacetIndex(std::string const &group) const;
+        void addTrigramIndex(std::string const &property);
+        void removeTrigramIndex(std::string const &property);
+        bool hasTrigramIndex(std::string const &property) const;
+        yuca::SPDocumentSet findDocumentsContaining(std::string const &property, std::string const &substring) const;
     };
 }
 
@@ -268,6 +397,18 @@ namespace yuca {
 
 %template(SearchResultList) yuca::utils::List<yuca::SearchResult>;
 
+%template(CompletionList) yuca::utils::List<yuca::Completion>;
+
+%template(SuggestionList) yuca::utils::List<yuca::Suggestion>;
+
+%template(FacetCountList) yuca::utils::List<yuca::FacetCount>;
+
+%template(FacetList) yuca::utils::List<yuca::Facet>;
+
+%template(HistogramBucketList) yuca::utils::List<yuca::HistogramBucket>;
+
+%template(NumericAggregationList) yuca::utils::List<yuca::NumericAggregation>;
+
 %template(StringList) yuca::utils::List<std::string>;
 
 %ignore operator();
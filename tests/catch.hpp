@@ -4732,6 +4732,8 @@ namespace Catch {
         static struct sigaction oldSigActions[];
         static stack_t oldSigStack;
         static char altStackMem[];
+        // SIGSTKSZ is no longer a constant expression on newer glibc (2.34+)
+        static constexpr std::size_t sigStackSize = 32768;
 
         static void handleSignal( int sig );
 
@@ -7321,7 +7323,7 @@ namespace Catch {
         isSet = true;
         stack_t sigStack;
         sigStack.ss_sp = altStackMem;
-        sigStack.ss_size = SIGSTKSZ;
+        sigStack.ss_size = sigStackSize;
         sigStack.ss_flags = 0;
         sigaltstack(&sigStack, &oldSigStack);
         struct sigaction sa = { };
@@ -7352,7 +7354,8 @@ namespace Catch {
     bool FatalConditionHandler::isSet = false;
     struct sigaction FatalConditionHandler::oldSigActions[sizeof(signalDefs)/sizeof(SignalDefs)] = {};
     stack_t FatalConditionHandler::oldSigStack = {};
-    char FatalConditionHandler::altStackMem[SIGSTKSZ] = {};
+    constexpr std::size_t FatalConditionHandler::sigStackSize;
+    char FatalConditionHandler::altStackMem[sigStackSize] = {};
 
 } // namespace Catch
 
@@ -179,6 +179,78 @@ TEST_CASE("Indexer Basic Tests") {
     }
 }
 
+/** A key whose id is forced, used to simulate hash collisions between different terms */
+struct CollidingKey : public Key {
+    CollidingKey(long forced_id, std::string const &a_group, std::string const &a_term) :
+    Key(forced_id, a_group), term(a_term) {
+    }
+
+    bool operator==(const Key &other) const override {
+        auto other_colliding_key = dynamic_cast<const CollidingKey *>(&other);
+        return other_colliding_key != nullptr && Key::operator==(other) && term == other_colliding_key->term;
+    }
+
+    std::string term;
+};
+
+TEST_CASE("ReverseIndex term dictionary handles id collisions") {
+    ReverseIndex r_index;
+    SPKey love_key = std::make_shared<CollidingKey>(1337, ":keyword", "love");
+    SPKey hate_key = std::make_shared<CollidingKey>(1337, ":keyword", "hate");
+    SPKey love_key_copy = std::make_shared<CollidingKey>(1337, ":keyword", "love");
+    auto love_doc = std::make_shared<Document>("love_doc");
+    auto hate_doc = std::make_shared<Document>("hate_doc");
+
+    r_index.putDocument(love_key, love_doc, 0);
+    r_index.putDocument(hate_key, hate_doc, 1);
+    REQUIRE(r_index.getKeyCount() == 2);
+
+    SPDocumentSet love_docs = r_index.getDocuments(love_key_copy);
+    REQUIRE(love_docs.size() == 1);
+    REQUIRE(love_docs.contains(love_doc));
+
+    SPDocumentSet hate_docs = r_index.getDocuments(hate_key);
+    REQUIRE(hate_docs.size() == 1);
+    REQUIRE(hate_docs.contains(hate_doc));
+
+    r_index.removeDocument(love_key_copy, love_doc, 0);
+    REQUIRE(!r_index.hasDocuments(love_key));
+    REQUIRE(r_index.hasDocuments(hate_key));
+    REQUIRE(r_index.getKeyCount() == 1);
+
+    // StringKeys with equal ids are still ordered and compared by their strings
+    StringKey a("a", ":keyword");
+    StringKey b("b", ":keyword");
+    REQUIRE(!(a == b));
+    REQUIRE((a < b) != (b < a));
+}
+
+TEST_CASE("Indexer allocation free lookups by (string, group) views") {
+    Indexer indexer;
+    auto doc = std::make_shared<Document>("doc");
+    doc->addKey(std::make_shared<StringKey>("love", ":keyword"));
+    doc->addKey(std::make_shared<StringKey>("mp4", ":extension"));
+    indexer.indexDocument(doc);
+
+    SPDocumentSet const &love_docs = indexer.findDocuments("love", ":keyword");
+    REQUIRE(love_docs.size() == 1);
+    REQUIRE(love_docs.contains(doc));
+
+    std::string query("love mp4");
+    yuca::utils::StringView mp4_view(query.data() + 5, 3);
+    StringKeyView mp4_key(mp4_view, ":extension");
+    REQUIRE(mp4_key.id == StringKey("mp4", ":extension").getId());
+    REQUIRE(indexer.findDocuments(mp4_key).contains(doc));
+
+    REQUIRE(indexer.findDocuments("mp4", ":keyword").isEmpty());
+    REQUIRE(indexer.findDocuments("hate", ":keyword").isEmpty());
+    REQUIRE(indexer.findDocuments("love", ":nope").isEmpty());
+
+    indexer.removeDocument(doc);
+    REQUIRE(indexer.findDocuments("love", ":keyword").isEmpty());
+    REQUIRE(&indexer.findDocuments("love", ":keyword") == &ReverseIndex::NO_DOCUMENTS);
+}
+
 TEST_CASE("Indexer non shared pointer methods tests") {
     Document foo_doc("foo_id");
     std::string foo_str("foo");
@@ -267,6 +339,1559 @@ TEST_CASE("Indexer SearchRequest struct tests") {
     REQUIRE(title_keywords.get(4) == "need");
 }
 
+TEST_CASE("SearchRequest tokenizer") {
+    SearchRequest request("  love  is :title all  you :extension mp4 :title need\tit ", ":keyword");
+    REQUIRE(request.total_keywords == 7);
+    REQUIRE(request.getGroupCount() == 3);
+
+    // groups in the order they first appear, repeated groups are merged
+    REQUIRE(request.getGroup(0) == ":keyword");
+    REQUIRE(request.getGroup(1) == ":title");
+    REQUIRE(request.getGroup(2) == ":extension");
+
+    REQUIRE(request.getKeywordCount(0) == 2);
+    REQUIRE(request.getKeyword(0, 0) == "love");
+    REQUIRE(request.getKeyword(0, 1) == "is");
+
+    REQUIRE(request.getKeywordCount(1) == 4);
+    REQUIRE(request.getKeyword(1, 0) == "all");
+    REQUIRE(request.getKeyword(1, 1) == "you");
+    REQUIRE(request.getKeyword(1, 2) == "need");
+    REQUIRE(request.getKeyword(1, 3) == "it");
+
+    REQUIRE(request.getKeywordCount(2) == 1);
+    REQUIRE(request.getKeyword(2, 0) == "mp4");
+
+    // views stay valid on copies
+    SearchRequest request_copy(request);
+    REQUIRE(request_copy.getKeyword(1, 2) == "need");
+    REQUIRE(request_copy.getKeyword(1, 2).data() != request.getKeyword(1, 2).data());
+
+    // groups without keywords are ignored
+    SearchRequest empty_groups(":title :extension", ":keyword");
+    REQUIRE(empty_groups.getGroupCount() == 0);
+    REQUIRE(empty_groups.total_keywords == 0);
+}
+
+TEST_CASE("SearchRequest boolean query tree") {
+    SearchRequest request(":title +love -hate you :extension mp4 OR (:year 1974 1975) -bad", ":keyword");
+    REQUIRE(request.hasQuery());
+    // excluded keywords aren't part of the flattened keyword lists
+    REQUIRE(request.total_keywords == 5);
+    REQUIRE(request.getKeywords(":title").size() == 2);
+    REQUIRE(request.getKeywords(":keyword").size() == 0);
+
+    // OR( AND(:title, :extension), AND(:year, :keyword) )
+    SearchRequest::QueryNode const &root = request.getNode(request.getRoot());
+    REQUIRE(root.type == SearchRequest::QueryNode::OR);
+    REQUIRE(root.children.size() == 2);
+
+    SearchRequest::QueryNode const &left = request.getNode(root.children[0]);
+    REQUIRE(left.type == SearchRequest::QueryNode::AND);
+    REQUIRE(left.children.size() == 2);
+    SearchRequest::QueryNode const &title_clause = request.getNode(left.children[0]);
+    REQUIRE(title_clause.type == SearchRequest::QueryNode::CLAUSE);
+    REQUIRE(request.getGroup(title_clause.group) == ":title");
+    REQUIRE(title_clause.children.size() == 3);
+    // there's a +required keyword, so the optional one doesn't have to match
+    REQUIRE(title_clause.min_should_match == 0);
+    REQUIRE(request.getTerm(title_clause.children[0]).occur == SearchRequest::MUST);
+    REQUIRE(request.getTermString(title_clause.children[0]) == "love");
+    REQUIRE(request.getTerm(title_clause.children[1]).occur == SearchRequest::MUST_NOT);
+    REQUIRE(request.getTermString(title_clause.children[1]) == "hate");
+    REQUIRE(request.getTerm(title_clause.children[2]).occur == SearchRequest::SHOULD);
+
+    // after the parentheses we're back in the implicit group
+    SearchRequest::QueryNode const &right = request.getNode(root.children[1]);
+    REQUIRE(right.type == SearchRequest::QueryNode::AND);
+    SearchRequest::QueryNode const &year_clause = request.getNode(right.children[0]);
+    REQUIRE(request.getGroup(year_clause.group) == ":year");
+    REQUIRE(year_clause.min_should_match == 1);
+    SearchRequest::QueryNode const &bad_clause = request.getNode(right.children[1]);
+    REQUIRE(request.getGroup(bad_clause.group) == ":keyword");
+    REQUIRE(request.getTerm(bad_clause.children[0]).occur == SearchRequest::MUST_NOT);
+
+    SearchRequest minimum_should_match(":title~2 love is all you need", ":keyword");
+    REQUIRE(minimum_should_match.getGroup(0) == ":title");
+    REQUIRE(minimum_should_match.getNode(minimum_should_match.getRoot()).min_should_match == 2);
+
+    // lowercase "or" is a keyword, lone prefixes and unbalanced parentheses are ignored
+    SearchRequest lenient("a or + ) b (", ":keyword");
+    REQUIRE(lenient.total_keywords == 3);
+    REQUIRE(lenient.getKeyword(0, 1) == "or");
+
+    REQUIRE(!SearchRequest("( ) OR", ":keyword").hasQuery());
+}
+
+TEST_CASE("Posting list set operations") {
+    PostingList list;
+    REQUIRE(list.add(5));
+    REQUIRE(list.add(1));
+    REQUIRE(list.add(9));
+    REQUIRE(!list.add(5));
+    REQUIRE(list.getStdVector() == std::vector<DocOrdinal>({1, 5, 9}));
+
+    std::vector<DocOrdinal> a = {1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29};
+    std::vector<DocOrdinal> b = {3, 4, 5, 27, 40};
+    std::vector<DocOrdinal> c = {5, 27, 29};
+
+    PostingCursor cursor((OrdinalRange(a)));
+    REQUIRE(cursor.advance(20));
+    REQUIRE(cursor.current() == 21);
+    REQUIRE(!cursor.advance(30));
+
+    REQUIRE(postings::intersectAll({OrdinalRange(a), OrdinalRange(b), OrdinalRange(c)}) ==
+            std::vector<DocOrdinal>({5, 27}));
+    REQUIRE(postings::unionAll({OrdinalRange(b), OrdinalRange(c)}, 41) == std::vector<DocOrdinal>({3, 4, 5, 27, 29, 40}));
+    REQUIRE(postings::unionAll({OrdinalRange(b), OrdinalRange(c)}, 1 << 20) ==
+            std::vector<DocOrdinal>({3, 4, 5, 27, 29, 40}));
+    REQUIRE(postings::unionAll({OrdinalRange(a), OrdinalRange(b), OrdinalRange(c), OrdinalRange()}, 1 << 20) ==
+            std::vector<DocOrdinal>({1, 3, 4, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 40}));
+    REQUIRE(postings::atLeast({OrdinalRange(a), OrdinalRange(b), OrdinalRange(c)}, 2) ==
+            std::vector<DocOrdinal>({3, 5, 27, 29}));
+
+    std::vector<DocOrdinal> candidates(b);
+    postings::subtract(candidates, OrdinalRange(a));
+    REQUIRE(candidates == std::vector<DocOrdinal>({4, 40}));
+
+    std::vector<DocOrdinal> few = {1, 4, 6, 29, 40, 41};
+    postings::intersectWithAny(few, {OrdinalRange(b), OrdinalRange(c)});
+    REQUIRE(few == std::vector<DocOrdinal>({4, 29, 40}));
+
+    DocBitmap bitmap;
+    bitmap.orWith(OrdinalRange(b));
+    bitmap.andNot(OrdinalRange(c));
+    REQUIRE(bitmap.count() == 3);
+    std::vector<DocOrdinal> remaining;
+    bitmap.toOrdinals(remaining);
+    REQUIRE(remaining == std::vector<DocOrdinal>({3, 4, 40}));
+}
+
+TEST_CASE("Indexer boolean search") {
+    Indexer indexer;
+    auto make_doc = [&indexer](std::string const &id, std::string const &title, std::string const &ext) {
+        auto doc = std::make_shared<Document>(id);
+        std::istringstream words(title);
+        std::string word;
+        while (words >> word) {
+            doc->addKey(std::make_shared<StringKey>(word, ":title"));
+            doc->addKey(std::make_shared<StringKey>(word, ":keyword"));
+        }
+        doc->addKey(std::make_shared<StringKey>(ext, ":extension"));
+        indexer.indexDocument(doc);
+        return doc;
+    };
+    auto love_song = make_doc("1", "love song", "mp3");
+    auto love_hate = make_doc("2", "love and hate", "mp4");
+    auto hate_song = make_doc("3", "hate song", "mp3");
+    auto war_movie = make_doc("4", "war and peace", "avi");
+
+    auto ids = [&indexer](std::string const &query) {
+        std::set<std::string> result;
+        for (auto const &sr : indexer.search(query).getStdVector()) {
+            result.insert(std::to_string(sr.document_sp->getId()));
+        }
+        return result;
+    };
+    auto id_set = [](std::initializer_list<SPDocument> docs) {
+        std::set<std::string> result;
+        for (auto const &doc : docs) {
+            result.insert(std::to_string(doc->getId()));
+        }
+        return result;
+    };
+
+    // legacy behavior, OR within a group, AND across groups
+    REQUIRE(ids("love song") == id_set({love_song, love_hate, hate_song}));
+    REQUIRE(ids("love :extension mp3") == id_set({love_song}));
+
+    REQUIRE(ids("+love +song") == id_set({love_song}));
+    REQUIRE(ids("love -hate") == id_set({love_song}));
+    REQUIRE(ids("-love") == id_set({hate_song, war_movie}));
+    REQUIRE(ids(":extension mp3 :title -hate") == id_set({love_song}));
+    REQUIRE(ids(":title war OR :extension mp4") == id_set({love_hate, war_movie}));
+    REQUIRE(ids("(:title hate :extension mp3) OR (:title peace)") == id_set({hate_song, war_movie}));
+    REQUIRE(ids(":title~2 love hate song") == id_set({love_song, love_hate, hate_song}));
+    REQUIRE(ids(":title~2 love song peace") == id_set({love_song}));
+    REQUIRE(ids(":title +love +peace").empty());
+    REQUIRE(ids("+nothing love").empty());
+
+    // documents that match more keywords rank higher
+    auto results = indexer.search("love song");
+    REQUIRE(results.get(0).document_sp == love_song);
+    REQUIRE(results.get(0).score == 2);
+
+    // ordinals of removed documents get reused and never leak into results
+    indexer.removeDocument(love_song);
+    REQUIRE(ids("-love") == id_set({hate_song, war_movie}));
+    auto new_song = make_doc("5", "new song", "ogg");
+    REQUIRE(ids("song") == id_set({hate_song, new_song}));
+    REQUIRE(ids("-war -hate") == id_set({new_song}));
+}
+
+TEST_CASE("Indexer query planner") {
+    Indexer indexer;
+    // many documents under :keyword common, few under :extension rare, so ANDs are driven by :extension
+    for (int i = 0; i < 200; i++) {
+        auto doc = std::make_shared<Document>("doc " + std::to_string(i));
+        doc->addKey(std::make_shared<StringKey>("common", ":keyword"));
+        doc->addKey(std::make_shared<StringKey>(i % 2 == 0 ? "even" : "odd", ":keyword"));
+        if (i % 50 == 0) {
+            doc->addKey(std::make_shared<StringKey>("rare", ":extension"));
+        }
+        if (i % 3 == 0) {
+            doc->addKey(std::make_shared<StringKey>("three", ":tag"));
+        }
+        indexer.indexDocument(doc);
+    }
+    // docs 0, 50, 100, 150
+    REQUIRE(indexer.search("common :extension rare").size() == 4);
+    REQUIRE(indexer.search(":extension rare :keyword +common -odd").size() == 4);
+    REQUIRE(indexer.search(":extension rare :keyword odd").size() == 0);
+    // 0 and 150 are multiples of 3, 50 and 100 aren't. (50 OR 100 is even, 150 is too)
+    REQUIRE(indexer.search(":extension rare (:tag three OR :keyword odd)").size() == 2);
+    REQUIRE(indexer.search(":extension rare (:tag three OR :keyword even)").size() == 4);
+    REQUIRE(indexer.search(":extension rare ((:tag three :keyword even) OR :keyword nothing)").size() == 2);
+    REQUIRE(indexer.search(":extension rare (:tag three :keyword -odd)").size() == 2);
+    REQUIRE(indexer.search(":keyword~2 common even odd").size() == 200);
+    REQUIRE(indexer.search(":keyword~2 even odd").size() == 0);
+
+    // a group without matches empties the whole AND
+    REQUIRE(indexer.search("common :extension nothing").isEmpty());
+    REQUIRE(indexer.search("common :nogroup rare").isEmpty());
+    SearchRequest request("common :extension nothing", ":keyword");
+    REQUIRE(indexer.findDocuments(request).isEmpty());
+    SearchRequest matching_request("common :extension rare", ":keyword");
+    REQUIRE(indexer.findDocuments(matching_request).get(":extension").size() == 4);
+    REQUIRE(indexer.findDocuments(matching_request).get(":keyword").size() == 200);
+}
+
+TEST_CASE("Indexer prepared queries") {
+    Indexer indexer;
+    std::vector<std::string> titles = {"love song", "hate song", "love story"};
+    std::vector<std::string> extensions = {"mp3", "mp3", "mp4"};
+    for (std::size_t i = 0; i < titles.size(); i++) {
+        auto doc = std::make_shared<Document>(titles[i]);
+        std::istringstream words(titles[i]);
+        std::string word;
+        while (words >> word) {
+            doc->addKey(std::make_shared<StringKey>(word, ":title"));
+        }
+        doc->addKey(std::make_shared<StringKey>(extensions[i], ":extension"));
+        doc->stringProperty("title", titles[i]);
+        indexer.indexDocument(doc);
+    }
+
+    PreparedQuery prepared_query = indexer.prepare(":title +? -? :extension ?");
+    REQUIRE(prepared_query.getParameterCount() == 3);
+
+    List<std::string> parameters;
+    parameters.add("love");
+    parameters.add("story");
+    parameters.add("mp3");
+    REQUIRE(prepared_query.bind(parameters) == ":title +love -story :extension mp3");
+    auto results = indexer.search(prepared_query, parameters);
+    REQUIRE(results.size() == 1);
+    REQUIRE(results.get(0).document_sp->stringProperty("title") == "love song");
+
+    // same prepared query, other values
+    List<std::string> other_parameters;
+    other_parameters.add("song");
+    other_parameters.add("love");
+    other_parameters.add("mp3");
+    results = indexer.search(prepared_query, other_parameters, "title", 0);
+    REQUIRE(results.size() == 1);
+    REQUIRE(results.get(0).document_sp->stringProperty("title") == "hate song");
+
+    // it keeps working as the index changes
+    auto doc = std::make_shared<Document>("love again");
+    doc->addKey(std::make_shared<StringKey>("love", ":title"));
+    doc->addKey(std::make_shared<StringKey>("mp3", ":extension"));
+    indexer.indexDocument(doc);
+    REQUIRE(indexer.search(prepared_query, parameters).size() == 2);
+
+    // unbound parameters are searched for literally
+    REQUIRE(prepared_query.bind(List<std::string>()) == ":title +? -? :extension ?");
+    REQUIRE(indexer.search(prepared_query, List<std::string>()).isEmpty());
+    REQUIRE(indexer.search(":title love story").size() == 3);
+}
+
+TEST_CASE("Indexer result cache") {
+    Indexer indexer;
+    auto add_doc = [&indexer](std::string const &id, std::string const &keyword, std::string const &group) {
+        auto doc = std::make_shared<Document>(id);
+        doc->addKey(std::make_shared<StringKey>(keyword, group));
+        indexer.indexDocument(doc);
+        return doc;
+    };
+    add_doc("a", "love", ":keyword");
+    add_doc("b", "love", ":keyword");
+    add_doc("c", "mp4", ":extension");
+
+    // disabled by default
+    REQUIRE(!indexer.getResultCache().isEnabled());
+    indexer.search("love");
+    REQUIRE(indexer.getResultCache().size() == 0);
+
+    indexer.setResultCacheCapacity(2);
+    REQUIRE(indexer.search("love").size() == 2);
+    REQUIRE(indexer.getResultCache().getMisses() == 1);
+    // whitespace doesn't matter
+    REQUIRE(indexer.search("  love ").size() == 2);
+    REQUIRE(indexer.getResultCache().getHits() == 1);
+    REQUIRE(indexer.search("love", "", 1).size() == 1);
+    REQUIRE(indexer.getResultCache().getMisses() == 2);
+
+    // changes to other groups keep the entry
+    add_doc("d", "avi", ":extension");
+    REQUIRE(indexer.search("love").size() == 2);
+    REQUIRE(indexer.getResultCache().getHits() == 2);
+
+    // changes to the group invalidate it
+    auto e = add_doc("e", "love", ":keyword");
+    REQUIRE(indexer.search("love").size() == 3);
+    REQUIRE(indexer.getResultCache().getHits() == 2);
+    indexer.removeDocument(e);
+    REQUIRE(indexer.search("love").size() == 2);
+    REQUIRE(indexer.getResultCache().getHits() == 2);
+
+    // exclusion only queries depend on every document
+    REQUIRE(indexer.search("-love").size() == 2);
+    add_doc("f", "ogg", ":extension");
+    REQUIRE(indexer.search("-love").size() == 3);
+
+    // least recently used entries go first
+    REQUIRE(indexer.getResultCache().size() == 2);
+    indexer.setResultCacheCapacity(1);
+    REQUIRE(indexer.getResultCache().size() == 1);
+    unsigned long hits = indexer.getResultCache().getHits();
+    indexer.search("-love");
+    REQUIRE(indexer.getResultCache().getHits() == hits + 1);
+
+    // a bound "comm*" is a literal keyword, the same text written in a query is a prefix
+    indexer.setResultCacheCapacity(10);
+    add_doc("g", "comm*", ":title");
+    add_doc("h", "communism", ":title");
+    add_doc("i", "common", ":title");
+    PreparedQuery prepared = indexer.prepare(":title ?");
+    List<std::string> parameters;
+    parameters.add("comm*");
+    REQUIRE(indexer.search(prepared, parameters, "", 0).size() == 1);
+    REQUIRE(indexer.search(":title comm*").size() == 3);
+    hits = indexer.getResultCache().getHits();
+    REQUIRE(indexer.search(prepared, parameters, "", 0).size() == 1);
+    REQUIRE(indexer.getResultCache().getHits() == hits + 1);
+
+    indexer.clear();
+    REQUIRE(indexer.getResultCache().size() == 0);
+    REQUIRE(indexer.search("love").isEmpty());
+}
+
+TEST_CASE("Indexer prefix and wildcard keywords") {
+    Indexer indexer;
+    std::vector<std::string> words = {"communism", "community", "commute", "common", "comet", "cat", "mp3", "mp4"};
+    for (auto const &word : words) {
+        auto doc = std::make_shared<Document>(word);
+        doc->addKey(std::make_shared<StringKey>(word, ":keyword"));
+        doc->addKey(std::make_shared<StringKey>(word.substr(0, 2), ":start"));
+        indexer.indexDocument(doc);
+    }
+    SearchRequest request("comm* c?t* mp?", ":keyword");
+    REQUIRE(request.getTerm(0).type == SearchRequest::PREFIX);
+    REQUIRE(request.getTerm(1).type == SearchRequest::WILDCARD);
+    REQUIRE(request.getTerm(2).type == SearchRequest::WILDCARD);
+    REQUIRE(SearchRequest("?", ":keyword").getTerm(0).type == SearchRequest::EXACT);
+
+    REQUIRE(indexer.search("comm*").size() == 4);
+    REQUIRE(indexer.search("commun*").size() == 2);
+    REQUIRE(indexer.search("co*t*").size() == 3); // community, commute, comet
+    REQUIRE(indexer.search("mp?").size() == 2);
+    REQUIRE(indexer.search("*").size() == words.size());
+    REQUIRE(indexer.search("+comm* -common :start co").size() == 3);
+    REQUIRE(indexer.search("zzz*").isEmpty());
+    REQUIRE(indexer.search(":nogroup comm*").isEmpty());
+
+    // expansions are bounded, the first terms in order are kept
+    indexer.setMaxTermExpansions(2);
+    auto results = indexer.search("comm*");
+    REQUIRE(results.size() == 2);
+    std::set<long> expected = {Document("common").getId(), Document("communism").getId()};
+    std::set<long> found = {results.get(0).document_sp->getId(), results.get(1).document_sp->getId()};
+    REQUIRE(found == expected);
+    indexer.setMaxTermExpansions(Indexer::DEFAULT_MAX_TERM_EXPANSIONS);
+
+    // removed keys leave the ordered dictionary
+    indexer.removeDocument("community");
+    REQUIRE(indexer.search("commun*").size() == 1);
+
+    // bound parameters are taken literally
+    PreparedQuery prepared_query = indexer.prepare("?");
+    List<std::string> parameters;
+    parameters.add("comm*");
+    REQUIRE(indexer.search(prepared_query, parameters).isEmpty());
+}
+
+TEST_CASE("Indexer fuzzy keywords") {
+    Indexer indexer;
+    std::vector<std::string> words = {"communism", "communist", "community", "comunism", "capitalism", "cat", "cut", "at"};
+    for (auto const &word : words) {
+        auto doc = std::make_shared<Document>(word);
+        doc->addKey(std::make_shared<StringKey>(word, ":keyword"));
+        indexer.indexDocument(doc);
+    }
+    SearchRequest request("comunism~1 cat~ cat~7 a~12", ":keyword");
+    REQUIRE(request.getTerm(0).type == SearchRequest::FUZZY);
+    REQUIRE(request.getTerm(0).max_edits == 1);
+    REQUIRE(SearchRequest::stripOperator(request.getTermString(0), SearchRequest::FUZZY) == "comunism");
+    REQUIRE(request.getTerm(1).max_edits == SearchRequest::MAX_FUZZY_EDITS);
+    REQUIRE(request.getTerm(2).max_edits == SearchRequest::MAX_FUZZY_EDITS);
+    REQUIRE(request.getTerm(3).type == SearchRequest::EXACT);
+
+    // comunism, communism
+    REQUIRE(indexer.search("comunism~1").size() == 2);
+    // + communist
+    REQUIRE(indexer.search("comunism~2").size() == 3);
+    // cat, cut, at
+    REQUIRE(indexer.search("cat~1").size() == 3);
+    REQUIRE(indexer.search("cat~0").size() == 1);
+    REQUIRE(indexer.search("dog~1").isEmpty());
+    REQUIRE(indexer.search("+cat~1 -cut").size() == 2);
+
+    // the closest expansions are kept
+    indexer.setMaxTermExpansions(1);
+    auto results = indexer.search("comunism~2");
+    REQUIRE(results.size() == 1);
+    REQUIRE(results.get(0).document_sp->getId() == Document("comunism").getId());
+
+    // same matches as comparing against every key
+    Indexer small_alphabet;
+    std::set<std::string> dictionary;
+    std::srand(1234);
+    while (dictionary.size() < 300) {
+        std::string word(1 + std::rand() % 6, 'a');
+        for (auto &c : word) {
+            c = static_cast<char>('a' + std::rand() % 3);
+        }
+        dictionary.insert(word);
+    }
+    for (auto const &word : dictionary) {
+        auto doc = std::make_shared<Document>(word);
+        doc->addKey(std::make_shared<StringKey>(word, ":keyword"));
+        small_alphabet.indexDocument(doc);
+    }
+    for (std::string term : {"abc", "cabba", "b", "aaaaaa"}) {
+        for (std::uint32_t edits = 1; edits <= 2; edits++) {
+            std::size_t expected = 0;
+            for (auto const &word : dictionary) {
+                expected += yuca::utils::levenshteinDistance(term, word) <= edits ? 1 : 0;
+            }
+            REQUIRE(small_alphabet.search(term + "~" + std::to_string(edits)).size() == expected);
+        }
+    }
+}
+
+TEST_CASE("Indexer trigram index") {
+    Indexer indexer;
+    std::vector<std::string> titles = {"Deceit", "Masters of Deceit", "Receipt", "Ceiling fan", "ab", "abcab"};
+    for (auto const &title : titles) {
+        auto doc = std::make_shared<Document>(title);
+        doc->addKey(std::make_shared<StringKey>("movie", ":keyword"));
+        doc->stringProperty("title", title);
+        indexer.indexDocument(doc);
+    }
+    auto untitled = std::make_shared<Document>("untitled");
+    untitled->addKey(std::make_shared<StringKey>("movie", ":keyword"));
+    indexer.indexDocument(untitled);
+
+    // without the index every document gets checked, with it the answers must be the same
+    for (int pass = 0; pass < 2; pass++) {
+        REQUIRE(indexer.findDocumentsContaining("title", "ceit").size() == 2);
+        REQUIRE(indexer.findDocumentsContaining("title", "DECEIT").size() == 2);
+        REQUIRE(indexer.findDocumentsContaining("title", "cei").size() == 4);
+        REQUIRE(indexer.findDocumentsContaining("title", "b").size() == 2);
+        REQUIRE(indexer.findDocumentsContaining("title", "").size() == titles.size());
+        REQUIRE(indexer.findDocumentsContaining("title", "cabc").isEmpty());
+        REQUIRE(indexer.findDocumentsContaining("title", "zzz").isEmpty());
+        REQUIRE(indexer.findDocumentsContaining("name", "ceit").isEmpty());
+        REQUIRE_FALSE(indexer.hasTrigramIndex("title"));
+        indexer.addTrigramIndex("title");
+        REQUIRE(indexer.hasTrigramIndex("title"));
+        if (pass == 0) {
+            indexer.removeTrigramIndex("title");
+        }
+    }
+
+    // documents indexed, re-indexed and removed later
+    auto receipt = std::make_shared<Document>("Receipt");
+    receipt->addKey(std::make_shared<StringKey>("movie", ":keyword"));
+    receipt->stringProperty("title", "Conceit");
+    indexer.indexDocument(receipt);
+    REQUIRE(indexer.findDocumentsContaining("title", "ceit").size() == 3);
+    REQUIRE(indexer.findDocumentsContaining("title", "receipt").isEmpty());
+    indexer.removeDocument("Deceit");
+    REQUIRE(indexer.findDocumentsContaining("title", "ceit").size() == 2);
+    indexer.clear();
+    REQUIRE(indexer.findDocumentsContaining("title", "ceit").isEmpty());
+
+    // ranking by the property scores the same with and without the index
+    Indexer plain;
+    Indexer indexed;
+    indexed.addTrigramIndex("title");
+    for (auto const &title : {"love", "Love", "lover", "glove", "loves me", "clover", "lo"}) {
+        for (Indexer *each : {&plain, &indexed}) {
+            auto doc = std::make_shared<Document>(title);
+            doc->addKey(std::make_shared<StringKey>("love", ":keyword"));
+            doc->stringProperty("title", title);
+            each->indexDocument(doc);
+        }
+    }
+    auto plain_results = plain.search("love", "title");
+    auto indexed_results = indexed.search("love", "title");
+    REQUIRE(plain_results.size() == indexed_results.size());
+    for (std::size_t i = 0; i < plain_results.size(); i++) {
+        REQUIRE(plain_results.get(i).document_sp->getId() == indexed_results.get(i).document_sp->getId());
+        REQUIRE(plain_results.get(i).score == indexed_results.get(i).score);
+    }
+
+    // the edit distance filter never drops a value that is close enough
+    TrigramIndex trigram_index("title");
+    std::vector<std::string> values;
+    std::srand(4321);
+    for (DocOrdinal ordinal = 0; ordinal < 400; ordinal++) {
+        std::string value(static_cast<std::size_t>(std::rand() % 9), 'a');
+        for (auto &c : value) {
+            c = static_cast<char>('a' + std::rand() % 3);
+        }
+        values.push_back(value);
+        trigram_index.putDocument(ordinal, value);
+    }
+    for (std::string text : {"abcabc", "aabbcc", "abc", "cccccccc", "ab"}) {
+        for (std::size_t edits = 0; edits <= 2; edits++) {
+            std::vector<DocOrdinal> candidates;
+            for (DocOrdinal ordinal = 0; ordinal < values.size(); ordinal++) {
+                candidates.push_back(ordinal);
+            }
+            trigram_index.keepPossiblyWithin(text, edits, candidates);
+            for (DocOrdinal ordinal = 0; ordinal < values.size(); ordinal++) {
+                if (yuca::utils::levenshteinDistance(text, values[ordinal]) <= edits) {
+                    REQUIRE(std::binary_search(candidates.begin(), candidates.end(), ordinal));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Indexer completions") {
+    Indexer indexer;
+    // keyword -> number of documents
+    std::vector<std::pair<std::string, int>> keywords = {{"master", 5}, {"masters", 3}, {"mask", 3}, {"mass", 1},
+                                                         {"ma", 2}, {"deceit", 4}};
+    int doc_number = 0;
+    for (auto const &keyword : keywords) {
+        for (int i = 0; i < keyword.second; i++) {
+            auto doc = std::make_shared<Document>(doc_number++);
+            doc->addKey(std::make_shared<StringKey>(keyword.first, ":title"));
+            indexer.indexDocument(doc);
+        }
+    }
+    auto completions = indexer.complete(":title", "mas", 3);
+    REQUIRE(completions.size() == 3);
+    REQUIRE(completions.get(0) == Completion{"master", 5});
+    // ties in string order
+    REQUIRE(completions.get(1) == Completion{"mask", 3});
+    REQUIRE(completions.get(2) == Completion{"masters", 3});
+    REQUIRE(indexer.complete(":title", "ma", 10).size() == 5);
+    REQUIRE(indexer.complete(":title", "", 1).get(0).keyword == "master");
+    REQUIRE(indexer.complete(":title", "masterz", 10).isEmpty());
+    REQUIRE(indexer.complete(":title", "ma", 0).isEmpty());
+    REQUIRE(indexer.complete(":nope", "ma", 10).isEmpty());
+
+    // kept up to date as documents are removed and indexed
+    for (long id = 0; id < 3; id++) {
+        indexer.removeDocument(id);
+    }
+    completions = indexer.complete(":title", "mas", 3);
+    REQUIRE(completions.get(0) == Completion{"mask", 3});
+    REQUIRE(completions.get(1) == Completion{"masters", 3});
+    REQUIRE(completions.get(2) == Completion{"master", 2});
+    for (long id = 3; id < 5; id++) {
+        indexer.removeDocument(id);
+    }
+    REQUIRE(indexer.complete(":title", "master", 10).size() == 1);
+    auto doc = std::make_shared<Document>(doc_number++);
+    doc->addKey(std::make_shared<StringKey>("masterpiece", ":title"));
+    indexer.indexDocument(doc);
+    completions = indexer.complete(":title", "master", 10);
+    REQUIRE(completions.size() == 2);
+    REQUIRE(completions.get(1) == Completion{"masterpiece", 1});
+
+    // same answers as sorting every keyword
+    CompletionTrie trie;
+    std::map<std::string, std::size_t> weights;
+    std::srand(99);
+    for (int i = 0; i < 2000; i++) {
+        std::string word(static_cast<std::size_t>(1 + std::rand() % 5), 'a');
+        for (auto &c : word) {
+            c = static_cast<char>('a' + std::rand() % 3);
+        }
+        std::size_t weight = static_cast<std::size_t>(std::rand() % 4);
+        trie.setWeight(word, weight);
+        weights[word] = weight;
+    }
+    for (std::string prefix : {"", "a", "ab", "cab", "bbbbb"}) {
+        std::vector<std::pair<std::size_t, std::string>> expected;
+        for (auto const &weight : weights) {
+            if (weight.second > 0 && weight.first.compare(0, prefix.size(), prefix) == 0) {
+                expected.emplace_back(weight.second, weight.first);
+            }
+        }
+        std::sort(expected.begin(), expected.end(), [](std::pair<std::size_t, std::string> const &a,
+                                                       std::pair<std::size_t, std::string> const &b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        auto found = trie.complete(prefix, 7);
+        REQUIRE(found.size() == std::min<std::size_t>(7, expected.size()));
+        for (std::size_t i = 0; i < found.size(); i++) {
+            REQUIRE(found[i].keyword == expected[i].second);
+            REQUIRE(found[i].document_count == expected[i].first);
+        }
+    }
+}
+
+TEST_CASE("Indexer search as you type sessions") {
+    REQUIRE(SearchSession::typeAheadQuery("masters of dec") == "masters of dec*");
+    REQUIRE(SearchSession::typeAheadQuery("masters of dec ") == "masters of dec ");
+    REQUIRE(SearchSession::typeAheadQuery(":title +dec") == ":title +dec*");
+    REQUIRE(SearchSession::typeAheadQuery("(:title dec") == "(:title dec*");
+    REQUIRE(SearchSession::typeAheadQuery(":title dec*") == ":title dec*");
+    REQUIRE(SearchSession::typeAheadQuery(":title -dec") == ":title -dec");
+    REQUIRE(SearchSession::typeAheadQuery("love :title") == "love :title");
+    REQUIRE(SearchSession::typeAheadQuery("love OR") == "love OR");
+    REQUIRE(SearchSession::typeAheadQuery("") == "");
+
+    auto refines = [](std::string const &previous, std::string const &current) {
+        return SearchSession::isRefinement(SearchRequest(previous, ":keyword"), SearchRequest(current, ":keyword"));
+    };
+    REQUIRE(refines("masters of dec*", "masters of dece*"));
+    REQUIRE(refines("masters of dec*", "masters of deceit"));
+    REQUIRE(refines("love :year 1974", "love :year 1974"));
+    REQUIRE_FALSE(refines("masters of dece*", "masters of dec*"));
+    REQUIRE_FALSE(refines("masters of dec", "masters of dece"));
+    REQUIRE_FALSE(refines("masters of", "masters of dec*"));
+    REQUIRE_FALSE(refines("masters -dec*", "masters -dece*"));
+    REQUIRE_FALSE(refines(":title dec*", ":author dece*"));
+
+    Indexer indexer;
+    std::vector<std::string> titles = {"masters of deceit", "masters of december", "masters of war",
+                                       "deceit", "decent people", "declaration"};
+    long doc_id = 0;
+    for (auto const &title : titles) {
+        auto doc = std::make_shared<Document>(doc_id++);
+        for (auto const &word : split(title).getStdVector()) {
+            doc->addKey(std::make_shared<StringKey>(word, ":title"));
+        }
+        doc->addKey(std::make_shared<StringKey>(doc_id % 2 == 0 ? "even" : "odd", ":parity"));
+        doc->stringProperty("title", title);
+        indexer.indexDocument(doc);
+    }
+
+    // every keystroke gets what a cold search of the same query gets
+    SearchSession session;
+    auto same_as_cold_search = [&indexer, &session](std::string const &query) {
+        auto session_results = indexer.search(session, query, "title", 0);
+        auto cold_results = indexer.search(SearchSession::typeAheadQuery(query), "title", 0);
+        REQUIRE(session_results.size() == cold_results.size());
+        for (std::size_t i = 0; i < cold_results.size(); i++) {
+            REQUIRE(session_results.get(i).document_sp == cold_results.get(i).document_sp);
+            REQUIRE(session_results.get(i).score == cold_results.get(i).score);
+        }
+        return session_results.size();
+    };
+    REQUIRE(same_as_cold_search(":parity even :title +d") == 3);
+    REQUIRE(same_as_cold_search(":parity even :title +de") == 3);
+    REQUIRE(same_as_cold_search(":parity even :title +dec") == 3);
+    REQUIRE(same_as_cold_search(":parity even :title +dece") == 2);
+    REQUIRE(same_as_cold_search(":parity even :title +decei") == 1);
+    REQUIRE(session.getFullSearches() == 1);
+    REQUIRE(session.getIncrementalSearches() == 4);
+
+    // backspace widens the query
+    REQUIRE(same_as_cold_search(":parity even :title +dece") == 2);
+    REQUIRE(session.getFullSearches() == 2);
+
+    // documents came, the previous matches can't be trusted
+    auto doc = std::make_shared<Document>(doc_id++);
+    doc->addKey(std::make_shared<StringKey>("decentralized", ":title"));
+    doc->addKey(std::make_shared<StringKey>("even", ":parity"));
+    indexer.indexDocument(doc);
+    REQUIRE(same_as_cold_search(":parity even :title +decen") == 1);
+    REQUIRE(session.getFullSearches() == 3);
+
+    // a new keyword is a new query, growing the last one narrows its ORed alternatives
+    REQUIRE(same_as_cold_search(":title masters of ") == 3);
+    REQUIRE(same_as_cold_search(":title masters of w") == 3);
+    REQUIRE(same_as_cold_search(":title masters of wa") == 3);
+    REQUIRE(session.getFullSearches() == 5);
+    REQUIRE(session.getIncrementalSearches() == 5);
+
+    // so can changing synonyms, the expansion limit or the numeric indices
+    indexer.setMaxTermExpansions(50);
+    REQUIRE(same_as_cold_search(":title masters of wa") == 3);
+    REQUIRE(session.getFullSearches() == 6);
+    indexer.addSynonym(":title", "war", "declaration");
+    REQUIRE(same_as_cold_search(":title masters of wa") == 3);
+    REQUIRE(session.getFullSearches() == 7);
+    REQUIRE(same_as_cold_search(":title masters of war ") == 4);
+    indexer.removeSynonyms(":title", "war");
+    REQUIRE(same_as_cold_search(":title masters of war ") == 3);
+    for (long year = 1975; year < 1978; year++) {
+        auto dated = std::make_shared<Document>(doc_id++);
+        dated->addKey(std::make_shared<StringKey>(year == 1977 ? "?" : std::to_string(year), ":year"));
+        dated->longProperty("year", year);
+        indexer.indexDocument(dated);
+    }
+    REQUIRE(same_as_cold_search(":year [1970 TO 1980]") == 2);
+    indexer.addNumericIndex("year");
+    REQUIRE(same_as_cold_search(":year [1970 TO 1980]") == 3);
+    indexer.removeNumericIndex("year");
+    REQUIRE(same_as_cold_search(":year [1970 TO 1980]") == 2);
+    REQUIRE(indexer.search(session, "", "", 0).isEmpty());
+
+    // a prefix whose keys have many more documents than the previous matches only gets probed for them
+    for (int i = 0; i < 100; i++) {
+        auto common = std::make_shared<Document>(doc_id++);
+        common->addKey(std::make_shared<StringKey>(i % 2 == 0 ? "decade" : "decimal", ":title"));
+        if (i % 25 == 0) {
+            common->addKey(std::make_shared<StringKey>("rare", ":tag"));
+        }
+        indexer.indexDocument(common);
+    }
+    REQUIRE(same_as_cold_search(":tag rare :title +d") == 4);
+    REQUIRE(same_as_cold_search(":tag rare :title +dec") == 4);
+    REQUIRE(same_as_cold_search(":tag rare :title +deca") == 2);
+    REQUIRE(same_as_cold_search(":tag rare :title +decad") == 2);
+    REQUIRE(session.getIncrementalSearches() == 8);
+}
+
+TEST_CASE("Indexer spelling suggestions") {
+    Indexer indexer;
+    std::vector<std::pair<std::string, int>> keywords = {{"communism", 4}, {"communist", 2}, {"comunism", 1},
+                                                         {"capitalism", 3}, {"cat", 5}, {"cot", 1}, {"mp4", 3}};
+    long doc_id = 0;
+    for (auto const &keyword : keywords) {
+        for (int i = 0; i < keyword.second; i++) {
+            auto doc = std::make_shared<Document>(doc_id++);
+            doc->addKey(std::make_shared<StringKey>(keyword.first, keyword.first == "mp4" ? ":extension" : ":title"));
+            indexer.indexDocument(doc);
+        }
+    }
+    auto suggestions = indexer.suggest(":title comunism", 5);
+    REQUIRE(suggestions.size() == 2);
+    REQUIRE(suggestions.get(0).group == ":title");
+    REQUIRE(suggestions.get(0).keyword == "comunism");
+    REQUIRE(suggestions.get(0).suggestion == "communism");
+    REQUIRE(suggestions.get(0).edits == 1);
+    REQUIRE(suggestions.get(0).document_count == 4);
+    REQUIRE(suggestions.get(1).suggestion == "communist");
+    REQUIRE(suggestions.get(1).edits == 2);
+    REQUIRE(suggestions.indexOf(suggestions.get(1)) == 1);
+
+    // fewest edits first, then most documents
+    suggestions = indexer.suggest(":title comunist", 1);
+    REQUIRE(suggestions.size() == 1);
+    REQUIRE(suggestions.get(0).suggestion == "communist");
+
+    // common keywords aren't corrected to rarer ones, short ones only get 1 edit
+    REQUIRE(indexer.suggest(":title communism", 5).isEmpty());
+    suggestions = indexer.suggest(":title cot", 5);
+    REQUIRE(suggestions.size() == 1);
+    REQUIRE(suggestions.get(0).suggestion == "cat");
+
+    // every keyword that can match, under its own group
+    suggestions = indexer.suggest(":title comunism -cot :extension mp5 mp4 cap*", 5);
+    REQUIRE(suggestions.size() == 3);
+    REQUIRE(suggestions.get(2).group == ":extension");
+    REQUIRE(suggestions.get(2).keyword == "mp5");
+    REQUIRE(suggestions.get(2).suggestion == "mp4");
+    REQUIRE(indexer.suggest(":nope comunism", 5).isEmpty());
+    REQUIRE(indexer.suggest(":title comunism", 0).isEmpty());
+}
+
+TEST_CASE("Indexer synonyms") {
+    Indexer indexer;
+    std::vector<std::pair<std::string, std::string>> files = {{"beach", "jpg"}, {"sunset", "jpeg"}, {"sunrise", "png"},
+                                                              {"jpeg", "txt"}};
+    long doc_id = 0;
+    for (auto const &f : files) {
+        auto doc = std::make_shared<Document>(doc_id++);
+        doc->addKey(std::make_shared<StringKey>(f.first, ":title"));
+        doc->addKey(std::make_shared<StringKey>(f.second, ":extension"));
+        indexer.indexDocument(doc);
+    }
+    indexer.setResultCacheCapacity(8);
+    REQUIRE(indexer.search(":extension jpg").size() == 1);
+
+    indexer.addSynonym(":extension", "jpg", "jpeg");
+    indexer.addSynonym(":extension", "jpg", "jpeg");
+    indexer.addSynonym(":extension", "jpg", "jpe");
+    REQUIRE(indexer.getSynonyms(":extension", "jpg").size() == 2);
+    // the cached results went away with the synonyms change
+    REQUIRE(indexer.search(":extension jpg").size() == 2);
+    // one way, and only under its group
+    REQUIRE(indexer.search(":extension jpeg").size() == 1);
+    REQUIRE(indexer.search(":title jpg").isEmpty());
+    // the keyword and its synonyms are a single keyword of the query
+    auto results = indexer.search(":extension +jpg -png :title sunset");
+    REQUIRE(results.size() == 1);
+    REQUIRE(results.get(0).score == 2);
+    REQUIRE(indexer.search(":extension jpg~0").size() == 1);
+
+    SearchSession session;
+    REQUIRE(indexer.search(session, ":extension jpg :title sun", "", 0).size() == 1);
+    REQUIRE(indexer.search(session, ":extension jpg :title suns", "", 0).size() == 1);
+    REQUIRE(session.getIncrementalSearches() == 0);
+
+    indexer.removeSynonyms(":extension", "jpg");
+    REQUIRE(indexer.getSynonyms(":extension", "jpg").isEmpty());
+    REQUIRE(indexer.search(":extension jpg").size() == 1);
+}
+
+TEST_CASE("Indexer phrase and proximity queries") {
+    SearchRequest request(":title \"masters of deceit\" hoover NEAR/3 +fbi NEAR/1 x -cia", ":keyword");
+    REQUIRE(request.getNodeCount() == 4);
+    auto const &phrase = request.getNode(0);
+    REQUIRE(phrase.type == SearchRequest::QueryNode::PHRASE);
+    REQUIRE(phrase.children.size() == 3);
+    REQUIRE(phrase.distances == std::vector<std::uint32_t>({0, 0}));
+    REQUIRE(request.getTermString(phrase.children[2]) == "deceit");
+    REQUIRE(request.getTerm(phrase.children[2]).occur == SearchRequest::MUST);
+    auto const &near = request.getNode(1);
+    REQUIRE(near.type == SearchRequest::QueryNode::NEAR);
+    REQUIRE(near.distances == std::vector<std::uint32_t>({3, 1}));
+    REQUIRE(request.getTermString(near.children[1]) == "fbi");
+    REQUIRE(request.getNode(2).type == SearchRequest::QueryNode::CLAUSE);
+    REQUIRE(request.getNode(3).type == SearchRequest::QueryNode::AND);
+    REQUIRE(SearchRequest("\"unterminated phrase", ":keyword").getNode(0).children.size() == 2);
+    REQUIRE(SearchRequest("NEAR/0 love", ":keyword").getTermCount() == 2);
+
+    std::vector<KeyPosition> positions = {0, 3, 127, 128, 20000, 3000000};
+    std::string encoded;
+    positions::encode(positions, encoded);
+    std::vector<KeyPosition> decoded;
+    positions::decode(encoded, decoded);
+    REQUIRE(decoded == positions);
+    REQUIRE(positions::matchSequence({{1, 5}, {6}, {2, 7}}, {0, 0}));
+    REQUIRE_FALSE(positions::matchSequence({{1, 5}, {6}, {2, 8}}, {0, 0}));
+    REQUIRE(positions::matchSequence({{10}, {7}}, {3}));
+    REQUIRE_FALSE(positions::matchSequence({{10}, {6}}, {3}));
+
+    Indexer indexer;
+    std::vector<std::string> titles = {"masters of deceit", "deceit of masters", "the masters of the deceit",
+                                       "old masters of deceit and lies"};
+    long doc_id = 0;
+    for (auto const &title : titles) {
+        auto doc = std::make_shared<Document>(doc_id++);
+        doc->addKeySequence(":title", split(title));
+        doc->addKey(std::make_shared<StringKey>(doc_id % 2 == 0 ? "even" : "odd", ":parity"));
+        indexer.indexDocument(doc);
+    }
+    // without positions the keywords are all a phrase needs
+    REQUIRE(indexer.search(":title \"masters of deceit\"").size() == 4);
+    indexer.keepPositions(":title");
+    REQUIRE(indexer.keepsPositions(":title"));
+    REQUIRE(indexer.search(":title \"masters of deceit\"").size() == 2);
+    REQUIRE(indexer.search(":title \"of deceit\"").size() == 2);
+    REQUIRE(indexer.search(":title \"of the deceit\"").size() == 1);
+    REQUIRE(indexer.search(":title \"deceit of masters\" OR :title \"masters of the\"").size() == 2);
+    REQUIRE(indexer.search(":title \"masters of deceit\" :parity even").size() == 1);
+    REQUIRE(indexer.search(":title \"masters of deceit\" -lies").size() == 1);
+    REQUIRE(indexer.search(":title masters NEAR/1 deceit").isEmpty());
+    REQUIRE(indexer.search(":title masters NEAR/2 deceit").size() == 3);
+    REQUIRE(indexer.search(":title masters NEAR/3 deceit").size() == 4);
+    REQUIRE(indexer.search(":title old NEAR/1 masters NEAR/4 lies").size() == 1);
+    REQUIRE(indexer.search(":title \"masters of nothing\"").isEmpty());
+
+    // documents indexed after keepPositions() get their positions too
+    auto doc = std::make_shared<Document>(doc_id++);
+    doc->addKeySequence(":title", split("deceit masters of deceit"));
+    indexer.indexDocument(doc);
+    REQUIRE(indexer.search(":title \"masters of deceit\"").size() == 3);
+    indexer.removeDocument(0);
+    REQUIRE(indexer.search(":title \"masters of deceit\"").size() == 2);
+}
+
+TEST_CASE("Indexer columnar properties") {
+    PropertyColumn<int> column(-1);
+    REQUIRE_FALSE(column.hasValue(3));
+    REQUIRE(column.get(3) == -1);
+    column.set(3, 42);
+    column.set(1, 7);
+    REQUIRE(column.getValueCount() == 2);
+    REQUIRE(column.getValues() == std::vector<int>({-1, 7, -1, 42}));
+    REQUIRE(column.getPresence().count() == 2);
+    column.reset(3);
+    column.reset(3);
+    REQUIRE_FALSE(column.hasValue(3));
+    REQUIRE(column.get(3) == -1);
+    REQUIRE(column.getValueCount() == 1);
+
+    Indexer indexer;
+    REQUIRE(indexer.getColumns().findProperty("size") == ColumnStore::NO_PROPERTY);
+    REQUIRE(indexer.getColumns().longColumn(ColumnStore::NO_PROPERTY) == nullptr);
+    for (long i = 0; i < 10; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(std::make_shared<StringKey>(i % 2 == 0 ? "even" : "odd", ":parity"));
+        doc->longProperty("size", i * 1000);
+        doc->stringProperty("title", "title " + std::to_string(i));
+        if (i % 3 == 0) {
+            doc->boolProperty("size", true);
+        }
+        indexer.indexDocument(doc);
+    }
+    ColumnStore const &columns = indexer.getColumns();
+    REQUIRE(columns.getPropertyCount() == 2);
+    PropertyId size = columns.findProperty("size");
+    REQUIRE(columns.getPropertyName(size) == "size");
+    // the same name with different types gets different columns
+    REQUIRE(columns.longColumn(size)->getValueCount() == 10);
+    REQUIRE(columns.boolColumn(size)->getValueCount() == 4);
+    REQUIRE(columns.intColumn(size)->getValueCount() == 0);
+    DocOrdinal ordinal;
+    REQUIRE(indexer.findOrdinal(7, ordinal));
+    REQUIRE(columns.longColumn(size)->get(ordinal) == 7000);
+    REQUIRE_FALSE(columns.boolColumn(size)->get(ordinal));
+    REQUIRE(columns.stringColumn(columns.findProperty("title"))->get(ordinal) == "title 7");
+
+    long total = 0;
+    for (long value : columns.longColumn(size)->getValues()) {
+        total += value;
+    }
+    REQUIRE(total == 45000);
+
+    // removed documents read as nulls, indexing a document again replaces its values
+    indexer.removeDocument(7);
+    REQUIRE_FALSE(indexer.findOrdinal(7, ordinal));
+    REQUIRE(columns.longColumn(size)->getValueCount() == 9);
+    auto doc = std::make_shared<Document>(3);
+    doc->addKey(std::make_shared<StringKey>("odd", ":parity"));
+    doc->longProperty("size", 1);
+    indexer.indexDocument(doc);
+    REQUIRE(indexer.findOrdinal(3, ordinal));
+    REQUIRE(columns.longColumn(size)->get(ordinal) == 1);
+    REQUIRE_FALSE(columns.boolColumn(size)->hasValue(ordinal));
+    REQUIRE_FALSE(columns.stringColumn(columns.findProperty("title"))->hasValue(ordinal));
+    REQUIRE(indexer.findDocumentsContaining("title", "TITLE").size() == 8);
+    REQUIRE(indexer.search(":parity odd", "title", 0).size() == 4);
+
+    // removing a document resets the values it had, of every type, and their bitmaps
+    ColumnStore store;
+    Document flags(1);
+    flags.boolProperty("seen", true);
+    flags.byteProperty("seen", 'b');
+    flags.byteProperty("kind", 'a');
+    store.putDocument(5, flags);
+    Document other(2);
+    other.byteProperty("kind", 'a');
+    store.putDocument(6, other);
+    PropertyId seen = store.findProperty("seen");
+    PropertyId kind = store.findProperty("kind");
+    REQUIRE(store.trueBitmap(seen)->test(5));
+    REQUIRE(store.byteValueBitmap(kind, 'a')->count() == 2);
+    store.removeDocument(5);
+    store.removeDocument(5);
+    store.removeDocument(100);
+    REQUIRE_FALSE(store.trueBitmap(seen)->test(5));
+    REQUIRE_FALSE(store.boolColumn(seen)->hasValue(5));
+    REQUIRE_FALSE(store.byteColumn(seen)->hasValue(5));
+    REQUIRE(store.byteValueBitmap(seen, 'b')->count() == 0);
+    REQUIRE(store.byteValueBitmap(kind, 'a')->count() == 1);
+    REQUIRE(store.byteColumn(kind)->getValueCount() == 1);
+
+    // property ids are the store's own, however many names the process has interned
+    for (int i = 0; i < 100; i++) {
+        PropertyNames::intern("elsewhere_" + std::to_string(i));
+    }
+    ColumnStore small;
+    Document single(3);
+    single.longProperty("elsewhere_99", 1);
+    small.putDocument(0, single);
+    REQUIRE(small.getPropertyCount() == 1);
+    REQUIRE(small.findProperty("elsewhere_99") == 0);
+    REQUIRE(small.getPropertyName(0) == "elsewhere_99");
+    REQUIRE(small.findProperty("elsewhere_98") == ColumnStore::NO_PROPERTY);
+    REQUIRE(small.longColumn(1) == nullptr);
+
+    indexer.clear();
+    REQUIRE(columns.getPropertyCount() == 0);
+}
+
+TEST_CASE("Indexer document handles") {
+    Indexer indexer;
+    auto sp_doc = std::make_shared<Document>("shared");
+    sp_doc->addKey(StringKey("love", ":title"));
+    indexer.indexDocument(sp_doc);
+    REQUIRE(indexer.findDocument("shared") == sp_doc);
+    REQUIRE(indexer.findDocument(sp_doc->getId()) == sp_doc);
+    REQUIRE(indexer.findDocument("missing") == nullptr);
+    REQUIRE(indexer.getDocument("missing") == Document::NULL_DOCUMENT);
+
+    Document doc(7);
+    doc.addKey(StringKey("love", ":title"));
+    doc.stringProperty("title", "love is all you need");
+    indexer.indexDocument(std::move(doc));
+    SPDocument handle = indexer.findDocument(7);
+    REQUIRE(handle != nullptr);
+    REQUIRE(handle == indexer.findDocument(7));
+    REQUIRE(handle->stringProperty("title") == "love is all you need");
+    REQUIRE(indexer.search(":title love").size() == 2);
+
+    // the const& overload copies, later changes to the original don't reach the indexer
+    Document copied(8);
+    copied.addKey(StringKey("hate", ":title"));
+    copied.stringProperty("title", "original");
+    indexer.indexDocument(copied);
+    copied.stringProperty("title", "changed");
+    REQUIRE(indexer.findDocument(8)->stringProperty("title") == "original");
+
+    REQUIRE(indexer.removeDocument(copied));
+    REQUIRE_FALSE(indexer.removeDocument(copied));
+    REQUIRE(indexer.removeDocument(7));
+    REQUIRE_FALSE(indexer.removeDocument(7));
+    REQUIRE(indexer.findDocument(7) == nullptr);
+    // a handle outlives the document's removal
+    REQUIRE(handle->getId() == 7);
+    REQUIRE(indexer.search(":title love").size() == 1);
+}
+
+TEST_CASE("Indexer re-indexing a document") {
+    Indexer indexer;
+    Document first_version(1);
+    first_version.addKey(StringKey("alpha", ":title"));
+    first_version.addKey(StringKey("beta", ":title"));
+    indexer.indexDocument(first_version);
+    Document second_version(1);
+    second_version.addKey(StringKey("alpha", ":title"));
+    indexer.indexDocument(second_version);
+    // the keys the new version dropped don't match it anymore
+    REQUIRE(indexer.search(":title alpha").size() == 1);
+    REQUIRE(indexer.search(":title beta").isEmpty());
+
+    // nor the document that gets its ordinal next
+    REQUIRE(indexer.removeDocument(1));
+    Document other(2);
+    other.addKey(StringKey("gamma", ":title"));
+    indexer.indexDocument(other);
+    REQUIRE(indexer.search(":title beta").isEmpty());
+    REQUIRE(indexer.search(":title alpha").isEmpty());
+    REQUIRE(indexer.search(":title gamma").size() == 1);
+}
+
+TEST_CASE("Indexer numeric ranges") {
+    SearchRequest request(":file_size [1000000 TO 5000000] :year >= 1970 -< 5", ":keyword");
+    REQUIRE(request.getTermCount() == 3);
+    REQUIRE(request.getTermString(0) == "[1000000 TO 5000000]");
+    REQUIRE(request.getTerm(0).type == SearchRequest::RANGE);
+    REQUIRE(request.getTermString(1) == ">= 1970");
+    REQUIRE(request.getTerm(1).type == SearchRequest::RANGE);
+    REQUIRE(request.getTerm(2).occur == SearchRequest::MUST_NOT);
+    REQUIRE(request.getTermString(2) == "< 5");
+    SearchRequest::Range range;
+    REQUIRE(SearchRequest::parseRange("{10 TO *]", range));
+    REQUIRE(range.lower == "10");
+    REQUIRE_FALSE(range.include_lower);
+    REQUIRE(range.upper.isEmpty());
+    REQUIRE(SearchRequest::parseRange("<= -3", range));
+    REQUIRE(range.upper == "-3");
+    REQUIRE(range.include_upper);
+    REQUIRE_FALSE(SearchRequest::parseRange("[10 20]", range));
+    REQUIRE_FALSE(SearchRequest::parseRange(">", range));
+
+    long value = 0;
+    REQUIRE(NumericIndex::parseLong("-9223372036854775808", value));
+    REQUIRE(value == std::numeric_limits<long>::min());
+    REQUIRE_FALSE(NumericIndex::parseLong("9223372036854775808", value));
+    REQUIRE_FALSE(NumericIndex::parseLong("12a", value));
+
+    NumericIndex numeric_index("year");
+    numeric_index.putDocument(0, 1980);
+    numeric_index.putDocument(1, 1960);
+    numeric_index.putDocument(2, 1970);
+    REQUIRE(numeric_index.findRange(1960, 1970) == std::vector<DocOrdinal>({1, 2}));
+    numeric_index.putDocument(1, 1975);
+    numeric_index.putDocument(3, 1970);
+    numeric_index.removeDocument(2);
+    numeric_index.putDocument(2, 1970);
+    numeric_index.removeDocument(0);
+    REQUIRE(numeric_index.findRange(1970, 1980) == std::vector<DocOrdinal>({1, 2, 3}));
+    REQUIRE(numeric_index.countRange(1971, 2000) == 1);
+    REQUIRE(numeric_index.getDocumentCount() == 3);
+
+    Indexer indexer;
+    indexer.setResultCacheCapacity(10);
+    for (long i = 0; i < 100; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey(i % 2 == 0 ? "even" : "odd", ":parity"));
+        doc->longProperty("file_size", i * 100000);
+        if (i % 10 == 0) {
+            doc->intProperty("year", 1900 + static_cast<int>(i));
+        }
+        indexer.indexDocument(doc);
+    }
+    // ranges need a numeric index
+    REQUIRE(indexer.search(":file_size [1000000 TO 5000000]").isEmpty());
+    indexer.addNumericIndex("file_size");
+    indexer.addNumericIndex("year");
+    REQUIRE(indexer.hasNumericIndex("year"));
+    REQUIRE(indexer.search(":file_size [1000000 TO 5000000]").size() == 41);
+    REQUIRE(indexer.search(":file_size {1000000 TO 5000000}").size() == 39);
+    REQUIRE(indexer.search(":file_size [1000000 TO 5000000] :parity odd").size() == 20);
+    REQUIRE(indexer.search(":year >= 1970").size() == 3);
+    REQUIRE(indexer.search(":year > 1970").size() == 2);
+    REQUIRE(indexer.search(":year [* TO 1920}").size() == 2);
+    REQUIRE(indexer.search(":year < 1950 OR :year > 1980").size() == 6);
+    REQUIRE(indexer.search(":parity even :year -[1920 TO 1990]").size() == 42);
+    REQUIRE(indexer.search(":year >= nineteen").isEmpty());
+    REQUIRE(indexer.search(":file_size >= 9900000").size() == 1);
+
+    // the index follows the documents
+    auto doc = std::make_shared<Document>(99);
+    doc->addKey(StringKey("odd", ":parity"));
+    doc->longProperty("file_size", 1);
+    indexer.indexDocument(doc);
+    REQUIRE(indexer.search(":file_size >= 9900000").isEmpty());
+    REQUIRE(indexer.search(":file_size <= 1").size() == 2);
+    indexer.removeDocument(0);
+    REQUIRE(indexer.search(":file_size <= 1").size() == 1);
+    REQUIRE(indexer.search(":year [1900 TO 1990]").size() == 9);
+    indexer.removeNumericIndex("year");
+    REQUIRE(indexer.search(":year [1900 TO 1990]").isEmpty());
+
+    // copies and moves take the numeric indices and the cached results along, each with its own locks
+    static_assert(std::is_copy_constructible<Indexer>::value && std::is_move_constructible<Indexer>::value,
+                  "an Indexer can be copied and moved");
+    Indexer copy(indexer);
+    REQUIRE(copy.search(":file_size <= 1").size() == 1);
+    unsigned long hits = copy.getResultCache().getHits();
+    Indexer moved(std::move(copy));
+    REQUIRE(moved.search(":file_size <= 1").size() == 1);
+    REQUIRE(moved.getResultCache().getHits() == hits + 1);
+    REQUIRE(moved.search(":file_size [1000000 TO 5000000]").size() == 41);
+}
+
+TEST_CASE("Indexer term ranges") {
+    Indexer indexer;
+    for (long i = 0; i < 60; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey(std::to_string(1950 + i), ":year"));
+        std::string month = (i % 12 < 9 ? "0" : "") + std::to_string(i % 12 + 1);
+        doc->addKey(StringKey("2018-" + month + "-15", ":date"));
+        doc->addKey(StringKey(i % 2 == 0 ? "even" : "odd", ":parity"));
+        indexer.indexDocument(doc);
+    }
+    REQUIRE(indexer.search(":year [1970 TO 1980]").size() == 11);
+    REQUIRE(indexer.search(":year {1970 TO 1980}").size() == 9);
+    REQUIRE(indexer.search(":year [1970 TO 1980] :parity odd").size() == 5);
+    REQUIRE(indexer.search(":year >= 2000").size() == 10);
+    REQUIRE(indexer.search(":year < 1955").size() == 5);
+    REQUIRE(indexer.search(":year [* TO *]").size() == 60);
+    REQUIRE(indexer.search(":year [1980 TO 1970]").isEmpty());
+    REQUIRE(indexer.search(":date [2018-01-01 TO 2018-03-31]").size() == 15);
+    REQUIRE(indexer.search(":parity even :date -[2018-02-01 TO 2018-12-31]").size() == 5);
+    REQUIRE(indexer.search(":nothing [a TO z]").isEmpty());
+
+    // with a numeric index the group's property is compared as numbers instead
+    for (long i = 0; i < 3; i++) {
+        auto doc = std::make_shared<Document>(100 + i);
+        doc->addKey(StringKey("?", ":year"));
+        doc->longProperty("year", i == 0 ? 99 : 1975);
+        indexer.indexDocument(doc);
+    }
+    REQUIRE(indexer.search(":year [1970 TO 1980]").size() == 11);
+    indexer.addNumericIndex("year");
+    REQUIRE(indexer.search(":year [1970 TO 1980]").size() == 2);
+    REQUIRE(indexer.search(":year < 1000").size() == 1);
+}
+
+TEST_CASE("Indexer sort by property") {
+    SortBy sort_by = SortBy::parse(" file_size  desc ");
+    REQUIRE(sort_by.property == "file_size");
+    REQUIRE(sort_by.descending);
+    REQUIRE_FALSE(SortBy::parse("year").descending);
+    REQUIRE(SortBy::parse("").property.empty());
+
+    Indexer indexer;
+    indexer.setResultCacheCapacity(10);
+    for (long i = 0; i < 500; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey(i % 2 == 0 ? "even" : "odd", ":parity"));
+        doc->addKey(StringKey(i % 5 == 0 ? "five" : "other", ":fives"));
+        if (i % 100 != 7) {
+            // 5 documents have no size
+            doc->longProperty("file_size", (i * 7919) % 1000);
+        }
+        doc->stringProperty("name", "file " + std::to_string(1000 - i));
+        indexer.indexDocument(doc);
+    }
+
+    auto check_order = [](yuca::utils::List<SearchResult> const &results, bool descending) {
+        for (unsigned long i = 1; i < results.size(); i++) {
+            long previous = results.get(i - 1).document_sp->longProperty("file_size");
+            long current = results.get(i).document_sp->longProperty("file_size");
+            REQUIRE((descending ? previous >= current : previous <= current));
+        }
+    };
+
+    for (int with_index = 0; with_index < 2; with_index++) {
+        if (with_index == 1) {
+            indexer.addNumericIndex("file_size");
+        }
+        auto largest = indexer.search(":parity even", "", 10, "file_size desc");
+        REQUIRE(largest.size() == 10);
+        check_order(largest, true);
+        REQUIRE(largest.get(0).document_sp->longProperty("file_size") == 996);
+        auto smallest = indexer.search(":parity odd :fives five", "", 7, "file_size asc");
+        REQUIRE(smallest.size() == 7);
+        check_order(smallest, false);
+        for (auto const &result : smallest.getStdVector()) {
+            REQUIRE(result.document_sp->getId() % 10 == 5);
+            REQUIRE(result.score == 2);
+        }
+        // documents without a size come last
+        auto all = indexer.search(":parity odd", "", 0, "file_size");
+        REQUIRE(all.size() == 250);
+        check_order(all.subList(0, 245), false);
+        REQUIRE(all.get(249).document_sp->getId() % 100 == 7);
+        // not enough matches with a size, the whole query is evaluated
+        auto few = indexer.search(":parity odd :fives five", "", 100, "file_size desc");
+        REQUIRE(few.size() == 50);
+        check_order(few, true);
+        // same results as sorting everything
+        auto top = indexer.search(":fives five -odd", "", 20, "file_size desc");
+        auto everything = indexer.search(":fives five -odd", "", 0, "file_size desc");
+        for (unsigned long i = 0; i < top.size(); i++) {
+            REQUIRE(top.get(i).document_sp->getId() == everything.get(i).document_sp->getId());
+        }
+    }
+    auto by_name = indexer.search(":fives five", "", 3, "name");
+    REQUIRE(by_name.get(0).document_sp->stringProperty("name") == "file 1000");
+    REQUIRE(by_name.get(1).document_sp->stringProperty("name") == "file 505");
+    REQUIRE(indexer.search(":fives five", "", 3, "nothing").size() == 3);
+    // ranking by score is unchanged
+    REQUIRE(indexer.search(":parity even", "", 5, "").size() == 5);
+}
+
+TEST_CASE("Indexer bitset property filters") {
+    SearchRequest request("@top_secret=false :parity odd @ @x=", ":keyword");
+    REQUIRE(request.getFilterCount() == 1);
+    REQUIRE(request.getFilterProperty(0) == "top_secret");
+    REQUIRE(request.getFilterValue(0) == "false");
+    REQUIRE(request.getKeywords(":parity").size() == 3);
+    REQUIRE(SearchRequest("@top_secret=true", ":keyword").hasQuery());
+
+    Indexer indexer;
+    indexer.setResultCacheCapacity(10);
+    for (long i = 0; i < 600; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey(i % 2 == 0 ? "even" : "odd", ":parity"));
+        if (i % 50 != 49) {
+            // 12 documents are neither secret nor not
+            doc->boolProperty("top_secret", i % 3 == 0);
+        }
+        doc->byteProperty("rating", static_cast<char>(i % 5));
+        doc->byteProperty("grade", static_cast<char>('A' + i % 4));
+        indexer.indexDocument(doc);
+    }
+
+    REQUIRE(indexer.search("@top_secret=false").size() == 392);
+    REQUIRE(indexer.search("@top_secret=true").size() == 196);
+    REQUIRE(indexer.search(":parity even @top_secret=true").size() == 100);
+    REQUIRE(indexer.search(":parity odd @top_secret=false @rating=4").size() == 32);
+    auto graded = indexer.search(":parity odd @top_secret=false @rating=4 @grade=B");
+    REQUIRE(graded.size() == 16);
+    for (auto const &result : graded.getStdVector()) {
+        REQUIRE(result.document_sp->getId() % 20 == 9);
+        REQUIRE_FALSE(result.document_sp->boolProperty("top_secret"));
+    }
+    REQUIRE(indexer.search("@rating=2").size() == 120);
+    // filters apply to the whole query
+    REQUIRE(indexer.search("(:parity even OR :parity odd) @rating=2").size() == 120);
+    REQUIRE(indexer.search(":parity odd @rating=9").size() == 0);
+    REQUIRE(indexer.search(":parity odd @nothing=true").size() == 0);
+    REQUIRE(indexer.search(":parity odd @grade=true").size() == 0);
+
+    // the bitsets follow the documents, and cached results along with them
+    indexer.removeDocument(2l);
+    REQUIRE(indexer.search("@rating=2").size() == 119);
+    auto doc = std::make_shared<Document>(0l);
+    doc->addKey(StringKey("even", ":parity"));
+    doc->boolProperty("top_secret", false);
+    indexer.indexDocument(doc);
+    REQUIRE(indexer.search("@top_secret=true").size() == 195);
+    REQUIRE(indexer.search("@rating=0").size() == 119);
+
+    SearchSession session;
+    REQUIRE(indexer.search(session, "@top_secret=false :parity od", "", 0).size() == 192);
+    REQUIRE(indexer.search(session, "@top_secret=false :parity odd", "", 0).size() == 192);
+    REQUIRE(session.getIncrementalSearches() == 1);
+    REQUIRE(indexer.search(session, "@top_secret=true :parity odd", "", 0).size() == 96);
+    REQUIRE(session.getIncrementalSearches() == 1);
+}
+
+TEST_CASE("Indexer facets") {
+    Indexer indexer;
+    for (long i = 0; i < 400; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey(i % 2 == 0 ? "even" : "odd", ":parity"));
+        doc->addKey(StringKey(i % 10 < 5 ? "pdf" : (i % 10 < 8 ? "epub" : "mobi"), ":extension"));
+        doc->addKey(StringKey("author " + std::to_string(i % 300), ":author"));
+        indexer.indexDocument(doc);
+    }
+    List<std::string> facet_groups;
+    facet_groups.add(":extension");
+    facet_groups.add(":author");
+    facet_groups.add(":nothing");
+
+    List<Facet> facets;
+    auto results = indexer.search(":parity even", "", 5, facet_groups, 2, facets);
+    REQUIRE(results.size() == 5);
+    REQUIRE(facets.size() == 3);
+    Facet extension = facets.get(0);
+    REQUIRE(extension.group == ":extension");
+    REQUIRE(extension.counts.size() == 2);
+    REQUIRE(extension.counts.get(0).keyword == "pdf");
+    REQUIRE(extension.counts.get(0).document_count == 120);
+    // epub and mobi are tied, string order
+    REQUIRE(extension.counts.get(1).keyword == "epub");
+    REQUIRE(extension.counts.get(1).document_count == 40);
+    REQUIRE(facets.get(2).counts.isEmpty());
+
+    // 300 authors, counted from their postings and then from the FacetIndex
+    auto all_authors = [&indexer, &facet_groups]() {
+        List<Facet> author_facets;
+        indexer.search(":parity even", "", 0, facet_groups, 0, author_facets);
+        return author_facets.get(1).counts;
+    };
+    List<FacetCount> from_postings = all_authors();
+    REQUIRE(from_postings.size() == 150);
+    REQUIRE(from_postings.get(0).keyword == "author 0");
+    REQUIRE(from_postings.get(0).document_count == 2);
+    REQUIRE(from_postings.get(1).keyword == "author 10");
+    REQUIRE(from_postings.get(50).document_count == 1);
+    indexer.addFacetIndex(":author");
+    REQUIRE(indexer.hasFacetIndex(":author"));
+    List<FacetCount> from_facet_index = all_authors();
+    REQUIRE(from_facet_index.getStdVector() == from_postings.getStdVector());
+    indexer.search(":parity even", "", 0, facet_groups, 3, facets);
+    REQUIRE(facets.get(1).counts.size() == 3);
+    REQUIRE(facets.get(1).counts.get(2).keyword == "author 12");
+
+    // the facets follow the documents
+    indexer.removeDocument(0l);
+    indexer.removeDocument(10l);
+    indexer.search(":parity even", "", 0, facet_groups, 1, facets);
+    REQUIRE(facets.get(0).counts.get(0).document_count == 118);
+    REQUIRE(facets.get(1).counts.get(0).keyword == "author 12");
+    indexer.removeFacetIndex(":author");
+    REQUIRE_FALSE(indexer.hasFacetIndex(":author"));
+    REQUIRE(indexer.search(":parity none", "", 0, facet_groups, 1, facets).isEmpty());
+    REQUIRE(facets.get(0).counts.isEmpty());
+}
+
+TEST_CASE("Indexer numeric aggregations") {
+    TDigest digest;
+    REQUIRE(digest.quantile(0.5) == 0);
+    for (long i = 0; i < 100000; i++) {
+        digest.add(static_cast<double>((i * 7919) % 100000));
+    }
+    REQUIRE(digest.getCount() == 100000);
+    REQUIRE(digest.quantile(0) == 0);
+    REQUIRE(digest.quantile(1) == 99999);
+    REQUIRE(std::abs(digest.quantile(0.5) - 50000) < 500);
+    REQUIRE(std::abs(digest.quantile(0.99) - 99000) < 100);
+    REQUIRE(std::abs(digest.quantile(0.001) - 100) < 20);
+    // reads leave buffered values alone, they're merged on a copy
+    TDigest buffered;
+    for (long i = 1; i <= 9; i++) {
+        buffered.add(static_cast<double>(i));
+    }
+    double median = buffered.quantile(0.5);
+    REQUIRE(median == 5);
+    buffered.flush();
+    REQUIRE(buffered.quantile(0.5) == median);
+
+    Indexer indexer;
+    for (long i = 0; i < 1000; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey(i % 4 == 0 ? "pdf" : "mp3", ":extension"));
+        if (i % 100 == 0) {
+            doc->intProperty("file_size", static_cast<int>(i));
+        } else if (i % 100 != 4) {
+            // 10 pdfs have no size
+            doc->longProperty("file_size", i);
+        }
+        doc->intProperty("delta", static_cast<int>(i - 500));
+        indexer.indexDocument(doc);
+    }
+    List<std::string> properties;
+    properties.add("file_size");
+    properties.add("delta");
+    properties.add("nothing");
+    auto aggregations = indexer.aggregate(":extension pdf", properties, 250);
+    REQUIRE(aggregations.size() == 3);
+    NumericAggregation file_size = aggregations.get(0);
+    REQUIRE(file_size.property == "file_size");
+    REQUIRE(file_size.count == 240);
+    REQUIRE(file_size.min == 0);
+    REQUIRE(file_size.max == 996);
+    REQUIRE(file_size.sum == 119960);
+    REQUIRE(std::abs(file_size.average - 119960.0 / 240) < 0.001);
+    REQUIRE(file_size.histogram.size() == 4);
+    for (unsigned long b = 0; b < 4; b++) {
+        REQUIRE(file_size.histogram.get(b).lower == static_cast<long>(b * 250));
+        REQUIRE(file_size.histogram.get(b).document_count == 60);
+    }
+    REQUIRE(file_size.percentile(0) == 0);
+    REQUIRE(file_size.percentile(100) == 996);
+    REQUIRE(std::abs(file_size.percentile(50) - 500) < 15);
+
+    // buckets of negative values round down
+    NumericAggregation delta = aggregations.get(1);
+    REQUIRE(delta.count == 250);
+    REQUIRE(delta.min == -500);
+    REQUIRE(delta.histogram.size() == 4);
+    REQUIRE(delta.histogram.get(0).lower == -500);
+    REQUIRE(delta.histogram.get(1).lower == -250);
+    REQUIRE(delta.histogram.get(1).document_count == 62);
+
+    REQUIRE(aggregations.indexOf(delta) == 1);
+    REQUIRE(delta.histogram.contains(HistogramBucket{-250, 62}));
+    REQUIRE(aggregations.get(2).count == 0);
+    REQUIRE(aggregations.get(2).histogram.isEmpty());
+    auto none = indexer.aggregate(":extension avi", properties, 0);
+    REQUIRE(none.get(0).count == 0);
+    REQUIRE(indexer.aggregate(":extension mp3", properties, 0).get(0).histogram.isEmpty());
+    REQUIRE(indexer.aggregate(":extension mp3", properties, 0).get(0).count == 750);
+
+    // sums past the long range saturate, the lowest bucket starts at the lowest long
+    Indexer extremes;
+    long const values[] = {std::numeric_limits<long>::max(), std::numeric_limits<long>::max(), -1,
+                           std::numeric_limits<long>::min(), std::numeric_limits<long>::min(),
+                           std::numeric_limits<long>::min()};
+    for (long i = 0; i < 6; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey(i < 3 ? "high" : "low", ":range"));
+        doc->addKey(StringKey("any", ":all"));
+        doc->longProperty("value", values[i]);
+        extremes.indexDocument(doc);
+    }
+    List<std::string> value_property;
+    value_property.add("value");
+    NumericAggregation high = extremes.aggregate(":range high", value_property, 1000).get(0);
+    REQUIRE(high.sum == std::numeric_limits<long>::max());
+    REQUIRE(high.average > 6e18);
+    NumericAggregation low = extremes.aggregate(":range low", value_property, 1000).get(0);
+    REQUIRE(low.sum == std::numeric_limits<long>::min());
+    REQUIRE(low.histogram.size() == 1);
+    REQUIRE(low.histogram.get(0).lower == std::numeric_limits<long>::min());
+    REQUIRE(low.histogram.get(0).document_count == 3);
+    NumericAggregation all = extremes.aggregate(":all any", value_property, 0).get(0);
+    REQUIRE(all.sum == std::numeric_limits<long>::min());
+    REQUIRE(all.min == std::numeric_limits<long>::min());
+    REQUIRE(all.max == std::numeric_limits<long>::max());
+    NumericAggregation spread = extremes.aggregate(":all any", value_property, 1).get(0);
+    REQUIRE(spread.histogram.size() == 3);
+    REQUIRE(spread.histogram.get(1) == HistogramBucket({-1, 1}));
+    REQUIRE(spread.histogram.get(2) == HistogramBucket({std::numeric_limits<long>::max(), 2}));
+
+    // only the final sum saturates, it can leave the long range in between and come back exactly
+    Indexer round_trip;
+    long const steps[] = {std::numeric_limits<long>::max(), 1, -10, std::numeric_limits<long>::max(), 3,
+                          std::numeric_limits<long>::min() + 7, -1};
+    for (long i = 0; i < 7; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey(i < 3 ? "first" : "second", ":part"));
+        doc->longProperty("value", steps[i]);
+        round_trip.indexDocument(doc);
+    }
+    REQUIRE(round_trip.aggregate(":part first", value_property, 0).get(0).sum == std::numeric_limits<long>::max() - 9);
+    REQUIRE(round_trip.aggregate(":part second", value_property, 0).get(0).sum == 8);
+}
+
+TEST_CASE("Indexer result collapsing") {
+    Indexer indexer;
+    for (long i = 0; i < 300; i++) {
+        auto doc = std::make_shared<Document>(i);
+        doc->addKey(StringKey("common", ":keyword"));
+        if (i % 3 == 0) {
+            doc->addKey(StringKey("rare", ":keyword"));
+        }
+        doc->addKey(StringKey("author " + std::to_string(i % 7), ":author"));
+        if (i % 100 != 99) {
+            doc->stringProperty("info_hash", "hash " + std::to_string(i % 50));
+        }
+        doc->longProperty("file_size", i);
+        indexer.indexDocument(doc);
+    }
+    auto ids = [](yuca::utils::List<SearchResult> const &results) {
+        std::vector<long> result_ids;
+        for (auto const &result : results.getStdVector()) {
+            result_ids.push_back(result.document_sp->getId());
+        }
+        return result_ids;
+    };
+
+    // by score, the authors whose best result comes first
+    auto by_author = indexer.search("common rare", "", 3, "", ":author", 2);
+    REQUIRE(ids(by_author) == std::vector<long>({0, 21, 3, 24, 6, 27}));
+    REQUIRE(by_author.get(0).score == 2);
+
+    // by property, documents without an info_hash stand alone
+    auto by_hash = indexer.search("common", "", 5, "file_size desc", "info_hash", 1);
+    REQUIRE(ids(by_hash) == std::vector<long>({299, 298, 297, 296, 295}));
+    by_hash = indexer.search("common", "", 2, "file_size desc", "info_hash", 2);
+    REQUIRE(ids(by_hash) == std::vector<long>({299, 298, 248}));
+
+    // one group per author, every result of each
+    REQUIRE(indexer.search("common", "", 0, "", ":author", 1000).size() == 300);
+    REQUIRE(indexer.search("common", "", 0, "", ":author", 1).size() == 7);
+    // nothing to collapse by, the same as not collapsing
+    REQUIRE(ids(indexer.search("common", "", 4, "file_size", "nothing", 1)) == std::vector<long>({0, 1, 2, 3}));
+    REQUIRE(ids(indexer.search("common", "", 4, "file_size", "", 1)) == std::vector<long>({0, 1, 2, 3}));
+
+    // sorting, collapsing and facets combine
+    SearchOptions options;
+    options.max_results = 3;
+    options.sort_by = "file_size desc";
+    options.collapse_by = ":author";
+    options.max_per_group = 2;
+    options.facet_groups.add(":author");
+    List<Facet> facets;
+    std::vector<long> largest_by_author = {297, 276, 294, 273, 291, 270};
+    REQUIRE(ids(indexer.search("rare", options, facets)) == largest_by_author);
+    REQUIRE(facets.size() == 1);
+    REQUIRE(facets.contains(facets.get(0)));
+    REQUIRE(facets.get(0).counts.size() == 7);
+    REQUIRE(facets.get(0).counts.get(0).document_count == 15);
+
+    // collapsed searches are cached, by their collapse options too
+    indexer.setResultCacheCapacity(10);
+    options.facet_groups.clear();
+    REQUIRE(ids(indexer.search("rare", options)) == largest_by_author);
+    REQUIRE(ids(indexer.search("rare", options)) == largest_by_author);
+    REQUIRE(indexer.getResultCache().getHits() == 1);
+    options.max_per_group = 1;
+    REQUIRE(ids(indexer.search("rare", options)) == std::vector<long>({297, 294, 291}));
+    REQUIRE(indexer.getResultCache().getHits() == 1);
+
+    // a numeric index finds the first values without evaluating every match, the results are the same
+    indexer.addNumericIndex("file_size");
+    options.max_per_group = 2;
+    REQUIRE(ids(indexer.search("rare", options)) == largest_by_author);
+    REQUIRE(ids(indexer.search("common", "", 2, "file_size desc", "info_hash", 2)) ==
+            std::vector<long>({299, 298, 248}));
+    REQUIRE(ids(indexer.search("common", "", 5, "file_size asc", ":author", 3)).size() == 15);
+}
+
 /** generates a random integer in the interval [0,maxInclusive] */
 struct file {
     std::string title;
@@ -411,6 +411,57 @@ TEST_CASE("yuca:utils static functions") {
         REQUIRE(list.get(3) == "four");
     }
 
+    SECTION("yuca::utils SmallVector") {
+        yuca::utils::SmallVector<int, 2> v;
+        REQUIRE(v.isEmpty());
+        v.add(1);
+        v.add(2);
+        yuca::utils::SmallVector<int, 2> inline_copy(v);
+        v.add(3); // spills to the heap
+        REQUIRE(v.size() == 3);
+        REQUIRE(v[0] == 1);
+        REQUIRE(v[1] == 2);
+        REQUIRE(v[2] == 3);
+        REQUIRE(inline_copy.size() == 2);
+        int sum = 0;
+        for (int i : v) {
+            sum += i;
+        }
+        REQUIRE(sum == 6);
+        v.clear();
+        REQUIRE(v.size() == 0);
+    }
+
+    SECTION("yuca::utils StringView") {
+        std::string str("masters of deceit");
+        yuca::utils::StringView view(str);
+        REQUIRE(view.size() == str.size());
+        REQUIRE(view == "masters of deceit");
+        REQUIRE(view.subView(0, 7) == "masters");
+        REQUIRE(view.subView(11, 100) == "deceit");
+        REQUIRE(view.subView(100, 1).isEmpty());
+        REQUIRE(view.startsWith("master"));
+        REQUIRE(!view.startsWith("of"));
+        REQUIRE(yuca::utils::StringView("abc") < yuca::utils::StringView("abd"));
+        REQUIRE(yuca::utils::StringView("ab") < yuca::utils::StringView("abc"));
+        REQUIRE(view.subView(8, 2).toString() == "of");
+        REQUIRE(yuca::utils::StringView().isEmpty());
+    }
+
+    SECTION("yuca::utils hash64, hashKey") {
+        // values must never change between builds, key ids depend on them
+        REQUIRE(yuca::utils::hash64("") == 0x545f23ddcfe838c4ull);
+        REQUIRE(yuca::utils::hash64("yuca") == 0xaed2ca7dca4b752dull);
+        REQUIRE(yuca::utils::hash64("masters of deceit: the story of communism in america and how to fight it") ==
+                0xf27ef86256c6127cull);
+        REQUIRE(yuca::utils::hashKey(":keyword", "masters") == 0x9093a63f5b715d8bull);
+
+        REQUIRE(yuca::utils::hash64("yuca", 1) != yuca::utils::hash64("yuca", 2));
+        // group and term are hashed separately, not concatenated
+        REQUIRE(yuca::utils::hashKey(":ab", "c") != yuca::utils::hashKey(":a", "bc"));
+        REQUIRE(StringKey("masters", ":keyword").getId() == static_cast<long>(0x9093a63f5b715d8bull));
+    }
+
     SECTION("yuca::utils levenshtein distance") {
         REQUIRE(yuca::utils::levenshteinDistance("aaa", "aaa") == 0);
         REQUIRE(yuca::utils::levenshteinDistance("sol", "sal") == 1);
@@ -418,4 +469,16 @@ TEST_CASE("yuca:utils static functions") {
         REQUIRE(yuca::utils::levenshteinDistance("lawn", "fawl") == 2);
     }
 
+    SECTION("yuca::utils wildcardMatch") {
+        REQUIRE(yuca::utils::wildcardMatch("comm*", "communism"));
+        REQUIRE(yuca::utils::wildcardMatch("*ism", "communism"));
+        REQUIRE(yuca::utils::wildcardMatch("c*m*m", "communism"));
+        REQUIRE(yuca::utils::wildcardMatch("mp?", "mp4"));
+        REQUIRE(yuca::utils::wildcardMatch("*", ""));
+        REQUIRE(yuca::utils::wildcardMatch("a**b", "ab"));
+        REQUIRE(!yuca::utils::wildcardMatch("mp?", "mp"));
+        REQUIRE(!yuca::utils::wildcardMatch("c*m*x", "communism"));
+        REQUIRE(!yuca::utils::wildcardMatch("comm", "communism"));
+    }
+
 }